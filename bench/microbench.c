@@ -0,0 +1,383 @@
+/*
+ * Microbenchmarks dos kernels (make bench).
+ *
+ * Mede cada kernel isolado, sem o laço do sim: para cada lado de grade ×
+ * densidade de agentes × número de threads, monta partição, sub-grade,
+ * halos e pool, e roda cada kernel W vezes de aquecimento e R vezes
+ * medidas. Cada repetição começa numa barreira e vale o tempo do rank
+ * mais lento. Kernels que alteram o estado (decisão, migração) partem
+ * de uma cópia restaurada fora da medição, então todas as repetições
+ * medem o mesmo trabalho. Saída em JSON: mediana, MAD (desvio absoluto
+ * mediano), mínimo e custo por unidade (célula ou agente por rank).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include <omp.h>
+
+#include "types.h"
+#include "agent.h"
+#include "arena.h"
+#include "config.h"
+#include "grid.h"
+#include "halo.h"
+#include "metrics.h"
+#include "migrate.h"
+#include "pack.h"
+#include "partition.h"
+#include "pool.h"
+#include "rng.h"
+#include "season.h"
+#include "tui.h"
+#include "workload.h"
+
+#define MAX_LIST    16
+#define WARM_CYCLES 20   /* regenerações antes da cópia inicial */
+
+typedef struct {
+    int    sizes[MAX_LIST];      int nsizes;
+    double densities[MAX_LIST];  int ndensities;
+    int    threads[MAX_LIST];    int nthreads;
+    int    warmup, reps;
+    int    workload;             /* iterações máximas de workload_compute */
+    int    profile;              /* WorkloadProfile (--workload-profile) */
+    char   json[256];
+} BenchConfig;
+
+/* Estado de uma configuração (grade × densidade × threads). */
+typedef struct {
+    Partition p;
+    SubGrid   sg;
+    HaloCtx   halo;
+    AgentPool pool;
+    Arena     arena;
+    Cell     *snapshot;          /* células iniciais, para restaurar */
+    Cell     *full_grid;         /* rank 0: destino da coleta da TUI */
+    GridSweep sweep;
+    SimMetrics local_m;
+    int       side, num_agents, workload;
+    int       local_cells, local_agents;
+    double    sink;              /* resultados lidos para não sumirem */
+} Ctx;
+
+typedef enum { UNIT_CELL, UNIT_AGENT, UNIT_CALL } Unit;
+
+static const char *const unit_names[] = { "cell", "agent", "call" };
+
+typedef struct {
+    const char *name;
+    Unit        unit;
+    void      (*prep)(Ctx *);    /* fora da medição, antes de cada repetição */
+    void      (*run)(Ctx *);
+} Kernel;
+
+/* ── Estado ─────────────────────────────────────────────────── */
+
+static void restore_cells(Ctx *c) {
+    memcpy(c->sg.cells, c->snapshot,
+           sizeof(Cell) * (size_t)c->sg.halo_w * c->sg.halo_h);
+    arena_reset(&c->arena);
+}
+
+static void reset_agents(Ctx *c) {
+    restore_cells(c);
+    pool_destroy(&c->pool);
+    pool_init(&c->pool, 2 * c->num_agents / c->p.size + 16);
+    agents_init(&c->pool, c->num_agents, &c->sg, &c->p, c->side, c->side,
+                DEFAULT_INITIAL_ENERGY, DEFAULT_SEED);
+}
+
+/* Um passo de decisão leva agentes ao halo: a migração tem o que mover. */
+static void prep_migrate(Ctx *c) {
+    reset_agents(c);
+    agents_decide_all(&c->pool, &c->sg, DEFAULT_SEED, 0,
+                      DEFAULT_ENERGY_GAIN, DEFAULT_ENERGY_LOSS, &c->arena);
+}
+
+/* ── Kernels ────────────────────────────────────────────────── */
+
+static void k_subgrid_update(Ctx *c) {
+    grid_sweep_alloc(&c->sweep, &c->sg, &c->arena);
+    subgrid_update(&c->sg, DRY, &c->sweep);
+}
+
+static void k_agent_decide(Ctx *c) {
+    for (int i = 0; i < c->pool.count; i++) {
+        if (!pool_alive(&c->pool, i)) continue;
+        RngState rng = rng_seed(rng_agent_seed(DEFAULT_SEED, c->pool.id[i], 0));
+        c->sink += agent_decide(&c->pool, i, &c->sg, &rng);
+    }
+}
+
+static void k_agents_decide_all(Ctx *c) {
+    agents_decide_all(&c->pool, &c->sg, DEFAULT_SEED, 0,
+                      DEFAULT_ENERGY_GAIN, DEFAULT_ENERGY_LOSS, &c->arena);
+}
+
+static void k_workload_compute(Ctx *c) {
+    for (int i = 0; i < c->pool.count; i++) {
+        if (!pool_alive(&c->pool, i)) continue;
+        const Cell *cell = &c->sg.cells[CELL_AT(&c->sg, c->pool.y[i],
+                                                c->pool.x[i])];
+        c->sink += workload_compute(cell->resource, c->workload);
+    }
+}
+
+static void k_agents_workload(Ctx *c) {
+    agents_workload(&c->pool, &c->sg, c->workload, NULL);
+}
+
+static void k_halo_exchange(Ctx *c) {
+    halo_exchange(&c->halo, &c->sg, &c->p, &c->arena);
+}
+
+static void k_migrate_agents(Ctx *c) {
+    migrate_agents(&c->pool, &c->p, &c->sg, c->side, c->side, &c->arena);
+}
+
+static void k_metrics_reduce(Ctx *c) {
+    SimMetrics g;
+    metrics_reduce_global(&c->local_m, &g, c->p.cart_comm);
+    c->sink += g.total_resource;
+}
+
+static void k_gather_grid(Ctx *c) {
+    tui_gather_grid(&c->sg, &c->p, c->full_grid, c->side, c->side,
+                    c->p.cart_comm, &c->arena);
+}
+
+static void k_gather_agents(Ctx *c) {
+    Agent *all = NULL;
+    int    n   = 0;
+    tui_gather_agents(&c->pool, &c->sg, &c->p, c->side, c->side, &all, &n,
+                      c->p.cart_comm, &c->arena);
+    c->sink += n;
+}
+
+static const Kernel kernels[] = {
+    { "subgrid_update",        UNIT_CELL,  restore_cells, k_subgrid_update    },
+    { "agent_decide",          UNIT_AGENT, restore_cells, k_agent_decide      },
+    { "agents_decide_all",     UNIT_AGENT, reset_agents,  k_agents_decide_all },
+    { "workload_compute",      UNIT_AGENT, restore_cells, k_workload_compute  },
+    { "agents_workload",       UNIT_AGENT, restore_cells, k_agents_workload   },
+    { "halo_exchange",         UNIT_CALL,  restore_cells, k_halo_exchange     },
+    { "migrate_agents",        UNIT_AGENT, prep_migrate,  k_migrate_agents    },
+    { "metrics_reduce_global", UNIT_CALL,  NULL,          k_metrics_reduce    },
+    { "tui_gather_grid",       UNIT_CELL,  restore_cells, k_gather_grid       },
+    { "tui_gather_agents",     UNIT_AGENT, restore_cells, k_gather_agents     },
+};
+
+#define NKERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+/* ── Estatística ────────────────────────────────────────────── */
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Mediana de v[n]; ordena v. */
+static double median(double *v, int n) {
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    return (n % 2) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/* ── Configuração ───────────────────────────────────────────── */
+
+static int parse_ints(const char *s, int *out) {
+    int n = 0;
+    while (*s && n < MAX_LIST) {
+        out[n++] = atoi(s);
+        const char *comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return n;
+}
+
+static int parse_doubles(const char *s, double *out) {
+    int n = 0;
+    while (*s && n < MAX_LIST) {
+        out[n++] = atof(s);
+        const char *comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return n;
+}
+
+static void parse_args(int argc, char **argv, BenchConfig *bc) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+            bc->nsizes = parse_ints(argv[++i], bc->sizes);
+        else if (strcmp(argv[i], "--densities") == 0 && i + 1 < argc)
+            bc->ndensities = parse_doubles(argv[++i], bc->densities);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            bc->nthreads = parse_ints(argv[++i], bc->threads);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            bc->warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+            bc->reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workload") == 0 && i + 1 < argc)
+            bc->workload = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workload-profile") == 0 && i + 1 < argc)
+            bc->profile = workload_parse_profile(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            strncpy(bc->json, argv[++i], sizeof(bc->json) - 1);
+    }
+}
+
+static void ctx_create(Ctx *c, int side, double density, int workload) {
+    memset(c, 0, sizeof(*c));
+    c->side       = side;
+    c->workload   = workload;
+    c->num_agents = (int)(density * side * side);
+    partition_init(&c->p, side, side, MPI_COMM_WORLD);
+    subgrid_create(&c->sg, &c->p, side, side, 1);
+    subgrid_init(&c->sg, &c->p, DEFAULT_SEED);
+    subgrid_set_season(&c->sg, DRY);
+    halo_init(&c->halo, HALO_ISEND, &c->sg, &c->p);
+    arena_init(&c->arena, 1 << 16);
+
+    /* A grade nasce sem recurso: regenera alguns ciclos para a carga
+     * e a decisão verem valores típicos de uma execução. */
+    for (int k = 0; k < WARM_CYCLES; k++) {
+        arena_reset(&c->arena);
+        grid_sweep_alloc(&c->sweep, &c->sg, &c->arena);
+        subgrid_update(&c->sg, DRY, &c->sweep);
+    }
+
+    const size_t ncells = (size_t)c->sg.halo_w * c->sg.halo_h;
+    c->snapshot = sim_malloc(sizeof(Cell) * ncells);
+    memcpy(c->snapshot, c->sg.cells, sizeof(Cell) * ncells);
+    if (c->p.rank == 0)
+        c->full_grid = sim_malloc(sizeof(Cell) * (size_t)side * side);
+
+    pool_init(&c->pool, 16);
+    reset_agents(c);
+    metrics_compute_local(&c->sg, &c->pool, NULL, &c->local_m, &c->arena);
+    c->local_cells  = c->sg.local_w * c->sg.local_h;
+    c->local_agents = pool_live(&c->pool);
+}
+
+static void ctx_destroy(Ctx *c) {
+    free(c->snapshot);
+    free(c->full_grid);
+    arena_destroy(&c->arena);
+    pool_destroy(&c->pool);
+    halo_destroy(&c->halo, &c->sg);
+    subgrid_destroy(&c->sg);
+    partition_destroy(&c->p);
+}
+
+int main(int argc, char **argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    BenchConfig bc = {
+        .sizes     = { 64, 128, 256 }, .nsizes     = 3,
+        .densities = { 0.05, 0.3 },    .ndensities = 2,
+        .threads   = { 1, 2, 4 },      .nthreads   = 3,
+        .warmup    = 3, .reps = 15, .workload = 1000,
+    };
+    parse_args(argc, argv, &bc);
+    if (bc.reps < 1 || bc.warmup < 0 || bc.nsizes < 1 ||
+        bc.ndensities < 1 || bc.nthreads < 1 || bc.profile < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Usage: %s [--sizes N,...] [--densities D,...] "
+                    "[--threads T,...] [--warmup W] [--reps R] "
+                    "[--workload N] [--workload-profile NAME] [--json PATH]\n",
+                    argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+
+    season_schedule_set(DEFAULT_SEASONS, DEFAULT_SEASON_LENGTH);
+    pack_types_init();
+
+    FILE *out = stdout;
+    if (rank == 0 && bc.json[0] && !(out = fopen(bc.json, "w"))) {
+        fprintf(stderr, "Error: cannot write %s\n", bc.json);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (rank == 0)
+        fprintf(out, "{\n  \"ranks\": %d,\n  \"warmup\": %d,\n  \"reps\": %d,\n"
+                "  \"workload\": %d,\n  \"workload_profile\": \"%s\",\n"
+                "  \"results\": [",
+                size, bc.warmup, bc.reps, bc.workload,
+                workload_profile_name((WorkloadProfile)bc.profile));
+
+    double *t     = sim_malloc(sizeof(double) * (size_t)bc.reps);
+    double *t_max = sim_malloc(sizeof(double) * (size_t)bc.reps);
+    double *dev   = sim_malloc(sizeof(double) * (size_t)bc.reps);
+    int first = 1;
+
+    for (int si = 0; si < bc.nsizes; si++)
+    for (int di = 0; di < bc.ndensities; di++)
+    for (int ti = 0; ti < bc.nthreads; ti++) {
+        omp_set_num_threads(bc.threads[ti]);
+        /* Tabelas por thread do perfil para a equipe desta configuração. */
+        workload_set_profile((WorkloadProfile)bc.profile);
+        Ctx c;
+        ctx_create(&c, bc.sizes[si], bc.densities[di], bc.workload);
+
+        for (int k = 0; k < NKERNELS; k++) {
+            const Kernel *kn = &kernels[k];
+            for (int r = -bc.warmup; r < bc.reps; r++) {
+                if (kn->prep) kn->prep(&c);
+                MPI_Barrier(MPI_COMM_WORLD);
+                double t0 = MPI_Wtime();
+                kn->run(&c);
+                if (r >= 0) t[r] = MPI_Wtime() - t0;
+            }
+            /* Cada repetição vale o rank mais lento. */
+            MPI_Reduce(t, t_max, bc.reps, MPI_DOUBLE, MPI_MAX, 0,
+                       MPI_COMM_WORLD);
+            if (rank != 0) continue;
+
+            double lo = t_max[0];
+            for (int r = 1; r < bc.reps; r++)
+                if (t_max[r] < lo) lo = t_max[r];
+            double med = median(t_max, bc.reps);
+            for (int r = 0; r < bc.reps; r++)
+                dev[r] = t_max[r] > med ? t_max[r] - med : med - t_max[r];
+            double mad = median(dev, bc.reps);
+
+            /* Custo por unidade do rank 0, que tem a sub-grade padrão. */
+            double units = kn->unit == UNIT_CELL  ? c.local_cells
+                         : kn->unit == UNIT_AGENT ? c.local_agents : 1;
+            fprintf(out, "%s\n    {\"kernel\": \"%s\", \"grid\": %d, "
+                    "\"density\": %g, \"agents\": %d, \"threads\": %d, "
+                    "\"median_us\": %.3f, \"mad_us\": %.3f, \"min_us\": %.3f, "
+                    "\"unit\": \"%s\", \"ns_per_unit\": %.3f}",
+                    first ? "" : ",", kn->name, c.side, bc.densities[di],
+                    c.num_agents, bc.threads[ti], med * 1e6, mad * 1e6,
+                    lo * 1e6, unit_names[kn->unit],
+                    units > 0 ? med * 1e9 / units : 0.0);
+            first = 0;
+        }
+        if (rank == 0) {
+            fprintf(stderr, "bench: grid %d, density %g, threads %d done\n",
+                    bc.sizes[si], bc.densities[di], bc.threads[ti]);
+        }
+        volatile double sink = c.sink;   /* resultados não descartados */
+        (void)sink;
+        ctx_destroy(&c);
+    }
+
+    if (rank == 0) {
+        fprintf(out, "\n  ]\n}\n");
+        if (out != stdout) fclose(out);
+    }
+    free(t);
+    free(t_max);
+    free(dev);
+    workload_shutdown();
+    pack_types_free();
+    MPI_Finalize();
+    return 0;
+}
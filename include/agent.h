@@ -3,58 +3,174 @@
 
 #include "types.h"
 #include "rng.h"
+#include "arena.h"
+#include "lpt.h"
 #include <stdint.h>
 
 /*
  * Cria e distribui agentes deterministicamente entre ranks MPI.
  * Uma única sequência global de RNG decide a posição inicial de cada agente;
  * cada rank mantém apenas os que caem na sua sub-grade.
- * O caller fornece o array `agents` pré-alocado.
+ * O caller fornece o pool já inicializado (pool_init); o id de cada
+ * agente inicial é seu índice global na sequência.
  */
-void agents_init(Agent *agents, int *count, int num_total,
+void agents_init(AgentPool *pool, int num_total,
                  SubGrid *sg, Partition *p,
                  int global_w, int global_h,
                  double initial_energy, uint64_t seed);
 
 /*
- * Passo de decisão de um agente.
+ * Passo de decisão do agente no slot i.
  * Examina 8 vizinhos + célula atual, filtra por acessibilidade,
  * e move para a célula com mais recurso (empates resolvidos por RNG).
- * O agente ganha energia ao consumir recurso, perde caso contrário,
- * e morre (alive = 0) se a energia cair a zero ou abaixo.
+ * Só lê células. Retorna o índice (CELL_AT) da célula onde o agente
+ * consome neste ciclo. Quem cruza para o bloco de outro rank não consome
+ * e recebe -2 - idx, com idx a célula de origem (sempre < -1).
  */
-void agent_decide(Agent *a, SubGrid *sg, Season season, RngState *rng,
-                  double energy_gain, double energy_loss);
+int agent_decide(AgentPool *pool, int i, const SubGrid *sg, RngState *rng);
+
+/*
+ * Célula em cujo bucket entra o destino d de agent_decide: a célula de
+ * consumo ou, para quem cruzou, a de origem. -1 (agente morto) fica fora.
+ */
+static inline int agent_bucket(int d) {
+    return d >= -1 ? d : -2 - d;
+}
 
 /*
  * Executa a carga sintética (workload_compute) para todos os agentes vivos.
  * Apenas o busy-loop, sem RNG — pode ser cronometrado separadamente.
+ * Com finish != NULL, cada thread grava em finish[tid] o instante
+ * (omp_get_wtime) em que terminou sua parte.
+ */
+void agents_workload(AgentPool *pool, SubGrid *sg, int max_workload,
+                     double *finish);
+
+/*
+ * A mesma carga em ordem LPT (--workload-sched lpt): custo previsto de
+ * cada agente (resource * max_workload iterações), agentes do mais caro
+ * ao mais barato em filas por thread com roubo de tarefas (lpt.h).
+ *
+ * agents_workload_plan monta o plano com `nthreads` filas (memória da
+ * arena do ciclo) e agents_workload_lpt o executa numa equipe desse
+ * tamanho, sem tocar na arena. Com --comm-thread o plano é montado
+ * antes do par sobreposto, pois a thread de comunicação usa a mesma
+ * arena durante a carga.
+ */
+LptPlan *agents_workload_plan(AgentPool *pool, SubGrid *sg,
+                              int max_workload, int nthreads, Arena *arena);
+void agents_workload_lpt(LptPlan *plan, AgentPool *pool, SubGrid *sg,
+                         int max_workload, double *finish);
+
+/*
+ * Passo síncrono de todos os agentes vivos:
+ *   1. decisões em paralelo sobre o estado das células no início do
+ *      passo, com PRNG por agente (rng_agent_seed(seed, id, cycle));
+ *   2. agentes agrupados por célula (counting sort): a de destino, ou a
+ *      de origem para quem cruzou para o bloco de outro rank;
+ *   3. cada célula é consumida pelos seus agentes em ordem crescente
+ *      de id: ganham energia ao consumir, perdem caso contrário, e
+ *      morrem (bit limpo no bitmask) com energia <= 0. Quem cruzou
+ *      não consome nem perde energia.
+ * O resultado não depende da ordem do pool, do número de threads nem
+ * de quantos ciclos o rank avança entre trocas (--halo-depth).
+ * Retorna, por slot, o id que um filho nascido neste ciclo receberia
+ * (agent_birth_id + posição no bucket), ou 0 para os slots mortos.
+ * Esse array e os buffers temporários vêm da arena do ciclo.
  */
-void agents_workload(Agent *agents, int count, SubGrid *sg, int max_workload);
+uint64_t *agents_decide_all(AgentPool *pool, SubGrid *sg,
+                            uint64_t seed, int cycle,
+                            double energy_gain, double energy_loss,
+                            Arena *arena);
 
 /*
- * Executa a lógica de decisão (agent_decide) para todos os agentes vivos.
- * Requer PRNG per-thread para desempate por reservoir sampling.
+ * Consome a célula `cell` pelos n agentes do seu bucket (passo 3 de
+ * agents_decide_all): ordena os slots por id e aplica ganho/perda aos
+ * que têm dest[slot] >= 0; os que cruzaram (dest < -1) só recebem id.
+ * `accessible` é o bit da célula na estação corrente (subgrid_accessible).
+ * O k-ésimo do bucket recebe kid[slot] = birth + k, com birth o
+ * agent_birth_id da célula. Uma célula por chamada; chamadas em
+ * células distintas são seguras em paralelo.
  */
-void agents_decide_all(Agent *agents, int count, SubGrid *sg,
-                       Season season, uint64_t seed,
-                       double energy_gain, double energy_loss);
+void agents_consume_cell(AgentPool *pool, Cell *cell, int accessible,
+                         int *slots, int n, const int *dest,
+                         double energy_gain, double energy_loss,
+                         uint64_t *kid, uint64_t birth);
 
 /*
  * Processa todos os agentes vivos em paralelo (OpenMP).
  * Wrapper que chama agents_workload + agents_decide_all em sequência.
  * Mantido para compatibilidade com testes existentes.
  */
-void agents_process(Agent *agents, int count, SubGrid *sg,
-                    Season season, int max_workload, uint64_t seed,
-                    double energy_gain, double energy_loss);
+void agents_process(AgentPool *pool, SubGrid *sg,
+                    int max_workload, uint64_t seed, int cycle,
+                    double energy_gain, double energy_loss,
+                    Arena *arena);
+
+/*
+ * Ids de agente. Invariante: nenhum id se repete na simulação inteira,
+ * sem comunicação, e todo rank que recompute um nascimento (anel do
+ * --halo-depth) chega ao mesmo id.
+ *   - iniciais: índice na sequência de posicionamento (< num_agents,
+ *     bit 63 desligado);
+ *   - filhos: bit 63 ligado e três campos disjuntos, do mais alto ao
+ *     mais baixo: ciclo do nascimento, célula global do bucket do pai
+ *     (agent_bucket; gy * global_w + gx) e posição k do pai entre os
+ *     agentes desse bucket, em ordem de id.
+ * Cada agente vivo entra no bucket de uma única célula por ciclo — a
+ * de consumo, ou a de origem se cruzou para o bloco de outro rank —
+ * então (ciclo, célula, k) identifica um único pai.
+ *
+ * agent_ids_init dimensiona os campos para a execução: bits para
+ * total_cycles ciclos e global_w * global_h células; o resto fica
+ * para k. Retorna -1 se sobrarem menos de AGENT_ID_MIN_RANK_BITS:
+ * um bucket nunca passa de pool->count (int) agentes, então 31 bits
+ * cabem qualquer k e a verificação fica toda na partida.
+ */
+#define AGENT_ID_MIN_RANK_BITS 31
+
+int      agent_ids_init(int total_cycles, int global_w, int global_h);
+uint64_t agent_child_id(int cycle, int gx, int gy, int k);
+
+/* agent_child_id com k = 0 para a célula idx (CELL_AT) de sg. */
+uint64_t agent_birth_id(const SubGrid *sg, int idx, int cycle);
 
 /*
  * Reprodução: agentes com energia acima de threshold geram um filho.
- * O filho nasce na mesma posição com energy = cost; o pai perde cost.
- * Serial (modifica tamanho do array e next_id).
+ * O filho nasce na mesma posição com energy = cost e id kid[i]
+ * (devolvido por agents_decide_all no mesmo ciclo); o pai perde cost.
+ * Slots com kid[i] == 0 (mortos no passo) não se reproduzem.
+ * Paralela (OpenMP): conta nascimentos por thread, faz scan exclusivo,
+ * cresce o pool uma única vez e escreve os filhos em paralelo.
+ * Ordem dos filhos idêntica à da versão serial.
+ * Contadores por thread vêm da arena do ciclo.
+ */
+void agents_reproduce(AgentPool *pool, const uint64_t *kid,
+                      double threshold, double cost, Arena *arena);
+
+/*
+ * Variantes "_team": o mesmo trabalho, mas para ser chamado por todas as
+ * threads de uma região paralela já aberta (construções órfãs). As
+ * versões acima são apenas `#pragma omp parallel` em volta delas.
+ * agents_workload_team e agents_workload_lpt_team terminam sem barreira;
+ * as demais terminam com barreira implícita e o pool já consistente.
+ *
+ * O LPT tem duas etapas: agents_workload_plan_team (custos e filas,
+ * com barreira; devolve o mesmo plano a todas as threads) e
+ * agents_workload_lpt_team, que o consome. Uma thread que chega atrasada
+ * à segunda etapa tem sua fila roubada pelas outras.
  */
-void agents_reproduce(Agent **agents, int *count, int *capacity,
-                      int *next_id, double threshold, double cost);
+void agents_workload_team(AgentPool *pool, SubGrid *sg, int max_workload,
+                          double *finish);
+LptPlan *agents_workload_plan_team(AgentPool *pool, SubGrid *sg,
+                                   int max_workload, Arena *arena);
+void agents_workload_lpt_team(LptPlan *plan, AgentPool *pool, SubGrid *sg,
+                              int max_workload, double *finish);
+uint64_t *agents_decide_all_team(AgentPool *pool, SubGrid *sg,
+                                 uint64_t seed, int cycle,
+                                 double energy_gain, double energy_loss,
+                                 Arena *arena);
+void agents_reproduce_team(AgentPool *pool, const uint64_t *kid,
+                           double threshold, double cost, Arena *arena);
 
 #endif /* AGENT_H */
@@ -0,0 +1,53 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Arena de quadro (frame arena) — alocador bump por rank para buffers
+ * que vivem apenas durante um ciclo (halos, migração, coletas da TUI).
+ *
+ * arena_reset é chamado no início de cada ciclo e invalida tudo que foi
+ * alocado antes. Quando um ciclo estoura o bloco principal, as
+ * alocações excedentes vão para blocos de overflow e o próximo reset
+ * redimensiona o bloco principal para o pico observado (high-water).
+ * Em regime estacionário, nenhum ciclo chama malloc.
+ *
+ * Não é thread-safe: use apenas fora de regiões paralelas (ou no master),
+ * ou, com --comm-thread, só na thread de comunicação.
+ */
+typedef struct {
+    char   *base;
+    size_t  size;         /* capacidade do bloco principal */
+    size_t  used;         /* bytes usados no bloco principal */
+    size_t  cycle_bytes;  /* total pedido desde o último reset */
+    size_t  high_water;   /* maior cycle_bytes já observado */
+    void  **overflow;     /* blocos extras do ciclo corrente */
+    int     n_overflow;
+    int     cap_overflow;
+} Arena;
+
+void  arena_init(Arena *a, size_t initial);
+void  arena_destroy(Arena *a);
+
+/* Aloca `bytes` alinhados a 64 bytes. Nunca retorna NULL (aborta sem memória). */
+void *arena_alloc(Arena *a, size_t bytes);
+
+/* Como arena_alloc, com memória zerada. */
+void *arena_calloc(Arena *a, size_t n, size_t size);
+
+/* Descarta todas as alocações; cresce o bloco principal até o high-water. */
+void  arena_reset(Arena *a);
+
+/*
+ * Contador de alocações no heap (debug).
+ * sim_malloc/sim_calloc/sim_realloc contam cada chamada; main.c lê o
+ * contador antes e depois de cada fase para o relatório --alloc-stats.
+ */
+void    *sim_malloc(size_t bytes);
+void    *sim_calloc(size_t n, size_t size);
+void    *sim_realloc(void *ptr, size_t bytes);
+uint64_t sim_alloc_count(void);
+
+#endif /* ARENA_H */
@@ -0,0 +1,82 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+/*
+ * Escalonamento OpenMP por fase (--autotune / --tune-file).
+ *
+ * Os laços de carga, decisão e regeneração usam schedule(runtime): cada
+ * thread chama tune_apply(fase) antes do laço, que aplica o tipo e o
+ * chunk da fase com omp_set_schedule. Toda fase também aceita menos
+ * threads que a equipe (tune_block).
+ *
+ * O autotuner experimenta candidatos durante os primeiros ciclos, um
+ * por ciclo e em rodízio, mede o tempo de cada fase (máximo entre os
+ * ranks, então todos escolhem igual) e fixa o mais rápido pela média.
+ * Os resultados da simulação não dependem do escalonamento.
+ */
+
+typedef enum {
+    TUNE_WORKLOAD = 0,   /* agents_workload                */
+    TUNE_DECIDE   = 1,   /* decisões de agents_decide_all  */
+    TUNE_GRID     = 2,   /* subgrid_update                 */
+    TUNE_PHASES
+} TunePhase;
+
+typedef struct {
+    int kind;      /* omp_sched_t: 1 static, 2 dynamic, 3 guided */
+    int chunk;     /* 0 = padrão do tipo                          */
+    int threads;   /* 0 = equipe inteira                          */
+} TuneSetting;
+
+/* Aplica o escalonamento da fase à thread chamadora (omp_set_schedule). */
+void tune_apply(TunePhase ph);
+
+/* Threads ativas da fase (0 = todas). */
+int tune_threads(TunePhase ph);
+
+/*
+ * Faixa [*lo, *hi) de 0..n-1 da thread chamadora quando a fase roda com
+ * menos threads que a equipe: blocos contíguos nas últimas threads,
+ * deixando de fora a master, que chega atrasada das fases MPI (threads
+ * de fora recebem uma faixa vazia). Retorna 0, sem tocar em lo/hi, se a
+ * fase usa a equipe inteira e o laço segue com omp for.
+ */
+int tune_block(TunePhase ph, int n, int *lo, int *hi);
+
+TuneSetting tune_get(TunePhase ph);
+void        tune_set(TunePhase ph, TuneSetting s);
+
+/* "guided,8" / "static,0,2". Escreve em buf e o retorna. */
+const char *tune_format(TuneSetting s, char *buf, int len);
+
+/*
+ * Lê/grava a configuração em texto ("fase=tipo,chunk[,threads]" por
+ * linha, '#' comenta). Retornam 0, ou -1 se o arquivo não abre ou tem
+ * linha inválida (as configurações em vigor não mudam na leitura).
+ */
+int tune_load(const char *path);
+int tune_save(const char *path, const char *comment);
+
+/*
+ * Inicia o autotuner por `cycles` ciclos para equipes de `nthreads`
+ * threads e aplica os primeiros candidatos.
+ */
+void autotune_begin(int cycles, int nthreads);
+
+/* 1 enquanto o autotuner ainda experimenta candidatos. */
+int autotune_active(void);
+
+#ifdef USE_MPI
+/*
+ * Registra os tempos do ciclo que terminou (t[fase], em segundos) e
+ * aplica os candidatos do próximo. Coletiva em comm. Retorna 1 no ciclo
+ * em que a escolha é fixada.
+ */
+int autotune_record(const double t[TUNE_PHASES], MPI_Comm comm);
+#endif
+
+#endif /* AUTOTUNE_H */
@@ -0,0 +1,74 @@
+#ifndef BENCHRUN_H
+#define BENCHRUN_H
+
+#include <stdio.h>
+#include "metrics.h"
+#include "types.h"
+
+/*
+ * Modo benchmark no próprio binário (--bench R).
+ *
+ * O sim roda R repetições no mesmo processo, recriando partição, grade,
+ * pool e halos a cada uma (mesma semente, mesma trajetória). Os primeiros
+ * `warmup` ciclos de cada repetição são descartados. Dos demais, o rank 0
+ * acumula os tempos de CyclePerf (máximo entre ranks, como no CSV) e os
+ * agentes e células atualizados. O relatório em JSON traz atualizações
+ * por segundo (média e desvio entre repetições), média e desvio de cada
+ * fase sobre os ciclos medidos e a eficiência paralela.
+ */
+
+typedef struct {
+    int     warmup;                       /* ciclos descartados por repetição */
+    int     reps;                         /* repetições concluídas */
+    long    cycles;                       /* ciclos medidos, todas as repetições */
+    double  sum[CYCLEPERF_NTIMES];        /* s, sobre os ciclos medidos */
+    double  sumsq[CYCLEPERF_NTIMES];
+    double  rep_time;                     /* repetição corrente */
+    double  rep_agents, rep_cells;
+    double *agent_rate, *cell_rate;       /* por repetição (/s) */
+} BenchRun;
+
+void benchrun_init(BenchRun *b, int reps, int warmup);
+
+/* Um ciclo medido (rank 0): times[CYCLEPERF_NTIMES] a partir de
+ * cycle_time, agentes vivos e células da grade global. */
+void benchrun_cycle(BenchRun *b, const double *times, int agents,
+                    double cells);
+
+/* Fecha a repetição corrente. */
+void benchrun_end_rep(BenchRun *b);
+
+/* Média das atualizações de agente por segundo entre as repetições. */
+double benchrun_agent_rate(const BenchRun *b);
+
+/*
+ * Escreve o JSON. `ref_rate` é a taxa de atualizações de agente de uma
+ * execução com 1 rank e 1 thread (--bench-ref, ou medida por main.c
+ * depois das repetições); sem ela (0), a eficiência só é conhecida
+ * quando a própria execução usa um núcleo.
+ */
+void benchrun_print(FILE *out, const BenchRun *b, const SimConfig *cfg,
+                    int ranks, int threads, double ref_rate);
+
+/*
+ * Varredura de escalabilidade fraca (--weak-scaling): um BenchRun por
+ * número de ranks, com a grade e a população derivadas de
+ * --cells-per-rank e --agents-per-rank.
+ */
+typedef struct {
+    int      ranks;
+    int      global_w, global_h;
+    int      agents;
+    BenchRun run;
+} WeakPoint;
+
+/*
+ * Escreve o JSON da varredura. pts[0] é o ponto de 1 rank; a eficiência
+ * de cada ponto é a vazão de agentes por rank relativa à dele.
+ */
+void benchrun_weak_print(FILE *out, const WeakPoint *pts, int n,
+                         const SimConfig *cfg, int threads);
+
+void benchrun_free(BenchRun *b);
+
+#endif /* BENCHRUN_H */
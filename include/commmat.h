@@ -0,0 +1,62 @@
+#ifndef COMMMAT_H
+#define COMMMAT_H
+
+#include <stdint.h>
+#include "pack.h"
+#include "types.h"
+
+/*
+ * Matriz de comunicação (--comm-matrix PATH).
+ *
+ * Nos mesmos pontos onde pack_bytes_add conta os bytes do ciclo, cada
+ * mensagem é registrada com o rank de destino: bytes e mensagens por
+ * (fase, destino), histograma de tamanhos (potências de 2) e totais por
+ * ciclo. A migração também conta os migrantes pela direção por onde
+ * saíram da sub-grade; migrante cujo dono não é o vizinho cartesiano
+ * daquela direção vai para COMMMAT_DIR_OTHER.
+ *
+ * Contam as mensagens do fio: os pedidos de contagem do MPI_Alltoall da
+ * migração (um int por rank), o MPI_Alltoallv, as bordas de halo e as
+ * coletas da TUI. Cópias diretas na memória do vizinho (--halo shm) não
+ * são mensagens e ficam de fora.
+ *
+ * Chamadas só por uma thread por vez (as mesmas que chamam MPI).
+ */
+
+#define COMMMAT_SIZE_BUCKETS 32   /* [2^k, 2^(k+1)) bytes */
+#define COMMMAT_DIR_OTHER    8    /* após as 8 direções de halo.h */
+#define COMMMAT_DIRS         9
+
+extern int commmat_enabled;
+
+/* Prepara os contadores para `nranks` destinos. */
+void commmat_init(int nranks);
+
+void commmat_record(WirePhase ph, int dest, uint64_t bytes);
+void commmat_record_migrant(int dir);
+
+static inline void commmat_send(WirePhase ph, int dest, uint64_t bytes) {
+    if (commmat_enabled) commmat_record(ph, dest, bytes);
+}
+
+static inline void commmat_migrant(int dir) {
+    if (commmat_enabled) commmat_record_migrant(dir);
+}
+
+/* Fecha os totais do ciclo corrente (fora de regiões paralelas). */
+void commmat_end_cycle(void);
+
+#ifdef USE_MPI
+/*
+ * Junta tudo no rank 0 e grava `path`: ranks (posição na grade e nó),
+ * matrizes rank × rank de bytes e mensagens por fase, histograma de
+ * tamanhos, migrantes por direção e totais por ciclo. Coletiva em
+ * p->cart_comm. No rank 0, retorna 0 ou -1 se o arquivo não abre, e a
+ * fração dos migrantes que foram ao vizinho da direção em *nbr_share
+ * (-1 sem migrantes).
+ * Libera os contadores.
+ */
+int commmat_write(const char *path, const Partition *p, double *nbr_share);
+#endif
+
+#endif /* COMMMAT_H */
@@ -0,0 +1,43 @@
+#ifndef COMMTHREAD_H
+#define COMMTHREAD_H
+
+/*
+ * Thread de comunicação dedicada (--comm-thread).
+ *
+ * Uma fase de comunicação e uma fase de computação independentes rodam
+ * ao mesmo tempo: uma thread OpenMP fica reservada para as chamadas MPI
+ * e as demais formam uma equipe aninhada que executa a computação com
+ * os laços `omp parallel for` de sempre. Requer MPI_THREAD_MULTIPLE,
+ * pois a thread de comunicação não é a thread principal do processo.
+ *
+ * A redução das métricas não tem par: ela consome as métricas locais,
+ * o último cálculo do ciclo, e a saída do ciclo espera por ela.
+ */
+
+typedef void (*CommTaskFn)(void *arg);
+
+typedef struct {
+    double comm_time;      /* duração da fase de comunicação */
+    double compute_time;   /* duração da fase de computação  */
+    double overlap_time;   /* comm + compute - tempo do par   */
+} OverlapTimes;
+
+/*
+ * Habilita regiões aninhadas e fixa o número de threads de computação
+ * em nthreads - 1. Retorna 0 se nthreads < 2 (modo indisponível).
+ */
+int comm_thread_init(int nthreads);
+
+/* Tamanho da equipe de computação (nthreads - 1 após comm_thread_init). */
+int comm_thread_compute_threads(void);
+
+/*
+ * Executa comm(comm_arg) na thread de comunicação e compute(compute_arg)
+ * na equipe de computação, esperando as duas. Qualquer um dos dois pode
+ * ser NULL. Os tempos são acumulados em *t.
+ */
+void comm_thread_overlap(CommTaskFn comm, void *comm_arg,
+                         CommTaskFn compute, void *compute_arg,
+                         OverlapTimes *t);
+
+#endif /* COMMTHREAD_H */
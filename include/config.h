@@ -7,6 +7,7 @@
 #define DEFAULT_GLOBAL_H        64
 #define DEFAULT_TOTAL_CYCLES    100
 #define DEFAULT_SEASON_LENGTH   20
+#define DEFAULT_SEASONS         "dry,wet"
 #define DEFAULT_NUM_AGENTS      50
 #define DEFAULT_MAX_WORKLOAD    500000
 #define DEFAULT_CONSUMPTION     0.2
@@ -18,6 +19,10 @@
 #define DEFAULT_SEED            42ULL
 #define DEFAULT_TUI_ENABLED     1
 #define DEFAULT_TUI_INTERVAL    1
+#define DEFAULT_HALO_DEPTH      1
+#define DEFAULT_TILE_SIZE       16
+#define DEFAULT_BENCH_WARMUP    5
+#define DEFAULT_WEAK_REPS       3
 
 #define SIM_CONFIG_DEFAULTS {           \
     .global_w        = DEFAULT_GLOBAL_W,        \
@@ -35,7 +40,13 @@
     .seed            = DEFAULT_SEED,            \
     .tui_enabled     = DEFAULT_TUI_ENABLED,     \
     .tui_interval    = DEFAULT_TUI_INTERVAL,    \
-    .csv_output      = 0                        \
+    .csv_output      = 0,                       \
+    .halo_depth      = DEFAULT_HALO_DEPTH,      \
+    .comm_thread     = 0,                       \
+    .exec_tasks      = 0,                       \
+    .tile_size       = DEFAULT_TILE_SIZE,       \
+    .bench_warmup    = DEFAULT_BENCH_WARMUP,    \
+    .seasons         = DEFAULT_SEASONS          \
 }
 
 #endif /* CONFIG_H */
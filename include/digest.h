@@ -0,0 +1,40 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <stdint.h>
+#include "types.h"
+
+/*
+ * Resumo de 64 bits do estado global (--digest-every N), para conferir
+ * que uma otimização não mudou a trajetória.
+ *
+ * Cada célula do interior é resumida a partir de (gx, gy, tipo, bits de
+ * resource e max_resource), e cada agente vivo do interior a partir de
+ * (id, gx, gy, bits de energy). Os resumos são somados módulo 2^64, uma
+ * operação comutativa: o resultado não depende da ordem das células e
+ * dos agentes nem das threads. Para um mesmo estado, também não depende
+ * da decomposição; mas a trajetória muda com o NP (quem cruza de rank
+ * não consome no ciclo), então resumos de NPs diferentes só coincidem
+ * quando a trajetória coincide. As threads somam partes do rank, e os
+ * ranks juntam (células, agentes, contagem) num único MPI_Reduce.
+ *
+ * Com halos profundos, só vale nos ciclos de sincronização do anel,
+ * quando todos os agentes do rank estão no interior.
+ */
+
+#define DIGEST_WORDS 3   /* soma das células, soma dos agentes, agentes */
+
+/* Partes deste rank (fora de regiões paralelas). */
+void digest_local(const SubGrid *sg, const AgentPool *pool,
+                  uint64_t out[DIGEST_WORDS]);
+
+/* Partes somadas entre ranks → resumo final. */
+uint64_t digest_finish(const uint64_t sum[DIGEST_WORDS]);
+
+#ifdef USE_MPI
+/* Coletiva em comm; o resumo é válido no rank 0. */
+uint64_t digest_global(const SubGrid *sg, const AgentPool *pool,
+                       MPI_Comm comm);
+#endif
+
+#endif /* DIGEST_H */
@@ -2,28 +2,93 @@
 #define GRID_H
 
 #include "types.h"
+#include "arena.h"
 #include <stdint.h>
 
 /*
  * Inicializa um SubGrid alocado na stack usando a partição para calcular
- * dimensões locais e offsets. Aloca o array de células com halo.
+ * dimensões locais e offsets. Aloca o array de células com `halo`
+ * células de halo em cada lado e define a caixa recomputada por ciclo.
  */
 void subgrid_create(SubGrid *sg, Partition *p,
-                    int global_w, int global_h);
+                    int global_w, int global_h, int halo);
 
 /*
- * Inicializa deterministicamente cada célula local.
+ * Inicializa deterministicamente cada célula local, halo incluído.
  * Tipo e recursos derivam de uma seed por célula, garantindo
  * grade global idêntica independentemente da decomposição MPI.
+ * Monta também os planos de acessibilidade de todas as estações.
  */
 void subgrid_init(SubGrid *sg, Partition *p, uint64_t seed);
 
 /*
- * Avança a sub-grade por um ciclo: regenera recursos conforme a estação,
- * atualiza acessibilidade e limita valores.
- * Usa OpenMP parallel for collapse(2) sobre o interior.
+ * Parciais da passada fundida sobre a grade, por linha do interior
+ * (índice r - halo): soma do recurso e soma por tipo de célula. São
+ * combinadas em ordem fixa (grid_sweep_total), então o total não
+ * depende de quantas threads fizeram a passada.
  */
-void subgrid_update(SubGrid *sg, Season season);
+typedef struct {
+    double *row_resource;    /* [local_h] */
+    double *type_resource;   /* [local_h * CELL_TYPES] */
+} GridSweep;
+
+/* Aloca as parciais na arena do ciclo (chamar fora da região paralela). */
+void grid_sweep_alloc(GridSweep *gs, const SubGrid *sg, Arena *arena);
+
+/* Soma as parciais por linha, em ordem. */
+void grid_sweep_total(const GridSweep *gs, const SubGrid *sg,
+                      double *total, double type_total[CELL_TYPES]);
+
+/* Só as parciais, sem regenerar (omp for órfão, nowait). */
+void subgrid_sum_rows_team(const SubGrid *sg, GridSweep *gs);
+
+/*
+ * Passada fundida sobre a caixa (box_*): regenera recursos conforme
+ * `season`, limita valores e, com gs != NULL, acumula as parciais do
+ * interior — uma única leitura de cada célula.
+ * Abre uma região paralela em volta de subgrid_update_team.
+ */
+void subgrid_update(SubGrid *sg, Season season, GridSweep *gs);
+
+/* Como subgrid_update, para todas as threads de uma região já aberta:
+ * omp for dinâmico por linhas, com nowait (sem barreira no fim). */
+void subgrid_update_team(SubGrid *sg, Season season, GridSweep *gs);
+
+/* Como subgrid_update, mas só a linha r da caixa e sem OpenMP. */
+void subgrid_update_row(SubGrid *sg, Season season, int r, GridSweep *gs);
+
+/* Colunas [c0, c1] da linha r (inclusivas), sem OpenMP nem parciais. */
+void subgrid_update_span(SubGrid *sg, Season season, int r, int c0, int c1);
+
+/* Virada de estação: só troca o plano de acessibilidade corrente. */
+static inline void subgrid_set_season(SubGrid *sg, Season season) {
+    sg->access = sg->access_planes + (size_t)season * sg->plane_words;
+}
+
+/* 1 se a célula idx (CELL_AT) é acessível na estação corrente. */
+static inline int subgrid_accessible(const SubGrid *sg, int idx) {
+    return (int)((sg->access[idx >> 6] >> (idx & 63)) & 1u);
+}
+
+/* 1 se (c, r), em coordenadas de halo, está no interior. */
+static inline int subgrid_interior(const SubGrid *sg, int c, int r) {
+    return c >= sg->halo && c < sg->halo + sg->local_w &&
+           r >= sg->halo && r < sg->halo + sg->local_h;
+}
+
+/*
+ * Bloco da decomposição que contém (c, r): 0 = interior, demais valores
+ * identificam o vizinho (lado × lado). Vale enquanto o halo não é mais
+ * largo que a sub-grade vizinha, o que main.c valida na partida.
+ */
+static inline int subgrid_block(const SubGrid *sg, int c, int r) {
+    int bc = (c < sg->halo) ? 1 : (c < sg->halo + sg->local_w) ? 0 : 2;
+    int br = (r < sg->halo) ? 1 : (r < sg->halo + sg->local_h) ? 0 : 2;
+    return br * 3 + bc;
+}
+
+/* Recurso máximo de um tipo de célula (tabela estática). */
+double grid_max_resource(CellType type);
 
 /* Libera o array de células (o SubGrid em si é alocado na stack). */
 void subgrid_destroy(SubGrid *sg);
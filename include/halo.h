@@ -2,6 +2,10 @@
 #define HALO_H
 
 #include "types.h"
+#include "arena.h"
+#include "grid.h"
+
+#include <stdint.h>
 
 /* Tags de direção para mensagens MPI */
 #define TAG_NORTH 0
@@ -23,24 +27,141 @@
 #define DIR_SE 6
 #define DIR_SW 7
 
+/*
+ * Bloco retangular de células em coordenadas de halo (as de CELL_AT).
+ */
+typedef struct {
+    int r0, c0;   /* canto superior esquerdo */
+    int h, w;     /* altura e largura */
+} HaloRect;
+
+/* Direção oposta: N↔S, E↔W, NE↔SW, NW↔SE. */
+int halo_opposite(int dir);
+
+/*
+ * Região do interior enviada ao vizinho `dir` e região de halo
+ * recebida dele, ambas com espessura sg->halo. Mensagens usam
+ * tag = direção do ponto de vista de quem recebe (TAG_* coincide
+ * com DIR_*).
+ */
+HaloRect halo_send_rect(const SubGrid *sg, int dir);
+HaloRect halo_recv_rect(const SubGrid *sg, int dir);
+
+/* Backend da troca de halos, escolhido em tempo de execução (--halo). */
+typedef enum {
+    HALO_ISEND      = 0,  /* MPI_Isend/MPI_Irecv + MPI_Waitall (padrão) */
+    HALO_SHM        = 1,  /* janela compartilhada no nó + mensagens entre nós */
+    HALO_PERSISTENT = 2,  /* MPI_Send_init/MPI_Recv_init + MPI_Startall */
+    HALO_RMA        = 3,  /* MPI_Put direto nos halos do vizinho (PSCW) */
+    HALO_PARTITIONED = 4  /* MPI_Psend_init + MPI_Pready por linha (MPI-4) */
+} HaloMode;
+
+/*
+ * Converte "isend", "shm", "persistent", "rma" ou "partitioned";
+ * retorna -1 se inválido.
+ */
+int halo_parse_mode(const char *name);
+const char *halo_mode_name(HaloMode mode);
+
 #ifdef USE_MPI
 
 /*
- * Cria um MPI_Datatype committed descrevendo a struct Cell.
- * O caller deve chamar MPI_Type_free ao terminar.
+ * Estado persistente do backend de halos.
+ *
+ * No modo HALO_SHM os ranks do mesmo nó (MPI_Comm_split_type com
+ * MPI_COMM_TYPE_SHARED) alocam suas sub-grades numa janela
+ * MPI_Win_allocate_shared. Cada segmento começa com um cabeçalho de
+ * flags (pronto/lido por época) e é seguido das células com halo.
+ * Vizinhos no mesmo nó copiam as bordas direto da memória do outro;
+ * vizinhos em outros nós continuam trocando mensagens.
+ *
+ * No modo HALO_PERSISTENT as 16 requisições e seus buffers de
+ * empacotamento são criados uma vez; cada troca só empacota e chama
+ * MPI_Startall.
+ *
+ * No modo HALO_RMA o array de células com halo passa a morar numa
+ * janela MPI_Win_allocate; cada rank faz MPI_Put das suas bordas direto nos
+ * halos dos vizinhos, com sincronização ativa geral (post/start/
+ * complete/wait) restrita ao grupo dos vizinhos cartesianos. Os
+ * datatypes de origem e destino de cada direção são criados uma vez.
+ *
+ * No modo HALO_PARTITIONED (MPI-4) os envios começam no fim do ciclo
+ * anterior, dentro da regeneração da grade (halo_update_and_send): cada
+ * thread chama MPI_Pready nas linhas de borda assim que as regenera, e
+ * halo_exchange só espera e desempacota. Sem MPI-4 ou sem
+ * MPI_THREAD_MULTIPLE, halo_init recai no modo HALO_PERSISTENT
+ * (halo_effective_mode).
+ */
+typedef struct {
+    HaloMode mode;
+    uint64_t epoch;           /* número de trocas já feitas */
+    MPI_Comm node_comm;       /* ranks do nó (MPI_COMM_NULL fora do shm) */
+    MPI_Win  win;             /* janela shm ou RMA (MPI_WIN_NULL nos demais) */
+    void    *hdr;             /* meu cabeçalho de flags na janela */
+    void    *peer_hdr[8];     /* cabeçalho do vizinho d, ou NULL se remoto */
+    Cell    *heap_cells;      /* array original, devolvido em halo_destroy */
+
+    /* HALO_PERSISTENT */
+    MPI_Request preq[16];
+    int         npreq;
+    void       *psend[8], *precv[8];
+
+    /* HALO_RMA */
+    MPI_Group    nbr_group;
+    MPI_Datatype put_origin[8], put_target[8];
+    MPI_Aint     put_disp[8];
+
+    /* HALO_PARTITIONED (buffers em psend/precv). Recvs e sends densos
+     * em part_req, como preq; part_send[d] é o índice do envio d. */
+    MPI_Request part_req[16];
+    int         npart;
+    int         part_send[8];
+    int         part_peer[8]; /* rank de cada vizinho (--comm-matrix) */
+    int         inflight;     /* envios do ciclo anterior em andamento */
+} HaloCtx;
+
+/*
+ * Backend que halo_init de fato monta para `mode`: HALO_PARTITIONED
+ * recai em HALO_PERSISTENT sem MPI-4 ou sem MPI_THREAD_MULTIPLE; os
+ * demais modos voltam inalterados. Chamar depois de MPI_Init_thread.
+ */
+HaloMode halo_effective_mode(HaloMode mode);
+
+/*
+ * Prepara o backend (no modo halo_effective_mode(mode)). Coletiva em cart_comm. Nos modos HALO_SHM e
+ * HALO_RMA, move as células de sg para a janela (sg->cells passa a
+ * apontar para ela) — chamar depois de subgrid_init.
  */
-MPI_Datatype halo_cell_type(void);
+void halo_init(HaloCtx *ctx, HaloMode mode, SubGrid *sg, Partition *p);
+
+/* Libera o backend e devolve sg->cells ao heap (antes de subgrid_destroy). */
+void halo_destroy(HaloCtx *ctx, SubGrid *sg);
 
 /*
  * Troca células de halo (ghost) com ranks MPI vizinhos.
- * Usa MPI_Isend/MPI_Irecv não-bloqueantes + MPI_Waitall.
  *
- * Trocas:
- *   - N/S: linhas completas (local_w células)
- *   - E/W: colunas completas (local_h células, empacotadas em buffers contíguos)
- *   - Diagonais: célula de canto única
+ * Mensagens usam MPI_Isend/MPI_Irecv não-bloqueantes + MPI_Waitall;
+ * cada uma das 8 regiões (linhas N/S, colunas E/W, cantos diagonais)
+ * é empacotada no formato compacto do fio (pack.h) em buffers da
+ * arena do ciclo. Vizinhos MPI_PROC_NULL são pulados. No modo
+ * HALO_SHM, vizinhos do mesmo nó não geram mensagens.
+ */
+void halo_exchange(HaloCtx *ctx, SubGrid *sg, Partition *p, Arena *arena);
+
+/*
+ * Regenera a grade (subgrid_update, passada fundida com parciais em
+ * gs). No modo HALO_PARTITIONED, com send != 0, também inicia a troca
+ * do próximo ciclo: as linhas de borda partem durante a regeneração.
+ */
+void halo_update_and_send(HaloCtx *ctx, SubGrid *sg, Season season,
+                          int send, GridSweep *gs);
+
+/*
+ * Variante órfã de halo_update_and_send, chamada por todas as threads
+ * de uma região já aberta. Sem barreira no fim (subgrid_update_team).
  */
-void halo_exchange(SubGrid *sg, Partition *p);
+void halo_update_and_send_team(HaloCtx *ctx, SubGrid *sg, Season season,
+                               int send, GridSweep *gs);
 
 #endif /* USE_MPI */
 #endif /* HALO_H */
@@ -0,0 +1,68 @@
+#ifndef HWCOUNT_H
+#define HWCOUNT_H
+
+#include <stdint.h>
+
+/*
+ * Contadores de hardware por fase (--hwcounters), via perf_event_open.
+ *
+ * Cada thread OpenMP abre o próprio grupo (ciclos, instruções, falhas
+ * de LLC, falhas de desvio) só em modo usuário. Nas fronteiras de fase,
+ * cada thread lê o grupo (hw_sample) e soma a diferença desde a leitura
+ * anterior na fase que terminou; hw_take junta as threads. A diferença
+ * inclui a espera da thread na barreira que fecha a fase.
+ *
+ * Os grupos ficam presos às threads que os abriram: o runtime OpenMP
+ * reaproveita as mesmas threads em regiões de mesmo tamanho, como as do
+ * ciclo. Fora do Linux, ou sem permissão (perf_event_paranoid, PMU
+ * ausente numa VM), hw_init falha e o modo fica desligado.
+ */
+
+enum {
+    HW_CYCLES = 0,
+    HW_INSTRUCTIONS,
+    HW_LLC_MISSES,
+    HW_BRANCH_MISSES,
+    HW_EVENTS
+};
+
+#define HW_MAX_PHASES 16
+#define HW_LINE_BYTES 64   /* bytes trazidos da memória por falha de LLC */
+
+extern int hw_enabled;
+
+/*
+ * Abre os grupos de todas as threads da equipe padrão (fora de regiões
+ * paralelas). Retorna 0, ou -1 e um motivo curto em *why.
+ */
+int hw_init(int nphases, const char **why);
+
+/* Leitura-base da thread chamadora (início de região). */
+void hw_mark_thread(void);
+
+/* Soma ao acumulador de `phase` o que a thread contou desde a última
+ * leitura. */
+void hw_sample_thread(int phase);
+
+static inline void hw_mark(void) {
+    if (hw_enabled) hw_mark_thread();
+}
+
+static inline void hw_sample(int phase) {
+    if (hw_enabled) hw_sample_thread(phase);
+}
+
+/* Soma das threads por fase em out[fase][evento], e zera os
+ * acumuladores (fora de regiões paralelas). */
+void hw_take(uint64_t out[][HW_EVENTS]);
+
+/*
+ * Banda de memória de pico do rank, em GB/s: tríade estilo STREAM
+ * (a[i] = b[i] + s*c[i], 24 bytes por elemento) com todas as threads,
+ * melhor de algumas repetições.
+ */
+double hw_stream_peak(void);
+
+void hw_shutdown(void);
+
+#endif /* HWCOUNT_H */
@@ -0,0 +1,51 @@
+#ifndef LPT_H
+#define LPT_H
+
+#include "arena.h"
+#include <stdint.h>
+
+/*
+ * Escalonamento LPT (Longest Processing Time first) com roubo de tarefas
+ * — usado pela carga sintética com --workload-sched lpt.
+ *
+ * O custo de cada tarefa é conhecido antes da execução (iterações de
+ * workload_compute). lpt_build ordena as tarefas por custo decrescente
+ * (counting sort em LPT_BUCKETS faixas) e as distribui em zigue-zague
+ * entre as filas das threads, cada uma começando pelas maiores. Cada
+ * thread consome a própria fila pela frente; quando ela esvazia, rouba
+ * pelo fundo das filas alheias — as menores tarefas restantes, que
+ * aparam a cauda sem desfazer a ordem LPT.
+ *
+ * Cada fila é um intervalo [head, tail) de `items` com as duas pontas
+ * num único uint64_t atualizado por compare-and-swap: dono e ladrões
+ * nunca pegam a mesma tarefa, sem travas.
+ */
+
+#define LPT_BUCKETS 64
+
+typedef struct {
+    uint64_t ht;                     /* head << 32 | tail */
+    char     pad[64 - sizeof(uint64_t)];
+} LptQueue;
+
+typedef struct {
+    int      *items;   /* índices das tarefas, por fila */
+    LptQueue *queues;  /* uma por thread, alinhadas a 64 bytes */
+    int       nqueues;
+    int       ntasks;  /* tarefas com custo > 0 */
+} LptPlan;
+
+/*
+ * Monta o plano para as n tarefas de custo cost[i] (em [0, max_cost];
+ * custo 0 fica de fora) e nqueues filas. Serial; memória da arena.
+ */
+void lpt_build(LptPlan *plan, const int *cost, int n, int max_cost,
+               int nqueues, Arena *arena);
+
+/*
+ * Próxima tarefa da thread `self`: a frente da própria fila ou, vazia,
+ * o fundo da próxima fila não vazia. Retorna -1 quando tudo acabou.
+ */
+int lpt_next(LptPlan *plan, int self);
+
+#endif /* LPT_H */
@@ -2,10 +2,13 @@
 #define METRICS_H
 
 #include "types.h"
+#include "arena.h"
+#include "grid.h"
 
 /* Métricas agregadas da simulação */
 typedef struct {
     double total_resource;
+    double type_resource[CELL_TYPES];   /* histograma do recurso por tipo */
     double avg_energy;
     double max_energy;
     double min_energy;
@@ -13,19 +16,22 @@ typedef struct {
 } SimMetrics;
 
 /* Desempenho por ciclo para o dashboard TUI.
- * Os 9 campos double de timing ficam contíguos no início da struct
- * para permitir um único MPI_Reduce sobre todos eles. */
+ * Os CYCLEPERF_NTIMES campos double de timing ficam contíguos no início
+ * da struct para permitir um único MPI_Reduce sobre todos eles. */
 typedef struct {
     /* ── timing fields (contiguous doubles for single MPI_Reduce) ── */
     double cycle_time;
-    double season_time;     /* MPI_Bcast + accessibility loop           */
+    double season_time;     /* troca do plano de acessibilidade         */
     double halo_time;
     double workload_time;   /* synthetic busy-loop only                 */
     double agent_time;      /* agent decision logic only                */
+    double reproduce_time;  /* agents_reproduce (count/scan/write)      */
     double grid_time;       /* subgrid_update only                      */
     double migrate_time;
     double metrics_time;
     double render_time;
+    double overlap_time;    /* comunicação escondida (--comm-thread)     */
+    double spread_time;     /* 1º ao último fim da carga entre threads  */
     /* ── derived / metadata (after timing doubles) ── */
     int    mpi_size;
     int    omp_threads;
@@ -33,19 +39,37 @@ typedef struct {
     double comm_compute;
 } CyclePerf;
 
+#define CYCLEPERF_NTIMES 12
+
 #include <stddef.h>
 _Static_assert(
-    offsetof(CyclePerf, render_time) + sizeof(double) ==
+    offsetof(CyclePerf, spread_time) ==
+    offsetof(CyclePerf, cycle_time) + (CYCLEPERF_NTIMES - 1) * sizeof(double),
+    "CYCLEPERF_NTIMES must match the number of timing fields"
+);
+_Static_assert(
+    offsetof(CyclePerf, spread_time) + sizeof(double) ==
     offsetof(CyclePerf, mpi_size),
     "CyclePerf timing fields must be contiguous for MPI_Reduce"
 );
 
 /*
- * Calcula métricas locais a partir da sub-grade e do array de agentes.
- * Soma recursos apenas sobre as células interiores (sem halo).
+ * Calcula métricas locais a partir da sub-grade e do pool de agentes.
+ * Soma recursos (total e por tipo) apenas sobre as células interiores.
+ * Com gs != NULL, usa as parciais da passada fundida do ciclo
+ * (subgrid_update) em vez de reler a grade. Paralela: parciais por linha
+ * e por bloco de slots (da arena do ciclo) somados em ordem fixa, então
+ * o resultado não depende das threads.
  */
-void metrics_compute_local(const SubGrid *sg, const Agent *agents,
-                           int count, SimMetrics *local);
+void metrics_compute_local(const SubGrid *sg, const AgentPool *pool,
+                           const GridSweep *gs, SimMetrics *local,
+                           Arena *arena);
+
+/* Variante órfã, para uma região paralela já aberta; termina com
+ * barreira e *local preenchido. */
+void metrics_compute_local_team(const SubGrid *sg, const AgentPool *pool,
+                                const GridSweep *gs, SimMetrics *local,
+                                Arena *arena);
 
 #ifdef USE_MPI
 /*
@@ -53,10 +77,13 @@ void metrics_compute_local(const SubGrid *sg, const Agent *agents,
  *
  * Reduções:
  *   total_resource → MPI_SUM
+ *   type_resource  → MPI_SUM
  *   alive_agents   → MPI_SUM
  *   max_energy     → MPI_MAX
  *   min_energy     → MPI_MIN
  *   avg_energy     → (soma das energias) / (soma dos vivos)
+ * Feitas em duas chamadas: um vetor MPI_SUM e um MPI_MAX com o mínimo
+ * negado.
  */
 void metrics_reduce_global(const SimMetrics *local, SimMetrics *global,
                            MPI_Comm comm);
@@ -2,29 +2,34 @@
 #define MIGRATE_H
 
 #include "types.h"
+#include "arena.h"
 
 #ifdef USE_MPI
 
 /*
- * Cria um MPI_Datatype committed descrevendo a struct Agent.
- * O caller deve chamar MPI_Type_free ao terminar.
- */
-MPI_Datatype migrate_agent_type(void);
-
-/*
- * Migra agentes cuja posição global (gx, gy) saiu da partição local
+ * Migra agentes cuja posição saiu do interior da partição local
  * para o rank correto.
  *
  * Protocolo em duas fases:
  *   Fase 1 — MPI_Alltoall para trocar contagens por rank.
- *   Fase 2 — MPI_Alltoallv para trocar structs Agent.
+ *   Fase 2 — MPI_Alltoallv para trocar WireAgent (pack.h), com
+ *            coordenadas relativas à sub-grade do destino.
  *
- * Ao retornar, o array local é compactado: migrantes removidos,
- * recebidos anexados. *count e *capacity são atualizados.
+ * Ao retornar, migrantes estão marcados como mortos no pool e os
+ * recebidos foram anexados; a compactação é amortizada
+ * (pool_maybe_compact). Buffers temporários vêm da arena do ciclo.
+ */
+void migrate_agents(AgentPool *pool, Partition *p, SubGrid *sg,
+                    int global_w, int global_h, Arena *arena);
+
+/*
+ * Variante para halo profundo (--halo-depth K > 1), chamada a cada K
+ * ciclos: em vez de migrar, descarta os agentes fora do interior (já
+ * recomputados pelo dono) e replica nos vizinhos os agentes do interior
+ * que estão a até sg->halo células da borda, como fantasmas.
  */
-void migrate_agents(Agent **agents, int *count, int *capacity,
-                    Partition *p, SubGrid *sg,
-                    int global_w, int global_h);
+void migrate_sync_ring(AgentPool *pool, Partition *p, SubGrid *sg,
+                       int global_w, int global_h, Arena *arena);
 
 #endif /* USE_MPI */
 #endif /* MIGRATE_H */
@@ -0,0 +1,55 @@
+#ifndef MPIPROF_H
+#define MPIPROF_H
+
+#include <stdio.h>
+#include <mpi.h>
+
+/*
+ * Espera × transferência no MPI (--wait-report).
+ *
+ * mpiprof.c redefine MPI_Allreduce, MPI_Alltoall, MPI_Alltoallv e
+ * MPI_Waitall sobre a interface PMPI. Desligadas, só repassam a chamada.
+ * Ligadas, cada coletiva é precedida de um PMPI_Barrier no mesmo
+ * comunicador: o tempo na barreira é espera pelos ranks atrasados e o
+ * tempo da coletiva depois dela é transferência. MPI_Waitall (halos,
+ * ponto a ponto) não tem barreira possível; todo o tempo bloqueado
+ * conta como espera.
+ *
+ * A barreira extra atrasa um pouco as coletivas: os tempos de fase deste
+ * modo não são comparáveis aos de uma execução sem ele.
+ *
+ * Uma vez por ciclo, waitrep_cycle junta no rank 0 os tempos de fase e a
+ * espera de cada rank; no fim, waitrep_print mostra percentis por fase,
+ * o custo do desbalanceamento e o rank no caminho crítico de cada ciclo.
+ */
+
+typedef enum {
+    MPROF_ALLREDUCE = 0,
+    MPROF_ALLTOALL,
+    MPROF_ALLTOALLV,
+    MPROF_WAITALL,
+    MPROF_OPS
+} MpiProfOp;
+
+/* Liga/desliga a separação. Chamar em todos os ranks no mesmo ponto. */
+void mpiprof_enable(int on);
+
+/* Espera acumulada (s) desde a última chamada, e zera o acumulador. */
+double mpiprof_take_wait(void);
+
+/*
+ * Prepara o relatório para `nphases` fases com nomes `names`. Coletiva
+ * em comm.
+ */
+void waitrep_begin(int nphases, const char *const *names, MPI_Comm comm);
+
+/*
+ * Registra um ciclo: times[nphases] (s) e o tempo total do ciclo neste
+ * rank. A espera vem de mpiprof_take_wait. Coletiva em comm.
+ */
+void waitrep_cycle(const double *times, double cycle_time, MPI_Comm comm);
+
+/* Imprime o relatório (rank 0) e libera a memória. Coletiva em comm. */
+void waitrep_print(FILE *out, MPI_Comm comm);
+
+#endif /* MPIPROF_H */
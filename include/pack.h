@@ -0,0 +1,88 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include "types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Camada de empacotamento compartilhada por todos os caminhos MPI
+ * (halos, migração e coletas da TUI).
+ *
+ * Célula no fio: 1 byte de tag (tipo nos bits 0..6; a acessibilidade é
+ * derivada do tipo no destino, pelos planos da estação) seguido do
+ * recurso na precisão escolhida. max_resource não viaja: é derivado do
+ * tipo no destino (grid_max_resource).
+ *
+ * Agente no fio: id de 64 bits, energia float e coordenadas de 16 bits
+ * relativas a uma sub-grade conhecida pelos dois lados (coordenadas de
+ * halo do destino na migração, interior da origem na coleta da TUI).
+ */
+
+typedef enum {
+    WIRE_DOUBLE  = 0,   /* recurso como double — sem perda (padrão) */
+    WIRE_FLOAT   = 1,   /* recurso como float                        */
+    WIRE_FIXED16 = 2    /* recurso em ponto fixo: fração de max em 16 bits */
+} WireQuant;
+
+typedef struct {
+    uint64_t id;
+    float    energy;
+    uint16_t x;
+    uint16_t y;
+} WireAgent;
+
+_Static_assert(sizeof(WireAgent) == 16,
+               "WireAgent deve ocupar 16 bytes sem padding interno");
+
+/* Fases contabilizadas no contador de bytes enviados. */
+typedef enum {
+    WIRE_PHASE_HALO    = 0,
+    WIRE_PHASE_MIGRATE = 1,
+    WIRE_PHASE_GATHER  = 2,
+    WIRE_PHASE_COUNT
+} WirePhase;
+
+/* Seleciona a quantização das células. Chamar antes de pack_types_init. */
+void pack_set_quant(WireQuant q);
+WireQuant pack_quant(void);
+
+/* Converte "double", "float" ou "fixed16"; retorna -1 se inválido. */
+int pack_parse_quant(const char *name);
+
+/* Bytes de uma célula no fio, para a quantização corrente. */
+size_t pack_cell_bytes(void);
+
+/*
+ * Empacota/desempacota um bloco h × w de células que começa em `base`,
+ * com `stride` células entre linhas consecutivas.
+ * Retornam o número de bytes escritos/lidos.
+ */
+size_t pack_cells(const Cell *base, int stride, int h, int w, void *buf);
+size_t unpack_cells(Cell *base, int stride, int h, int w, const void *buf);
+
+/*
+ * Copia um bloco h × w de células de memória para memória com o mesmo
+ * resultado de pack_cells + unpack_cells, sem buffer intermediário
+ * (cópias entre ranks do nó no --halo shm). Não conta bytes no fio.
+ */
+void pack_copy_cells(Cell *dst, int dstride, const Cell *src, int sstride,
+                     int h, int w);
+
+/* Contador de bytes enviados por fase (zerado a cada ciclo pelo caller). */
+void pack_bytes_add(WirePhase ph, uint64_t bytes);
+void pack_bytes_reset(void);
+void pack_bytes_get(uint64_t out[WIRE_PHASE_COUNT]);
+
+#ifdef USE_MPI
+/*
+ * Cria e commita uma única vez os datatypes do fio (célula e agente).
+ * Os getters devolvem os handles em cache; não chame MPI_Type_free neles.
+ */
+void pack_types_init(void);
+void pack_types_free(void);
+MPI_Datatype pack_cell_type(void);
+MPI_Datatype pack_agent_type(void);
+#endif /* USE_MPI */
+
+#endif /* PACK_H */
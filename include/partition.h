@@ -17,6 +17,15 @@ void partition_init(Partition *p, int global_w, int global_h,
                     int comm);
 #endif
 
+/*
+ * Grade global em que cada um dos `size` ranks recebe exatamente
+ * local_w × local_h células sob a fatoração de partition_init
+ * (--cells-per-rank): px * local_w × py * local_h, na orientação que
+ * partition_init escolheria para essa grade.
+ */
+void partition_weak_dims(int size, int local_w, int local_h,
+                         int *global_w, int *global_h);
+
 /*
  * Calcula dimensões locais da sub-grade e offsets globais deste rank.
  * O trabalho é dividido uniformemente; a última coluna/linha absorve o resto.
@@ -25,6 +34,15 @@ void partition_subgrid_dims(const Partition *p, int global_w, int global_h,
                             int *local_w, int *local_h,
                             int *offset_x, int *offset_y);
 
+/*
+ * Como partition_subgrid_dims, mas para um rank arbitrário do
+ * comunicador cartesiano (usado para coordenadas relativas no fio).
+ */
+void partition_rank_dims(const Partition *p, int rank,
+                         int global_w, int global_h,
+                         int *local_w, int *local_h,
+                         int *offset_x, int *offset_y);
+
 /*
  * Retorna o rank MPI que possui a célula nas coordenadas globais (gx, gy).
  */
@@ -0,0 +1,47 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "types.h"
+#include <stdint.h>
+
+/* Inicializa um pool vazio com capacidade inicial `capacity`. */
+void pool_init(AgentPool *pool, int capacity);
+
+/* Libera os arrays SoA (o AgentPool em si é alocado na stack). */
+void pool_destroy(AgentPool *pool);
+
+/* Garante capacidade para pelo menos `capacity` slots (crescimento amortizado). */
+void pool_reserve(AgentPool *pool, int capacity);
+
+/*
+ * Anexa um agente vivo ao final do pool e retorna seu slot.
+ * (x, y) em coordenadas de halo do SubGrid (as mesmas de CELL_AT).
+ */
+int pool_push(AgentPool *pool, uint64_t id, int x, int y, float energy);
+
+/* Marca os slots [lo, hi) como vivos (serial, palavra a palavra). */
+void pool_revive_range(AgentPool *pool, int lo, int hi);
+
+/* Número de agentes vivos (popcount do bitmask). */
+int pool_live(const AgentPool *pool);
+
+/*
+ * Remove slots mortos preservando a ordem relativa dos vivos.
+ * pool_maybe_compact só compacta quando ao menos 1/4 dos slots
+ * está morto, amortizando o custo ao longo dos ciclos.
+ */
+void pool_compact(AgentPool *pool);
+void pool_maybe_compact(AgentPool *pool);
+
+static inline int pool_alive(const AgentPool *pool, int i) {
+    return (int)((pool->alive[i >> 6] >> (i & 63)) & 1u);
+}
+
+/* Marca o slot i como morto. Seguro sob OpenMP (palavras compartilhadas). */
+static inline void pool_kill(AgentPool *pool, int i) {
+    uint64_t mask = ~(1ULL << (i & 63));
+    #pragma omp atomic
+    pool->alive[i >> 6] &= mask;
+}
+
+#endif /* POOL_H */
@@ -21,4 +21,10 @@ double rng_double(RngState *state);
  */
 uint64_t rng_cell_seed(uint64_t base_seed, int gx, int gy);
 
+/*
+ * Seed por agente e ciclo: o desempate de um agente depende só do seu
+ * id, nunca da ordem de processamento, da thread ou do rank.
+ */
+uint64_t rng_agent_seed(uint64_t base_seed, uint64_t id, int cycle);
+
 #endif /* RNG_H */
@@ -3,8 +3,26 @@
 
 #include "types.h"
 
+/* Entradas máximas de um calendário (--seasons). */
+#define SEASON_MAX_ENTRIES 16
+
+/*
+ * Define o calendário de estações a partir de uma lista "nome[:ciclos],...",
+ * ex.: "dry,wet" ou "rising:5,wet:10,falling:5,dry:10". Entradas sem
+ * duração usam default_length. O calendário se repete indefinidamente.
+ * Retorna 0, ou -1 se a lista for inválida (o calendário não muda).
+ * Determinístico: cada rank o monta localmente, sem comunicação.
+ */
+int season_schedule_set(const char *spec, int default_length);
+
 /* Determina a estação para um dado ciclo de simulação. */
-Season season_for_cycle(int cycle, int season_length);
+Season season_for_cycle(int cycle);
+
+/* Nome curto da estação ("dry", "wet", "rising", "falling"). */
+const char *season_name(Season s);
+
+/* Estação pelo nome, ou -1. */
+int season_parse(const char *name);
 
 /*
  * Verifica se um tipo de célula é acessível na estação dada.
@@ -0,0 +1,26 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include "types.h"
+#include "arena.h"
+
+/*
+ * Execução do ciclo como grafo de tarefas por tile (--tasks).
+ *
+ * O array com halo é dividido em tiles de tile × tile células e cada
+ * fase local vira uma tarefa OpenMP por tile, encadeada por `depend`
+ * no próprio tile e nos 8 vizinhos:
+ *   W[t] carga sintética dos agentes em t        (lê células de t)
+ *   D[t] decisão dos agentes em t                (lê células dos vizinhos)
+ *   C[t] consumo das células de t                (espera D dos vizinhos)
+ *   R[t] regeneração das células de t ∩ caixa    (depois de C[t])
+ * Tiles diferentes avançam sem barreiras entre fases: W, D e R de
+ * tiles distintos se sobrepõem. O resultado é idêntico ao do laço por
+ * fases (agents_workload + agents_decide_all + subgrid_update), com a
+ * reprodução feita depois, pelo caller, como no laço por fases. Retorna
+ * os ids de filho por slot, como agents_decide_all.
+ */
+uint64_t *taskgraph_step(AgentPool *pool, SubGrid *sg, Season season,
+                         const SimConfig *cfg, int cycle, Arena *arena);
+
+#endif /* TASKGRAPH_H */
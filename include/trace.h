@@ -0,0 +1,91 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+/*
+ * Linha do tempo por rank e por thread (--trace PATH).
+ *
+ * Cada thread OpenMP grava eventos (fase, início, fim, ciclo) num anel
+ * próprio; sem travas no caminho quente. Quando o anel enche, os eventos
+ * mais antigos são sobrescritos e contados como perdidos. trace_flush
+ * junta os anéis de todos os ranks no rank 0, que os acrescenta ao
+ * arquivo no formato Chrome Trace (JSON, abre no Perfetto ou em
+ * chrome://tracing): pid = rank, tid = thread OpenMP (somada ao tamanho
+ * da equipe na equipe aninhada do --comm-thread).
+ *
+ * Desligado, cada ponto de medição custa um teste de inteiro global.
+ */
+
+typedef enum {
+    TR_CYCLE = 0,
+    TR_SEASON,
+    TR_HALO,
+    TR_WORKLOAD,
+    TR_LPT_PLAN,
+    TR_DECIDE,
+    TR_REPRODUCE,
+    TR_MIGRATE,
+    TR_GRID,
+    TR_METRICS,
+    TR_REDUCE,      /* reduções de métricas e de desempenho */
+    TR_OUTPUT,      /* TUI e CSV                            */
+    TR_TASKS,       /* grafo de tarefas (--tasks)           */
+    TR_AUTOTUNE,
+    TR_MPI_WAIT,    /* espera no MPI (--wait-report)         */
+    TR_PHASES
+} TracePhase;
+
+#define TRACE_RING_EVENTS (1 << 15)   /* eventos por thread */
+#define TRACE_MAX_THREADS 256
+
+extern int trace_enabled;
+
+/* Relógio do rastro (segundos); 0 quando desligado. */
+double trace_clock(void);
+
+/* Grava um evento da thread chamadora, de t0 até agora. */
+void trace_record(TracePhase ph, double t0);
+
+/* Ciclo atribuído aos próximos eventos (chamada fora de regiões paralelas). */
+void trace_set_cycle(int cycle);
+
+static inline double trace_begin(void) {
+    return trace_enabled ? trace_clock() : 0.0;
+}
+
+static inline void trace_end(TracePhase ph, double t0) {
+    if (trace_enabled)
+        trace_record(ph, t0);
+}
+
+/*
+ * TRACE_SCOPE(fase) { ... } — mede o bloco. Não use break/return/goto
+ * para sair do bloco (o fim não seria gravado).
+ */
+#define TRACE_SCOPE(ph)                                                \
+    for (double _trace_t0 = trace_begin(), _trace_once = 1.0;          \
+         _trace_once != 0.0;                                           \
+         _trace_once = 0.0, trace_end((ph), _trace_t0))
+
+#ifdef USE_MPI
+/*
+ * Liga o rastro. Coletiva em comm: sincroniza a origem dos relógios com
+ * uma barreira; o rank 0 abre `path` e escreve o cabeçalho. Retorna 0,
+ * ou -1 (em todos os ranks) se o arquivo não abre.
+ */
+int trace_init(const char *path, MPI_Comm comm);
+
+/* Esvazia os anéis de todos os ranks no arquivo. Coletiva em comm. */
+void trace_flush(MPI_Comm comm);
+
+/*
+ * Último flush, fecha o JSON e retorna (no rank 0) o total de eventos
+ * perdidos por anel cheio, somado entre os ranks. Coletiva em comm.
+ */
+long long trace_finalize(MPI_Comm comm);
+#endif
+
+#endif /* TRACE_H */
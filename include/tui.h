@@ -3,6 +3,7 @@
 
 #include "types.h"
 #include "metrics.h"
+#include "arena.h"
 
 
 typedef enum {
@@ -44,20 +45,25 @@ int tui_poll_input(TuiControl *ctrl);
  * para layout espacial (row-major) da grade global.
  *
  * Apenas rank 0 escreve em full_grid (deve ser pré-alocado com
- * global_w * global_h células). Demais ranks enviam células interiores.
+ * global_w * global_h células). Demais ranks enviam células interiores
+ * no formato compacto do fio (pack.h); sub-grades de tamanhos
+ * diferentes são suportadas.
  */
 void tui_gather_grid(SubGrid *sg, Partition *p,
                      Cell *full_grid, int global_w, int global_h,
-                     MPI_Comm comm);
+                     MPI_Comm comm, Arena *arena);
 
 /*
- * Coleta todos os agentes no rank 0.
- * No rank 0: *all_agents é alocado com malloc e deve ser liberado pelo caller.
+ * Coleta todos os agentes vivos no rank 0, em coordenadas globais.
+ * Só agentes do interior viajam, como WireAgent relativos à origem do
+ * interior; o rank 0 converte usando a origem de cada rank na partição.
+ * No rank 0: *all_agents é alocado na arena do ciclo (não liberar).
  * Nos demais ranks: *all_agents é definido como NULL.
  */
-void tui_gather_agents(Agent *local_agents, int local_count,
+void tui_gather_agents(const AgentPool *pool, const SubGrid *sg,
+                       const Partition *p, int global_w, int global_h,
                        Agent **all_agents, int *total_count,
-                       MPI_Comm comm);
+                       MPI_Comm comm, Arena *arena);
 
 #endif /* USE_MPI */
 
@@ -84,11 +90,12 @@ void tui_set_output_file(const char *path);
  *   > 0.66 * max → brilhante, > 0.33 * max → normal, senão → escuro
  *
  * Grades maiores que 80x40 são reduzidas por downsampling.
+ * O mapa de presença de agentes é alocado na arena do ciclo.
  */
 void tui_render(Cell *full_grid, int global_w, int global_h,
                 Agent *all_agents, int total_agents,
                 int cycle, int total_cycles,
                 Season season, SimMetrics *metrics,
-                CyclePerf *perf, TuiControl *ctrl);
+                CyclePerf *perf, TuiControl *ctrl, Arena *arena);
 
 #endif /* TUI_H */
@@ -15,39 +15,87 @@ typedef enum {
     INTERDITADA = 4   /* Interditada — nunca acessível */
 } CellType;
 
+#define CELL_TYPES 5
+
 typedef enum {
-    DRY = 0,
-    WET = 1
+    DRY     = 0,
+    WET     = 1,
+    RISING  = 2,  /* enchente — calendários com --seasons */
+    FALLING = 3   /* vazante */
 } Season;
 
+#define SEASON_COUNT 4
+
+/*
+ * Cell — estado variável de uma célula. A acessibilidade não fica aqui:
+ * só depende do tipo e da estação, e vem dos planos de bits do SubGrid.
+ */
 typedef struct {
     CellType type;
     double   resource;
     double   max_resource;
-    int      accessible;
 } Cell;
 
+/*
+ * Agent — registro de um agente em coordenadas globais.
+ * Usado como formato de troca (migração, coleta da TUI); o estado
+ * local de cada rank fica no AgentPool.
+ */
 typedef struct {
-    int    id;
-    int    gx;       /* coordenada global x */
-    int    gy;       /* coordenada global y */
-    double energy;
-    int    alive;
+    uint64_t id;
+    int32_t  gx;     /* coordenada global x */
+    int32_t  gy;     /* coordenada global y */
+    float    energy;
 } Agent;
 
+/*
+ * AgentPool — agentes locais em layout SoA (structure of arrays).
+ * Coordenadas (x, y) são relativas ao array com halo do SubGrid,
+ * as mesmas de CELL_AT, e cabem em 16 bits. Agentes mortos ficam
+ * marcados no bitmask `alive` até a próxima compactação amortizada
+ * (ver pool.h). Ids são globais e independentes da decomposição:
+ * iniciais são o índice na sequência de posicionamento, filhos vêm
+ * do ciclo, da célula e da ordem de consumo do pai (agent_child_id).
+ */
+typedef struct {
+    uint64_t *id;
+    uint16_t *x;         /* coluna no array com halo */
+    uint16_t *y;         /* linha no array com halo  */
+    float    *energy;
+    uint64_t *alive;     /* bit i de alive[i / 64] ↔ slot i */
+    int       count;     /* slots ocupados (vivos + mortos) */
+    int       capacity;
+} AgentPool;
+
 /*
  * SubGrid — partição local de cada rank MPI.
- * O array cells é um buffer plano com 1 célula de halo em cada lado,
- * portanto suas dimensões são (local_h + 2) * (local_w + 2).
+ * O array cells é um buffer plano com `halo` células de halo em cada
+ * lado, portanto suas dimensões são (local_h + 2*halo) * (local_w + 2*halo).
+ * O interior ocupa linhas/colunas [halo, halo + local_h/w).
+ *
+ * A caixa [box_r0..box_r1] × [box_c0..box_c1] é a região avançada
+ * localmente a cada ciclo (estação e regeneração): o interior quando
+ * halo == 1, ou interior + anel nos lados com vizinho nos halos
+ * profundos (--halo-depth), em que o anel é recomputado localmente.
+ *
+ * access_planes guarda SEASON_COUNT planos de bits de acessibilidade
+ * (1 bit por célula do array com halo), montados na partida a partir da
+ * camada estática de tipos; `access` aponta para o plano da estação
+ * corrente, e a virada de estação é só a troca desse ponteiro.
  */
 typedef struct {
     int   local_w;
     int   local_h;
     int   offset_x;   /* origem global x desta partição */
     int   offset_y;   /* origem global y desta partição */
-    int   halo_w;     /* = local_w + 2 */
-    int   halo_h;     /* = local_h + 2 */
+    int   halo;       /* largura do halo (1, ou 2K com --halo-depth K) */
+    int   halo_w;     /* = local_w + 2*halo */
+    int   halo_h;     /* = local_h + 2*halo */
+    int   box_r0, box_r1, box_c0, box_c1;  /* inclusivos */
     Cell *cells;      /* array plano de tamanho halo_h * halo_w */
+    uint64_t       *access_planes;  /* SEASON_COUNT * plane_words */
+    const uint64_t *access;         /* plano da estação corrente */
+    int             plane_words;    /* palavras de 64 bits por plano */
 } SubGrid;
 
 typedef struct {
@@ -67,6 +115,34 @@ typedef struct {
     int      tui_enabled;
     int      tui_interval;
     int      csv_output;
+    int      alloc_stats;          /* relatório de alocações por fase */
+    int      wire_quant;           /* WireQuant das células no fio (pack.h) */
+    int      halo_mode;            /* HaloMode do backend de halos (halo.h) */
+    int      halo_depth;           /* ciclos entre trocas de halo/agentes */
+    int      comm_thread;          /* thread OpenMP dedicada ao MPI */
+    int      exec_tasks;           /* grafo de tarefas por tile (--tasks) */
+    int      tile_size;            /* lado do tile em células */
+    char     seasons[128];         /* calendário de estações (season.h) */
+    int      autotune;             /* ciclos de autotuning (0 = desligado) */
+    char     tune_file[256];       /* escalonamentos (autotune.h) */
+    int      workload_lpt;         /* carga em ordem LPT (--workload-sched) */
+    int      workload_profile;     /* WorkloadProfile da carga (workload.h) */
+    int      trace_every;          /* ciclos entre flushes do rastro (0 = fim) */
+    char     trace_file[256];      /* linha do tempo Chrome Trace (trace.h) */
+    int      wait_report;          /* espera × transferência no MPI (mpiprof.h) */
+    int      hwcounters;           /* contadores de hardware (hwcount.h) */
+    char     comm_matrix[256];     /* matriz de comunicação (commmat.h) */
+    int      bench_reps;           /* repetições do --bench (benchrun.h) */
+    int      bench_warmup;         /* ciclos descartados por repetição */
+    double   bench_ref;            /* taxa de 1 núcleo para a eficiência */
+    char     bench_json[256];      /* destino do JSON (vazio = stdout) */
+    int      rank_w, rank_h;       /* sub-grade por rank (--cells-per-rank) */
+    int      agents_per_rank;      /* população por rank (0 = usa -a) */
+    int      weak_scaling;         /* varredura 1, 2, 4, ... ranks */
+    int      model;                /* carga em tempo virtual (vtime.h) */
+    double   model_ns;             /* ns por iteração (0 = calibra) */
+    int      model_threads;        /* threads do modelo (0 = as da execução) */
+    int      digest_every;         /* ciclos entre resumos do estado (digest.h) */
     char     tui_file[256];
 } SimConfig;
 
@@ -87,8 +163,8 @@ typedef struct {
 
 /*
  * CELL_AT — índice no array plano com halo.
- * r e c estão em coordenadas de halo (0 = linha/coluna de halo,
- * interior começa em (1,1)).
+ * r e c estão em coordenadas de halo (0 = primeira linha/coluna de
+ * halo, interior começa em (halo, halo)).
  */
 #define CELL_AT(sg, r, c) ((r) * (sg)->halo_w + (c))
 
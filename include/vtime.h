@@ -0,0 +1,40 @@
+#ifndef VTIME_H
+#define VTIME_H
+
+/*
+ * Tempo virtual da carga sintética (--model).
+ *
+ * Com o modo ligado, workload_compute não executa o laço: só cobra as
+ * iterações na thread chamadora e retorna. O resto do ciclo (halos,
+ * migração, decisão, grade, métricas) roda de verdade. A cada ciclo,
+ * vtime_take converte o que o rank cobrou em tempo para `threads`
+ * threads: max(W / threads, m) × ns por iteração, com W as iterações do
+ * rank e m as do agente mais caro (o limite de uma divisão perfeita da
+ * carga entre as threads).
+ *
+ * O custo por iteração vem de vtime_calibrate (o kernel do perfil de
+ * carga corrente, medido antes de ligar o modo) ou de --model-ns.
+ */
+
+extern int vtime_enabled;
+
+/* ns por iteração nominal do perfil de carga neste núcleo (melhor
+ * de 3). */
+double vtime_calibrate(void);
+
+/* Liga o modo com o custo e o número de threads do modelo (fora de
+ * regiões paralelas). */
+void vtime_init(double ns_per_iter, int threads);
+
+/* Cobra `iters` iterações na thread chamadora (chamada por
+ * workload_compute quando vtime_enabled). */
+void vtime_charge(int iters);
+
+/* Tempo modelado (s) do que foi cobrado desde a última chamada, e as
+ * iterações em *iters; zera os acumuladores (fora de regiões
+ * paralelas). */
+double vtime_take(double *iters);
+
+void vtime_shutdown(void);
+
+#endif /* VTIME_H */
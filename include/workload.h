@@ -1,14 +1,57 @@
 #ifndef WORKLOAD_H
 #define WORKLOAD_H
 
+/*
+ * Perfis da carga sintética (--workload-profile). Todos são cobrados em
+ * iterações nominais (resource * max_iters), e cada perfil é calibrado
+ * na partida para que uma iteração custe o mesmo que uma do laço
+ * compute neste núcleo:
+ *
+ *   compute     laço escalar com dependência (o original)
+ *   memory      leituras independentes em posições aleatórias de uma
+ *               tabela por thread maior que a cache (limitado por banda)
+ *   chase       percurso de ponteiros num ciclo aleatório por thread
+ *               (cada leitura depende da anterior: limitado por latência)
+ *   stochastic  laço compute com custo sorteado: nominal × Exp(1), com a
+ *               mesma média mas só frouxamente ligado ao recurso
+ */
+typedef enum {
+    WL_COMPUTE    = 0,
+    WL_MEMORY     = 1,
+    WL_CHASE      = 2,
+    WL_STOCHASTIC = 3,
+    WL_PROFILE_COUNT
+} WorkloadProfile;
+
+/* Nome → perfil; -1 se desconhecido. */
+int workload_parse_profile(const char *name);
+const char *workload_profile_name(WorkloadProfile p);
+
+/*
+ * Seleciona o perfil: aloca as tabelas por thread (primeiro toque na
+ * thread dona) e calibra os passos por iteração nominal. Fora de regiões
+ * paralelas; WL_COMPUTE não aloca nem calibra.
+ */
+void workload_set_profile(WorkloadProfile p);
+
+/* Passos do kernel do perfil por iteração nominal (1 no compute). */
+double workload_profile_scale(void);
+
 /*
  * Executa carga de trabalho sintética proporcional ao nível de recurso
  * da célula. Simula custo computacional variável por célula para
  * exercitar estratégias de balanceamento de carga.
  *
  * Retorna um resultado volatile para impedir o compilador de
- * otimizar o loop.
+ * otimizar o loop. Com o tempo virtual (--model, vtime.h), o laço não
+ * roda: as iterações só são cobradas da thread chamadora.
  */
 double workload_compute(double resource, int max_iters);
 
+/* `iters` iterações nominais do kernel do perfil, sem sorteio (para
+ * calibração). */
+double workload_run(int iters);
+
+void workload_shutdown(void);
+
 #endif /* WORKLOAD_H */
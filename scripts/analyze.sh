@@ -11,6 +11,8 @@
 #   4. Amdahl Predicted vs Actual
 #   5. Gustafson Scaled Speedup (across problem sizes)
 #   6. Communication Overhead Decomposition
+#   7. Halo Backends (from halo.csv next to the summary, when present)
+#   8. Execution Modes (from exec.csv: phased loop vs task graph)
 set -e
 
 if [ -z "$1" ]; then
@@ -303,6 +305,62 @@ NR == 1 { next }
         size, np, thr, m_cycle, season_pct, halo_pct, migrate_pct, comm_pct
 }' "$SUMMARY"
 
+# ── 7. Halo Backends ─────────────────────────────────────────────────
+HALO_CSV="$(dirname "$SUMMARY")/halo.csv"
+if [ -f "$HALO_CSV" ]; then
+    echo ""
+    echo "── 7. Halo Backends ─────────────────────────────────────────────────────"
+    echo ""
+    echo "  Halo time per backend relative to the first backend of each config."
+    echo ""
+    awk -F',' '
+    NR == 1 { next }
+    {
+        key = $1 "|" $2 "|" $3
+        if (!(key in base)) base[key] = $5
+        rel = (base[key] > 0) ? $5 / base[key] : 0
+        if (!header) {
+            printf "%-10s %-3s %-3s %-11s %-14s %-10s %-12s %-8s\n", \
+                "Size","NP","Thr","Halo","Halo(ms)","Cycle(ms)","Bytes/cycle","Rel"
+            printf "%-10s %-3s %-3s %-11s %-14s %-10s %-12s %-8s\n", \
+                "----------","---","---","-----------","--------------","----------","------------","--------"
+            header=1
+        }
+        printf "%-10s %-3d %-3d %-11s %6.4f±%-7.4f %-10.3f %-12d %-8.2f\n", \
+            $1, $2, $3, $4, $5, $6, $7, $9, rel
+    }' "$HALO_CSV"
+fi
+
+# ── 8. Execution Modes ───────────────────────────────────────────────
+EXEC_CSV="$(dirname "$SUMMARY")/exec.csv"
+if [ -f "$EXEC_CSV" ]; then
+    echo ""
+    echo "── 8. Execution Modes ───────────────────────────────────────────────────"
+    echo ""
+    echo "  Cycle time per mode; speedup relative to the phased loop."
+    echo ""
+    awk -F',' '
+    NR == 1 { next }
+    {
+        key = $1 "|" $2 "|" $3
+        if ($4 == "phased") base[key] = $5
+        row[NR] = $0
+    }
+    END {
+        printf "%-10s %-3s %-3s %-8s %-16s %-10s %-8s\n", \
+            "Size","NP","Thr","Exec","Cycle(ms)","Agent(ms)","Speedup"
+        printf "%-10s %-3s %-3s %-8s %-16s %-10s %-8s\n", \
+            "----------","---","---","--------","----------------","----------","--------"
+        for (i = 2; i <= NR; i++) {
+            split(row[i], f, ",")
+            key = f[1] "|" f[2] "|" f[3]
+            sp = (f[5] > 0 && (key in base)) ? base[key] / f[5] : 0
+            printf "%-10s %-3d %-3d %-8s %7.3f±%-8.3f %-10.3f %-8.2f\n", \
+                f[1], f[2], f[3], f[4], f[5], f[6], f[7], sp
+        }
+    }' "$EXEC_CSV"
+fi
+
 echo ""
 echo "========================================================================"
 echo " Analysis complete"
@@ -10,10 +10,17 @@
 #   - Grid-divisibility check: configs where NP doesn't divide grid cleanly are skipped
 #   - Per-size subdirectories with per-run CSVs
 #   - Summary CSV with mean ± stddev for all 7 phase columns
+#   - Halo backends compared on the same hardware (HALO_LIST)
+#   - Phased loop vs per-tile task graph (EXEC_LIST, --tasks)
+#   - Workload order: runtime schedule vs LPT (WSCHED_LIST, --workload-sched)
 #
 # Outputs:
-#   benchmark_results/<timestamp>/<WxH>/np<N>_t<T>_run<R>.csv  — per-run CSV
+#   benchmark_results/<timestamp>/<WxH>/np<N>_t<T>_<halo>_run<R>.csv — per-run CSV
 #   benchmark_results/<timestamp>/summary.csv                    — aggregated summary
+#                                                                  (first HALO_LIST mode)
+#   benchmark_results/<timestamp>/halo.csv                       — halo cost per backend
+#   benchmark_results/<timestamp>/exec.csv                       — phased vs tasks
+#   benchmark_results/<timestamp>/sched.csv                      — omp vs lpt workload
 set -e
 
 cd "$(dirname "$0")/.."
@@ -27,6 +34,10 @@ WARMUP=${WARMUP:-5}
 SIZES=${SIZES:-"64x64:50:100 128x128:200:100 256x256:500:50"}
 NP_LIST=${NP_LIST:-"1 2 4 8"}
 THREAD_LIST=${THREAD_LIST:-"1 2 4 8"}
+HALO_LIST=${HALO_LIST:-"isend persistent rma shm"}
+HALO_MAIN=${HALO_LIST%% *}
+EXEC_LIST=${EXEC_LIST:-"phased tasks"}
+WSCHED_LIST=${WSCHED_LIST:-"omp lpt"}
 
 TIMESTAMP=$(date +%Y%m%d_%H%M%S)
 OUTDIR="benchmark_results/${TIMESTAMP}"
@@ -37,6 +48,9 @@ echo " Benchmark Suite"
 echo " Sizes:   ${SIZES}"
 echo " NP:      ${NP_LIST}"
 echo " Threads: ${THREAD_LIST}"
+echo " Halo:    ${HALO_LIST}  (summary uses ${HALO_MAIN})"
+echo " Exec:    ${EXEC_LIST}"
+echo " Sched:   ${WSCHED_LIST}"
 echo " Runs:    ${RUNS}  Warmup: ${WARMUP} cycles"
 echo " Output:  ${OUTDIR}/"
 echo "============================================="
@@ -46,6 +60,54 @@ SUMMARY="${OUTDIR}/summary.csv"
 echo "size,np,threads,mean_season_ms,std_season_ms,mean_halo_ms,std_halo_ms,mean_workload_ms,std_workload_ms,mean_agent_ms,std_agent_ms,mean_grid_ms,std_grid_ms,mean_migrate_ms,std_migrate_ms,mean_metrics_ms,std_metrics_ms,mean_cycle_ms,std_cycle_ms,mean_workload_pct,mean_comm_pct,wall_time_s" \
     > "$SUMMARY"
 
+# Halo backend comparison: one row per (size, np, threads, halo mode)
+HALO_CSV="${OUTDIR}/halo.csv"
+echo "size,np,threads,halo,mean_halo_ms,std_halo_ms,mean_cycle_ms,std_cycle_ms,mean_halo_bytes" \
+    > "$HALO_CSV"
+
+# Execution mode comparison: phased loop vs task graph (halo = HALO_MAIN)
+EXEC_CSV="${OUTDIR}/exec.csv"
+echo "size,np,threads,exec,mean_cycle_ms,std_cycle_ms,mean_agent_ms,wall_time_s" \
+    > "$EXEC_CSV"
+
+# Workload order comparison: workload, finish-time spread, cycle (HALO_MAIN)
+SCHED_CSV="${OUTDIR}/sched.csv"
+echo "size,np,threads,sched,mean_workload_ms,mean_spread_ms,mean_cycle_ms,wall_time_s" \
+    > "$SCHED_CSV"
+
+# ── Helper: mean workload_ms (col 5), spread_ms (col 21) and cycle_ms ──
+sched_stats() {
+    awk -F',' -v warmup="$WARMUP" '
+    /^cycle,/ { next }
+    {
+        if ($1 + 0 < warmup) next
+        n++
+        w += $5; s += $21; c += $10
+    }
+    END {
+        if (n == 0) { print "0,0,0"; exit }
+        printf "%.3f,%.3f,%.3f", w / n, s / n, c / n
+    }' "$@"
+}
+
+# ── Helper: mean±std of cycle_ms (col 10) and mean agent_ms (col 6) ──
+cycle_stats() {
+    awk -F',' -v warmup="$WARMUP" '
+    /^cycle,/ { next }
+    {
+        if ($1 + 0 < warmup) next
+        n++
+        c += $10; cc += $10 * $10
+        a += $6
+    }
+    END {
+        if (n == 0) { print "0,0,0"; exit }
+        mc = c / n
+        vc = cc / n - mc * mc; if (vc < 0) vc = 0
+        printf "%.3f,%.3f,%.3f", mc, sqrt(vc), a / n
+    }' "$@"
+}
+
 # ── Helper: compute best factorization px×py for NP ──
 # Returns "px py" such that px*py == NP and px <= py (wider grids get more columns).
 factorize() {
@@ -92,76 +154,165 @@ for SIZE_SPEC in $SIZES; do
         for THREADS in $THREAD_LIST; do
             export OMP_NUM_THREADS=$THREADS
 
-            # Collect per-run CSVs
-            ALL_RUN_FILES=""
-            T_WALL_START=$(python3 -c "import time; print(time.time())")
+            for HALO in $HALO_LIST; do
+                # Collect per-run CSVs
+                ALL_RUN_FILES=""
+                T_WALL_START=$(python3 -c "import time; print(time.time())")
 
-            for RUN in $(seq 1 "$RUNS"); do
-                RUNFILE="${SIZE_DIR}/np${NP}_t${THREADS}_run${RUN}.csv"
-                mpirun --oversubscribe -np "$NP" ./sim \
-                    -w "$WIDTH" -h "$HEIGHT" -c "$CYCLES" -a "$AGENTS" \
-                    --no-tui --csv > "$RUNFILE" 2>/dev/null
-                ALL_RUN_FILES="${ALL_RUN_FILES} ${RUNFILE}"
-            done
+                for RUN in $(seq 1 "$RUNS"); do
+                    RUNFILE="${SIZE_DIR}/np${NP}_t${THREADS}_${HALO}_run${RUN}.csv"
+                    mpirun --oversubscribe -np "$NP" ./sim \
+                        -w "$WIDTH" -h "$HEIGHT" -c "$CYCLES" -a "$AGENTS" \
+                        --halo "$HALO" --no-tui --csv > "$RUNFILE" 2>/dev/null
+                    ALL_RUN_FILES="${ALL_RUN_FILES} ${RUNFILE}"
+                done
+
+                T_WALL_END=$(python3 -c "import time; print(time.time())")
+                WALL=$(python3 -c "print(f'{${T_WALL_END} - ${T_WALL_START}:.3f}')")
+
+                # Aggregate across all runs: compute mean and stddev for each phase,
+                # excluding the first WARMUP cycles from each run.
+                # CSV columns: 1=cycle, 2=season, 3=season_ms, 4=halo_ms, 5=workload_ms,
+                #   6=agent_ms, 7=grid_ms, 8=migrate_ms, 9=metrics_ms, 10=cycle_ms,
+                #   11=total_agents, 12=total_resource, 13=avg_energy,
+                #   14=load_balance, 15=workload_pct, 16=comm_pct, 17=reproduce_ms,
+                #   18=halo_bytes, 19=migrate_bytes, 20=overlap_ms, 21=spread_ms
+                STATS=$(awk -F',' -v warmup="$WARMUP" '
+                NR == 1 { next }  # skip header of first file
+                /^cycle,/ { next }  # skip headers of subsequent files
+                {
+                    cyc = $1 + 0
+                    if (cyc < warmup) next
 
-            T_WALL_END=$(python3 -c "import time; print(time.time())")
-            WALL=$(python3 -c "print(f'{${T_WALL_END} - ${T_WALL_START}:.3f}')")
-
-            # Aggregate across all runs: compute mean and stddev for each phase,
-            # excluding the first WARMUP cycles from each run.
-            # CSV columns: 1=cycle, 2=season, 3=season_ms, 4=halo_ms, 5=workload_ms,
-            #   6=agent_ms, 7=grid_ms, 8=migrate_ms, 9=metrics_ms, 10=cycle_ms,
-            #   11=total_agents, 12=total_resource, 13=avg_energy,
-            #   14=load_balance, 15=workload_pct, 16=comm_pct
-            STATS=$(awk -F',' -v warmup="$WARMUP" '
-            NR == 1 { next }  # skip header of first file
-            /^cycle,/ { next }  # skip headers of subsequent files
-            {
-                cyc = $1 + 0
-                if (cyc < warmup) next
-
-                n++
-                for (i = 1; i <= 7; i++) {
-                    col = i + 2   # columns 3..9 = season_ms..metrics_ms
-                    v = $(col) + 0
-                    sum[i] += v
-                    sumsq[i] += v * v
+                    n++
+                    for (i = 1; i <= 7; i++) {
+                        col = i + 2   # columns 3..9 = season_ms..metrics_ms
+                        v = $(col) + 0
+                        sum[i] += v
+                        sumsq[i] += v * v
+                    }
+                    # cycle_ms is column 10
+                    sum[8] += $10 + 0
+                    sumsq[8] += ($10 + 0) * ($10 + 0)
+                    # workload_pct and comm_pct
+                    sum_wpct += $15 + 0
+                    sum_cpct += $16 + 0
                 }
-                # cycle_ms is column 10
-                sum[8] += $10 + 0
-                sumsq[8] += ($10 + 0) * ($10 + 0)
-                # workload_pct and comm_pct
-                sum_wpct += $15 + 0
-                sum_cpct += $16 + 0
-            }
-            END {
-                if (n == 0) { print "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"; exit }
-                for (i = 1; i <= 8; i++) {
-                    mean[i] = sum[i] / n
-                    var = sumsq[i] / n - mean[i] * mean[i]
-                    if (var < 0) var = 0
-                    std[i] = sqrt(var)
+                END {
+                    if (n == 0) { print "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"; exit }
+                    for (i = 1; i <= 8; i++) {
+                        mean[i] = sum[i] / n
+                        var = sumsq[i] / n - mean[i] * mean[i]
+                        if (var < 0) var = 0
+                        std[i] = sqrt(var)
+                    }
+                    printf "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f", \
+                        mean[1], std[1], mean[2], std[2], mean[3], std[3], \
+                        mean[4], std[4], mean[5], std[5], mean[6], std[6], \
+                        mean[7], std[7], mean[8], std[8], \
+                        sum_wpct / n, sum_cpct / n
+                }' $ALL_RUN_FILES)
+
+                # Halo cost for this backend (all modes go to halo.csv)
+                HSTATS=$(awk -F',' -v warmup="$WARMUP" '
+                /^cycle,/ { next }
+                {
+                    if ($1 + 0 < warmup) next
+                    n++
+                    h += $4;  hh += $4 * $4
+                    c += $10; cc += $10 * $10
+                    b += $18
                 }
-                printf "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f", \
-                    mean[1], std[1], mean[2], std[2], mean[3], std[3], \
-                    mean[4], std[4], mean[5], std[5], mean[6], std[6], \
-                    mean[7], std[7], mean[8], std[8], \
-                    sum_wpct / n, sum_cpct / n
-            }' $ALL_RUN_FILES)
-
-            echo "${WH},${NP},${THREADS},${STATS},${WALL}" >> "$SUMMARY"
-
-            # Extract means for display
-            M_SEASON=$(echo "$STATS" | cut -d',' -f1)
-            M_HALO=$(echo "$STATS" | cut -d',' -f3)
-            M_WORK=$(echo "$STATS" | cut -d',' -f5)
-            M_AGENT=$(echo "$STATS" | cut -d',' -f7)
-            M_GRID=$(echo "$STATS" | cut -d',' -f9)
-            M_MIGRATE=$(echo "$STATS" | cut -d',' -f11)
-            M_CYCLE=$(echo "$STATS" | cut -d',' -f15)
-
-            printf "%-4s %-4s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\n" \
-                "$NP" "$THREADS" "$M_SEASON" "$M_HALO" "$M_WORK" "$M_AGENT" "$M_GRID" "$M_MIGRATE" "$M_CYCLE" "$WALL"
+                END {
+                    if (n == 0) { print "0,0,0,0,0"; exit }
+                    mh = h / n; mc = c / n
+                    vh = hh / n - mh * mh; if (vh < 0) vh = 0
+                    vc = cc / n - mc * mc; if (vc < 0) vc = 0
+                    printf "%.4f,%.4f,%.3f,%.3f,%.0f", mh, sqrt(vh), mc, sqrt(vc), b / n
+                }' $ALL_RUN_FILES)
+                echo "${WH},${NP},${THREADS},${HALO},${HSTATS}" >> "$HALO_CSV"
+
+                if [ "$HALO" = "$HALO_MAIN" ]; then
+                    MAIN_RUN_FILES="$ALL_RUN_FILES"
+                    MAIN_WALL="$WALL"
+                fi
+
+                if [ "$HALO" != "$HALO_MAIN" ]; then
+                    printf "%-4s %-4s   halo=%-10s %-10s (cycle %s ms)\n" \
+                        "$NP" "$THREADS" "$HALO" "$(echo "$HSTATS" | cut -d',' -f1)" \
+                        "$(echo "$HSTATS" | cut -d',' -f3)"
+                    continue
+                fi
+
+                echo "${WH},${NP},${THREADS},${STATS},${WALL}" >> "$SUMMARY"
+
+                # Extract means for display
+                M_SEASON=$(echo "$STATS" | cut -d',' -f1)
+                M_HALO=$(echo "$STATS" | cut -d',' -f3)
+                M_WORK=$(echo "$STATS" | cut -d',' -f5)
+                M_AGENT=$(echo "$STATS" | cut -d',' -f7)
+                M_GRID=$(echo "$STATS" | cut -d',' -f9)
+                M_MIGRATE=$(echo "$STATS" | cut -d',' -f11)
+                M_CYCLE=$(echo "$STATS" | cut -d',' -f15)
+
+                printf "%-4s %-4s %-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\n" \
+                    "$NP" "$THREADS" "$M_SEASON" "$M_HALO" "$M_WORK" "$M_AGENT" "$M_GRID" "$M_MIGRATE" "$M_CYCLE" "$WALL"
+            done
+
+            # Execution modes: "phased" reuses the HALO_MAIN runs above.
+            for EXEC in $EXEC_LIST; do
+                if [ "$EXEC" = "phased" ]; then
+                    echo "${WH},${NP},${THREADS},phased,$(cycle_stats $MAIN_RUN_FILES),${MAIN_WALL}" \
+                        >> "$EXEC_CSV"
+                    continue
+                fi
+
+                EXEC_FILES=""
+                T_WALL_START=$(python3 -c "import time; print(time.time())")
+                for RUN in $(seq 1 "$RUNS"); do
+                    RUNFILE="${SIZE_DIR}/np${NP}_t${THREADS}_${EXEC}_run${RUN}.csv"
+                    mpirun --oversubscribe -np "$NP" ./sim \
+                        -w "$WIDTH" -h "$HEIGHT" -c "$CYCLES" -a "$AGENTS" \
+                        --halo "$HALO_MAIN" --"$EXEC" --no-tui --csv \
+                        > "$RUNFILE" 2>/dev/null
+                    EXEC_FILES="${EXEC_FILES} ${RUNFILE}"
+                done
+                T_WALL_END=$(python3 -c "import time; print(time.time())")
+                WALL=$(python3 -c "print(f'{${T_WALL_END} - ${T_WALL_START}:.3f}')")
+
+                ESTATS=$(cycle_stats $EXEC_FILES)
+                echo "${WH},${NP},${THREADS},${EXEC},${ESTATS},${WALL}" >> "$EXEC_CSV"
+                printf "%-4s %-4s   exec=%-10s (cycle %s ms)\n" \
+                    "$NP" "$THREADS" "$EXEC" "$(echo "$ESTATS" | cut -d',' -f1)"
+            done
+
+            # Workload order: "omp" reuses the HALO_MAIN runs above.
+            for WSCHED in $WSCHED_LIST; do
+                if [ "$WSCHED" = "omp" ]; then
+                    echo "${WH},${NP},${THREADS},omp,$(sched_stats $MAIN_RUN_FILES),${MAIN_WALL}" \
+                        >> "$SCHED_CSV"
+                    continue
+                fi
+
+                SCHED_FILES=""
+                T_WALL_START=$(python3 -c "import time; print(time.time())")
+                for RUN in $(seq 1 "$RUNS"); do
+                    RUNFILE="${SIZE_DIR}/np${NP}_t${THREADS}_${WSCHED}_run${RUN}.csv"
+                    mpirun --oversubscribe -np "$NP" ./sim \
+                        -w "$WIDTH" -h "$HEIGHT" -c "$CYCLES" -a "$AGENTS" \
+                        --halo "$HALO_MAIN" --workload-sched "$WSCHED" \
+                        --no-tui --csv > "$RUNFILE" 2>/dev/null
+                    SCHED_FILES="${SCHED_FILES} ${RUNFILE}"
+                done
+                T_WALL_END=$(python3 -c "import time; print(time.time())")
+                WALL=$(python3 -c "print(f'{${T_WALL_END} - ${T_WALL_START}:.3f}')")
+
+                SSTATS=$(sched_stats $SCHED_FILES)
+                echo "${WH},${NP},${THREADS},${WSCHED},${SSTATS},${WALL}" >> "$SCHED_CSV"
+                printf "%-4s %-4s   sched=%-9s (workload %s ms, spread %s ms)\n" \
+                    "$NP" "$THREADS" "$WSCHED" "$(echo "$SSTATS" | cut -d',' -f1)" \
+                    "$(echo "$SSTATS" | cut -d',' -f2)"
+            done
         done
     done
 done
@@ -170,5 +321,8 @@ echo ""
 echo "============================================="
 echo " Benchmark complete"
 echo " Summary: ${SUMMARY}"
-echo " Per-run CSVs: ${OUTDIR}/<size>/np*_t*_run*.csv"
+echo " Halo:    ${HALO_CSV}"
+echo " Exec:    ${EXEC_CSV}"
+echo " Sched:   ${SCHED_CSV}"
+echo " Per-run CSVs: ${OUTDIR}/<size>/np*_t*_*_run*.csv"
 echo "============================================="
@@ -1,7 +1,12 @@
 #include "agent.h"
+#include "autotune.h"
 #include "config.h"
+#include "grid.h"
+#include "lpt.h"
 #include "partition.h"
+#include "pool.h"
 #include "season.h"
+#include "trace.h"
 #include "workload.h"
 
 #include <stdlib.h>
@@ -14,7 +19,7 @@
 static const int dx[9] = {  0,  0,  1, -1,  1, -1,  1, -1,  0 };
 static const int dy[9] = { -1,  1,  0,  0, -1, -1,  1,  1,  0 };
 
-void agents_init(Agent *agents, int *count, int num_total,
+void agents_init(AgentPool *pool, int num_total,
                  SubGrid *sg, Partition *p,
                  int global_w, int global_h,
                  double initial_energy, uint64_t seed) {
@@ -24,7 +29,6 @@ void agents_init(Agent *agents, int *count, int num_total,
      * mantém apenas os agentes que caem na sua sub-grade, garantindo
      * resultado idêntico independentemente do número de ranks MPI.
      */
-    *count = 0;
     RngState grng = rng_seed(seed ^ 0xA6E47ULL);    // RNG global para posicionamento inicial
 
     for (int i = 0; i < num_total; i++) {
@@ -32,24 +36,16 @@ void agents_init(Agent *agents, int *count, int num_total,
         int gy = (int)(rng_next(&grng) % (uint64_t)global_h);
 
         if (partition_owns_global(p, sg, gx, gy)) {
-            Agent *a  = &agents[*count];
-            a->id     = i;
-            a->gx     = gx;
-            a->gy     = gy;
-            a->energy = initial_energy;
-            a->alive  = 1;
-            (*count)++;
+            pool_push(pool, (uint64_t)i,
+                      gx - sg->offset_x + sg->halo, gy - sg->offset_y + sg->halo,
+                      (float)initial_energy);
         }
     }
 }
 
-void agent_decide(Agent *a, SubGrid *sg, Season season, RngState *rng,
-                  double energy_gain, double energy_loss) {
-    if (!a->alive) return;
-    (void)season;  /* acessibilidade já pré-computada em subgrid_update */
-
-    int lc = a->gx - sg->offset_x + 1;
-    int lr = a->gy - sg->offset_y + 1;
+int agent_decide(AgentPool *pool, int i, const SubGrid *sg, RngState *rng) {
+    int lc = pool->x[i];
+    int lr = pool->y[i];
 
     double best_resource = -1.0;
     int    best_dir      = 8;
@@ -62,9 +58,10 @@ void agent_decide(Agent *a, SubGrid *sg, Season season, RngState *rng,
         if (nc < 0 || nc >= sg->halo_w || nr < 0 || nr >= sg->halo_h)
             continue;
 
-        Cell *cell = &sg->cells[CELL_AT(sg, nr, nc)];
-        if (!cell->accessible)
+        int idx = CELL_AT(sg, nr, nc);
+        if (!subgrid_accessible(sg, idx))
             continue;
+        const Cell *cell = &sg->cells[idx];
 
         if (cell->resource > best_resource) {
             best_resource = cell->resource;
@@ -78,99 +75,411 @@ void agent_decide(Agent *a, SubGrid *sg, Season season, RngState *rng,
         }
     }
 
-    a->gx += dx[best_dir];
-    a->gy += dy[best_dir];
+    int new_lc = lc + dx[best_dir];
+    int new_lr = lr + dy[best_dir];
+    pool->x[i] = (uint16_t)new_lc;
+    pool->y[i] = (uint16_t)new_lr;
 
-    /* Consumo de recurso: apenas se o destino está dentro do subgrid
-     * local (interior, não halo).  Agentes que migram para outro rank
-     * não consomem neste ciclo (algoritmo §4, passo 5.3). */
-    int new_lc = a->gx - sg->offset_x + 1;
-    int new_lr = a->gy - sg->offset_y + 1;
+    /* Consumo apenas dentro do bloco de origem: agentes que cruzam para
+     * a região de outro rank não consomem neste ciclo (algoritmo §4,
+     * passo 5.3). Com halo 1, equivale a "destino no interior". Ficam no
+     * bucket da célula de origem, que lhes dá o id de um eventual filho. */
+    if (subgrid_block(sg, new_lc, new_lr) != subgrid_block(sg, lc, lr))
+        return -2 - CELL_AT(sg, lr, lc);
+    return CELL_AT(sg, new_lr, new_lc);
+}
 
-    if (new_lc >= 1 && new_lc <= sg->local_w &&
-        new_lr >= 1 && new_lr <= sg->local_h) {
-        /* Destino local — consumir recurso ou perder energia. */
-        Cell *cell = &sg->cells[CELL_AT(sg, new_lr, new_lc)];
-        if (cell->accessible && cell->resource > 0.0) {
-            double consumed = (energy_gain < cell->resource)
-                              ? energy_gain : cell->resource;
-            #pragma omp atomic
-            cell->resource -= consumed;
-            a->energy += consumed;
-        } else {
-            a->energy -= energy_loss;
-        }
-    }
-    /* Destino fora do subgrid local (halo) — agente será migrado;
-     * não consome nem perde energia durante a transição. */
+/* Carga sintética do agente no slot i (agentes no halo não pagam). */
+static void workload_agent(AgentPool *pool, SubGrid *sg, int i,
+                           int max_workload) {
+    if (!pool_alive(pool, i)) return;
 
-    if (a->energy <= 0.0)
-        a->alive = 0;
+    int lc = pool->x[i];
+    int lr = pool->y[i];
+    if (subgrid_interior(sg, lc, lr)) {
+        int idx = CELL_AT(sg, lr, lc);
+        workload_compute(sg->cells[idx].resource, max_workload);
+    }
 }
 
-void agents_workload(Agent *agents, int count, SubGrid *sg, int max_workload) {
-    #pragma omp parallel for schedule(guided, 8)
-    for (int i = 0; i < count; i++) {
-        if (!agents[i].alive) continue;
-
-        int lc = agents[i].gx - sg->offset_x + 1;
-        int lr = agents[i].gy - sg->offset_y + 1;
-        if (lc >= 1 && lc <= sg->local_w &&
-            lr >= 1 && lr <= sg->local_h) {
-            int idx = CELL_AT(sg, lr, lc);
-            workload_compute(sg->cells[idx].resource, max_workload);
-        }
+void agents_workload_team(AgentPool *pool, SubGrid *sg, int max_workload,
+                          double *finish) {
+    double t_trace = trace_begin();
+    const int count = pool->count;
+
+    int lo, hi;
+    if (tune_block(TUNE_WORKLOAD, count, &lo, &hi)) {
+        /* Menos threads que a equipe: quem fica de fora não marca fim. */
+        if (lo == hi) finish = NULL;
+        for (int i = lo; i < hi; i++)
+            workload_agent(pool, sg, i, max_workload);
+    } else {
+        tune_apply(TUNE_WORKLOAD);
+        #pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < count; i++)
+            workload_agent(pool, sg, i, max_workload);
     }
+#ifdef _OPENMP
+    if (finish)
+        finish[omp_get_thread_num()] = omp_get_wtime();
+#else
+    (void)finish;
+#endif
+    trace_end(TR_WORKLOAD, t_trace);
 }
 
-void agents_decide_all(Agent *agents, int count, SubGrid *sg,
-                       Season season, uint64_t seed,
-                       double energy_gain, double energy_loss) {
+void agents_workload(AgentPool *pool, SubGrid *sg, int max_workload,
+                     double *finish) {
     #pragma omp parallel
+    agents_workload_team(pool, sg, max_workload, finish);
+}
+
+LptPlan *agents_workload_plan_team(AgentPool *pool, SubGrid *sg,
+                                   int max_workload, Arena *arena) {
+    double t_trace = trace_begin();
+    const int count = pool->count;
+    int     *cost;
+    LptPlan *plan;
+
+    #pragma omp single copyprivate(cost)
+    cost = arena_alloc(arena, sizeof(int) * (size_t)(count > 0 ? count : 1));
+
+    /* Custo previsto: as iterações de workload_compute (0 = sem carga). */
+    #pragma omp for schedule(static)
+    for (int i = 0; i < count; i++) {
+        cost[i] = 0;
+        if (!pool_alive(pool, i)) continue;
+
+        int lc = pool->x[i];
+        int lr = pool->y[i];
+        if (subgrid_interior(sg, lc, lr))
+            cost[i] = (int)(sg->cells[CELL_AT(sg, lr, lc)].resource
+                            * max_workload);
+    }
+
+    int nt = 1;
+#ifdef _OPENMP
+    nt = omp_get_num_threads();
+#endif
+    #pragma omp single copyprivate(plan)
     {
-        int tid = 0;
+        plan = arena_alloc(arena, sizeof(LptPlan));
+        lpt_build(plan, cost, count, max_workload, nt, arena);
+    }
+    trace_end(TR_LPT_PLAN, t_trace);
+    return plan;
+}
+
+void agents_workload_lpt_team(LptPlan *plan, AgentPool *pool, SubGrid *sg,
+                              int max_workload, double *finish) {
+    double t_trace = trace_begin();
+    int self = 0;
+#ifdef _OPENMP
+    self = omp_get_thread_num();
+#endif
+    for (int i = lpt_next(plan, self); i >= 0; i = lpt_next(plan, self)) {
+        int idx = CELL_AT(sg, pool->y[i], pool->x[i]);
+        workload_compute(sg->cells[idx].resource, max_workload);
+    }
 #ifdef _OPENMP
-        tid = omp_get_thread_num();
+    if (finish)
+        finish[self] = omp_get_wtime();
+#else
+    (void)finish;
 #endif
-        RngState rng = rng_seed(seed ^ ((uint64_t)(tid + 1) * 2654435761ULL));
+    trace_end(TR_WORKLOAD, t_trace);
+}
 
-        #pragma omp for schedule(guided, 8)
-        for (int i = 0; i < count; i++) {
-            if (!agents[i].alive) continue;
-            agent_decide(&agents[i], sg, season, &rng,
-                         energy_gain, energy_loss);
+LptPlan *agents_workload_plan(AgentPool *pool, SubGrid *sg,
+                              int max_workload, int nthreads, Arena *arena) {
+    LptPlan *plan = NULL;
+    #pragma omp parallel num_threads(nthreads)
+    {
+        LptPlan *p = agents_workload_plan_team(pool, sg, max_workload, arena);
+        #pragma omp master
+        plan = p;
+    }
+    return plan;
+}
+
+void agents_workload_lpt(LptPlan *plan, AgentPool *pool, SubGrid *sg,
+                         int max_workload, double *finish) {
+    /* Uma thread por fila: uma equipe maior indexaria filas inexistentes. */
+    #pragma omp parallel num_threads(plan->nqueues)
+    agents_workload_lpt_team(plan, pool, sg, max_workload, finish);
+}
+
+/* Ordena slots por id (buckets por célula são pequenos). */
+static void sort_by_id(int *slots, int n, const uint64_t *id) {
+    for (int a = 1; a < n; a++) {
+        int s = slots[a];
+        int b = a - 1;
+        while (b >= 0 && id[slots[b]] > id[s]) {
+            slots[b + 1] = slots[b];
+            b--;
         }
+        slots[b + 1] = s;
     }
 }
 
-void agents_reproduce(Agent **agents, int *count, int *capacity,
-                      int *next_id, double threshold, double cost) {
-    Agent *ag = *agents;
-    int n = *count;
+/* Passo 1 de agents_decide_all para o slot i (-1 se morto). */
+static void decide_slot(AgentPool *pool, int i, const SubGrid *sg,
+                        uint64_t seed, int cycle, int *dest) {
+    dest[i] = -1;
+    if (!pool_alive(pool, i)) return;
+    RngState rng = rng_seed(rng_agent_seed(seed, pool->id[i], cycle));
+    dest[i] = agent_decide(pool, i, sg, &rng);
+}
+
+uint64_t *agents_decide_all_team(AgentPool *pool, SubGrid *sg,
+                                 uint64_t seed, int cycle,
+                                 double energy_gain, double energy_loss,
+                                 Arena *arena) {
+    double t_trace = trace_begin();
+    const int n      = pool->count;
+    const int ncells = sg->halo_w * sg->halo_h;
+
+    int nt = 1, tid = 0;
+#ifdef _OPENMP
+    nt  = omp_get_num_threads();
+    tid = omp_get_thread_num();
+#endif
+
+    /* A arena não é thread-safe: uma thread aloca e difunde os ponteiros.
+     * part[t + 1] = consumidores no bloco de células da thread t. */
+    int *dest, *start, *fill, *part;
+    uint64_t *kid;
+    #pragma omp single copyprivate(dest, start, fill, part, kid)
+    {
+        dest  = arena_alloc(arena, sizeof(int) * (size_t)(n > 0 ? n : 1));
+        start = arena_calloc(arena, (size_t)ncells + 1, sizeof(int));
+        fill  = arena_alloc(arena, sizeof(int) * (size_t)ncells);
+        part  = arena_calloc(arena, (size_t)nt + 1, sizeof(int));
+        kid   = arena_calloc(arena, (size_t)(n > 0 ? n : 1), sizeof(uint64_t));
+    }
+
+    /* Passo 1: decisões sobre o estado das células no início do passo
+     * (ninguém escreve em células aqui). */
+    int lo, hi;
+    if (tune_block(TUNE_DECIDE, n, &lo, &hi)) {
+        for (int i = lo; i < hi; i++)
+            decide_slot(pool, i, sg, seed, cycle, dest);
+        #pragma omp barrier
+    } else {
+        tune_apply(TUNE_DECIDE);
+        #pragma omp for schedule(runtime)
+        for (int i = 0; i < n; i++)
+            decide_slot(pool, i, sg, seed, cycle, dest);
+    }
+
+    /* Passo 2: counting sort dos agentes por célula (agent_bucket), em
+     * paralelo. Contagem com atômicos (poucos agentes por célula); scan
+     * em dois níveis como em agents_reproduce_team: cada thread soma um
+     * bloco contíguo de células, a master acumula as somas dos blocos e
+     * cada thread completa o próprio bloco. A ordem dentro de um bucket
+     * depende do escalonamento, mas agents_consume_cell ordena por id. */
+    #pragma omp for schedule(static)
     for (int i = 0; i < n; i++) {
-        if (!ag[i].alive || ag[i].energy <= threshold) continue;
-        ag[i].energy -= cost;
-        if (*count >= *capacity) {
-            int new_cap = *capacity ? *capacity * 2 : 16;
-            ag = realloc(ag, sizeof(Agent) * (size_t)new_cap);
-            *agents = ag;
-            *capacity = new_cap;
+        int b = agent_bucket(dest[i]);
+        if (b < 0) continue;
+        #pragma omp atomic
+        start[b + 1]++;
+    }
+
+    const int c_lo = (int)((long)ncells * tid / nt);
+    const int c_hi = (int)((long)ncells * (tid + 1) / nt);
+    int sum = 0;
+    for (int c = c_lo; c < c_hi; c++)
+        sum += start[c + 1];
+    part[tid + 1] = sum;
+    #pragma omp barrier
+
+    int *order;
+    #pragma omp single copyprivate(order)
+    {
+        for (int t = 1; t <= nt; t++)
+            part[t] += part[t - 1];
+        order = arena_alloc(arena, sizeof(int) *
+                            (size_t)(part[nt] > 0 ? part[nt] : 1));
+    }
+
+    sum = part[tid];
+    for (int c = c_lo; c < c_hi; c++) {
+        fill[c] = sum;
+        sum += start[c + 1];
+        start[c + 1] = sum;
+    }
+    #pragma omp barrier
+
+    #pragma omp for schedule(static)
+    for (int i = 0; i < n; i++) {
+        int b = agent_bucket(dest[i]);
+        if (b < 0) continue;
+        int at;
+        #pragma omp atomic capture
+        at = fill[b]++;
+        order[at] = i;
+    }
+
+    /* Passo 3: cada célula é consumida por uma única thread, pelos seus
+     * agentes em ordem crescente de id — sem atômicos e sem depender da
+     * ordem do pool, do número de threads ou da decomposição. */
+    #pragma omp for schedule(static)
+    for (int c = 0; c < ncells; c++) {
+        int lo = start[c], hi = start[c + 1];
+        if (lo == hi) continue;
+        agents_consume_cell(pool, &sg->cells[c], subgrid_accessible(sg, c),
+                            &order[lo], hi - lo, dest, energy_gain,
+                            energy_loss, kid, agent_birth_id(sg, c, cycle));
+    }
+    trace_end(TR_DECIDE, t_trace);
+    return kid;
+}
+
+uint64_t *agents_decide_all(AgentPool *pool, SubGrid *sg,
+                            uint64_t seed, int cycle,
+                            double energy_gain, double energy_loss,
+                            Arena *arena) {
+    uint64_t *kid = NULL;
+    #pragma omp parallel
+    {
+        uint64_t *k = agents_decide_all_team(pool, sg, seed, cycle,
+                                             energy_gain, energy_loss, arena);
+        #pragma omp master
+        kid = k;
+    }
+    return kid;
+}
+
+/* Larguras dos campos dos ids de filhos (agent_ids_init). */
+static int id_cell_bits = 16, id_rank_bits = AGENT_ID_MIN_RANK_BITS,
+           id_global_w = 1;
+
+/* Menor b com 2^b >= n. */
+static int bits_for(uint64_t n) {
+    int b = 0;
+    while (b < 63 && (1ULL << b) < n) b++;
+    return b;
+}
+
+int agent_ids_init(int total_cycles, int global_w, int global_h) {
+    int cycle_bits = bits_for((uint64_t)(total_cycles > 0 ? total_cycles : 1));
+    id_cell_bits   = bits_for((uint64_t)global_w * (uint64_t)global_h);
+    id_rank_bits   = 63 - cycle_bits - id_cell_bits;
+    id_global_w    = global_w;
+    return id_rank_bits < AGENT_ID_MIN_RANK_BITS ? -1 : 0;
+}
+
+uint64_t agent_child_id(int cycle, int gx, int gy, int k) {
+    uint64_t cell = (uint64_t)gy * (uint64_t)id_global_w + (uint64_t)gx;
+    return (1ULL << 63)
+         | ((uint64_t)cycle << (id_cell_bits + id_rank_bits))
+         | (cell << id_rank_bits)
+         | (uint64_t)k;
+}
+
+uint64_t agent_birth_id(const SubGrid *sg, int idx, int cycle) {
+    int r = idx / sg->halo_w, c = idx % sg->halo_w;
+    return agent_child_id(cycle, sg->offset_x + c - sg->halo,
+                          sg->offset_y + r - sg->halo, 0);
+}
+
+void agents_consume_cell(AgentPool *pool, Cell *cell, int accessible,
+                         int *slots, int n, const int *dest,
+                         double energy_gain, double energy_loss,
+                         uint64_t *kid, uint64_t birth) {
+    sort_by_id(slots, n, pool->id);
+    for (int k = 0; k < n; k++) {
+        int   i      = slots[k];
+        float energy = pool->energy[i];
+        kid[i] = birth + (uint64_t)k;
+        if (dest[i] < 0)
+            continue;  /* cruzou para outro bloco: só o id do filho */
+        if (accessible && cell->resource > 0.0) {
+            double consumed = (energy_gain < cell->resource)
+                              ? energy_gain : cell->resource;
+            cell->resource -= consumed;
+            energy += (float)consumed;
+        } else {
+            energy -= (float)energy_loss;
         }
-        Agent *child = &ag[*count];
-        child->id     = (*next_id)++;
-        child->gx     = ag[i].gx;
-        child->gy     = ag[i].gy;
-        child->energy  = cost;
-        child->alive   = 1;
-        (*count)++;
-    }
-    *agents = ag;
-}
-
-void agents_process(Agent *agents, int count, SubGrid *sg,
-                    Season season, int max_workload, uint64_t seed,
-                    double energy_gain, double energy_loss) {
-    agents_workload(agents, count, sg, max_workload);
-    agents_decide_all(agents, count, sg, season, seed,
-                      energy_gain, energy_loss);
+        pool->energy[i] = energy;
+        if (energy <= 0.0f)
+            pool_kill(pool, i);
+    }
+}
+
+void agents_reproduce_team(AgentPool *pool, const uint64_t *kid,
+                           double threshold, double cost, Arena *arena) {
+    double t_trace = trace_begin();
+    const int n = pool->count;
+    int nt = 1, tid = 0;
+#ifdef _OPENMP
+    nt  = omp_get_num_threads();
+    tid = omp_get_thread_num();
+#endif
+    /* births[t + 1] = nascimentos da thread t; após o scan, births[t] é
+     * o deslocamento do primeiro filho da thread t. */
+    int *births;
+    #pragma omp single copyprivate(births)
+    births = arena_calloc(arena, (size_t)nt + 1, sizeof(int));
+
+    /* Passo 1: contagem. schedule(static) com os mesmos limites nos
+     * dois laços garante a mesma partição de iterações por thread. */
+    int mine = 0;
+    #pragma omp for schedule(static)
+    for (int i = 0; i < n; i++) {
+        if (kid[i] && pool_alive(pool, i) && pool->energy[i] > threshold)
+            mine++;
+    }
+    births[tid + 1] = mine;
+    #pragma omp barrier
+
+    /* Passo 2: scan exclusivo + crescimento único do pool. */
+    #pragma omp single
+    {
+        for (int t = 1; t <= nt; t++)
+            births[t] += births[t - 1];
+        pool_reserve(pool, n + births[nt]);
+    }
+
+    /* Passo 3: escrita paralela — chunks estáticos são contíguos e
+     * ordenados por tid, então a ordem dos filhos é a mesma da versão
+     * serial. */
+    int slot = n + births[tid];
+    #pragma omp for schedule(static)
+    for (int i = 0; i < n; i++) {
+        if (!kid[i] || !pool_alive(pool, i) || pool->energy[i] <= threshold)
+            continue;
+        pool->energy[i] -= (float)cost;
+        pool->id[slot]     = kid[i];
+        pool->x[slot]      = pool->x[i];
+        pool->y[slot]      = pool->y[i];
+        pool->energy[slot] = (float)cost;
+        slot++;
+    }
+
+    /* Bits dos filhos marcados por uma só thread: a palavra do slot
+     * n - 1 é compartilhada com os primeiros filhos. */
+    #pragma omp single
+    {
+        pool_revive_range(pool, n, n + births[nt]);
+        pool->count = n + births[nt];
+    }
+    trace_end(TR_REPRODUCE, t_trace);
+}
+
+void agents_reproduce(AgentPool *pool, const uint64_t *kid,
+                      double threshold, double cost, Arena *arena) {
+    #pragma omp parallel
+    agents_reproduce_team(pool, kid, threshold, cost, arena);
+}
+
+void agents_process(AgentPool *pool, SubGrid *sg,
+                    int max_workload, uint64_t seed, int cycle,
+                    double energy_gain, double energy_loss,
+                    Arena *arena) {
+    agents_workload(pool, sg, max_workload, NULL);
+    agents_decide_all(pool, sg, seed, cycle,
+                      energy_gain, energy_loss, arena);
 }
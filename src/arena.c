@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200112L  /* posix_memalign */
+
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 64
+
+static uint64_t heap_allocs = 0;
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static void *checked(void *p, size_t bytes) {
+    if (!p && bytes > 0) {
+        fprintf(stderr, "Error: out of memory (%zu bytes)\n", bytes);
+        abort();
+    }
+    return p;
+}
+
+void *sim_malloc(size_t bytes) {
+    #pragma omp atomic
+    heap_allocs++;
+    return checked(malloc(bytes), bytes);
+}
+
+void *sim_calloc(size_t n, size_t size) {
+    #pragma omp atomic
+    heap_allocs++;
+    return checked(calloc(n, size), n * size);
+}
+
+void *sim_realloc(void *ptr, size_t bytes) {
+    #pragma omp atomic
+    heap_allocs++;
+    return checked(realloc(ptr, bytes), bytes);
+}
+
+uint64_t sim_alloc_count(void) {
+    uint64_t n;
+    #pragma omp atomic read
+    n = heap_allocs;
+    return n;
+}
+
+static void *aligned_block(size_t bytes) {
+    void *p = NULL;
+    #pragma omp atomic
+    heap_allocs++;
+    if (posix_memalign(&p, ARENA_ALIGN, bytes ? bytes : ARENA_ALIGN) != 0)
+        p = NULL;
+    return checked(p, bytes);
+}
+
+void arena_init(Arena *a, size_t initial) {
+    memset(a, 0, sizeof(*a));
+    a->size = align_up(initial);
+    if (a->size > 0)
+        a->base = aligned_block(a->size);
+}
+
+void arena_destroy(Arena *a) {
+    if (!a) return;
+    for (int i = 0; i < a->n_overflow; i++)
+        free(a->overflow[i]);
+    free(a->overflow);
+    free(a->base);
+    memset(a, 0, sizeof(*a));
+}
+
+void *arena_alloc(Arena *a, size_t bytes) {
+    size_t n = align_up(bytes ? bytes : 1);
+    a->cycle_bytes += n;
+
+    if (a->used + n <= a->size) {
+        void *p = a->base + a->used;
+        a->used += n;
+        return p;
+    }
+
+    /* Estouro: bloco dedicado, liberado no próximo reset. */
+    if (a->n_overflow == a->cap_overflow) {
+        a->cap_overflow = a->cap_overflow ? a->cap_overflow * 2 : 8;
+        a->overflow = sim_realloc(a->overflow,
+                                  sizeof(void *) * (size_t)a->cap_overflow);
+    }
+    void *p = aligned_block(n);
+    a->overflow[a->n_overflow++] = p;
+    return p;
+}
+
+void *arena_calloc(Arena *a, size_t n, size_t size) {
+    void *p = arena_alloc(a, n * size);
+    memset(p, 0, n * size);
+    return p;
+}
+
+void arena_reset(Arena *a) {
+    if (a->cycle_bytes > a->high_water)
+        a->high_water = a->cycle_bytes;
+
+    if (a->n_overflow > 0) {
+        for (int i = 0; i < a->n_overflow; i++)
+            free(a->overflow[i]);
+        a->n_overflow = 0;
+
+        /* Redimensiona para o pico com 25% de folga. */
+        size_t new_size = align_up(a->high_water + a->high_water / 4);
+        free(a->base);
+        a->base = aligned_block(new_size);
+        a->size = new_size;
+    }
+
+    a->used        = 0;
+    a->cycle_bytes = 0;
+}
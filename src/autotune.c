@@ -0,0 +1,229 @@
+#include "autotune.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TUNE_MAX_CAND 16
+
+static const char *const phase_names[TUNE_PHASES] = {
+    "workload", "decide", "grid"
+};
+static const char *const kind_names[4] = { "?", "static", "dynamic", "guided" };
+
+/* Padrões: os escalonamentos fixos de antes do autotuner
+ * (workload e decide guided,8; grid dynamic,4). */
+#define TUNE_DEFAULTS { { 3, 8, 0 }, { 3, 8, 0 }, { 2, 4, 0 } }
+
+static TuneSetting current[TUNE_PHASES] = TUNE_DEFAULTS;
+
+/* Estado do autotuner. */
+static TuneSetting cand[TUNE_PHASES][TUNE_MAX_CAND];
+static int         ncand[TUNE_PHASES];
+static double      sum[TUNE_PHASES][TUNE_MAX_CAND];
+static int         cnt[TUNE_PHASES][TUNE_MAX_CAND];
+static int         tune_cycles, tune_seen, tuning;
+
+void tune_apply(TunePhase ph) {
+#ifdef _OPENMP
+    omp_set_schedule((omp_sched_t)current[ph].kind, current[ph].chunk);
+#else
+    (void)ph;
+#endif
+}
+
+int tune_threads(TunePhase ph) {
+    return current[ph].threads;
+}
+
+int tune_block(TunePhase ph, int n, int *lo, int *hi) {
+    int nt = 1, tid = 0;
+#ifdef _OPENMP
+    nt  = omp_get_num_threads();
+    tid = omp_get_thread_num();
+#endif
+    int active = current[ph].threads;
+    if (active <= 0 || active >= nt)
+        return 0;
+
+    int k = tid - (nt - active);
+    *lo = *hi = 0;
+    if (k >= 0) {
+        *lo = (int)((long)n * k / active);
+        *hi = (int)((long)n * (k + 1) / active);
+    }
+    return 1;
+}
+
+TuneSetting tune_get(TunePhase ph) {
+    return current[ph];
+}
+
+void tune_set(TunePhase ph, TuneSetting s) {
+    current[ph] = s;
+}
+
+const char *tune_format(TuneSetting s, char *buf, int len) {
+    if (s.threads > 0)
+        snprintf(buf, (size_t)len, "%s,%d,%d", kind_names[s.kind], s.chunk,
+                 s.threads);
+    else
+        snprintf(buf, (size_t)len, "%s,%d", kind_names[s.kind], s.chunk);
+    return buf;
+}
+
+static int parse_setting(const char *text, TuneSetting *s) {
+    char kind[16];
+    int  chunk = 0, threads = 0;
+    int  n = sscanf(text, "%15[a-z],%d,%d", kind, &chunk, &threads);
+    if (n < 2 || chunk < 0 || threads < 0) return -1;
+    for (int k = 1; k < 4; k++) {
+        if (strcmp(kind, kind_names[k]) == 0) {
+            s->kind    = k;
+            s->chunk   = chunk;
+            s->threads = threads;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int tune_load(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    TuneSetting next[TUNE_PHASES];
+    memcpy(next, current, sizeof(next));
+
+    char line[128];
+    int  rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+        char *eq = strchr(line, '=');
+        if (!eq) { rc = -1; break; }
+        *eq = '\0';
+        int ph = -1;
+        for (int p = 0; p < TUNE_PHASES; p++)
+            if (strcmp(line, phase_names[p]) == 0) ph = p;
+        if (ph < 0 || parse_setting(eq + 1, &next[ph]) != 0)
+            rc = -1;
+    }
+    fclose(f);
+
+    if (rc == 0)
+        memcpy(current, next, sizeof(current));
+    return rc;
+}
+
+int tune_save(const char *path, const char *comment) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    if (comment)
+        fprintf(f, "# %s\n", comment);
+    for (int p = 0; p < TUNE_PHASES; p++) {
+        char buf[48];
+        fprintf(f, "%s=%s\n", phase_names[p], tune_format(current[p], buf,
+                                                          sizeof(buf)));
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void add_cand(TunePhase ph, int kind, int chunk, int threads) {
+    if (ncand[ph] == TUNE_MAX_CAND) return;
+    cand[ph][ncand[ph]++] = (TuneSetting){ kind, chunk, threads };
+}
+
+/* Candidatos do ciclo k: rodízio independente em cada fase. */
+static void apply_round(int k) {
+    for (int p = 0; p < TUNE_PHASES; p++)
+        current[p] = cand[p][k % ncand[p]];
+}
+
+void autotune_begin(int cycles, int nthreads) {
+    memset(ncand, 0, sizeof(ncand));
+    memset(sum, 0, sizeof(sum));
+    memset(cnt, 0, sizeof(cnt));
+
+    /* Carga e decisão: custo por agente irregular. */
+    static const int chunks[3] = { 1, 8, 32 };
+    for (int p = TUNE_WORKLOAD; p <= TUNE_DECIDE; p++) {
+        add_cand((TunePhase)p, 1, 0, 0);
+        for (int k = 2; k <= 3; k++)
+            for (int c = 0; c < 3; c++)
+                add_cand((TunePhase)p, k, chunks[c], 0);
+    }
+
+    /* Regeneração: custo uniforme, limitada por banda. */
+    add_cand(TUNE_GRID, 1, 0, 0);
+    add_cand(TUNE_GRID, 2, 4, 0);
+    add_cand(TUNE_GRID, 2, 16, 0);
+    add_cand(TUNE_GRID, 3, 4, 0);
+
+    /* Toda fase também testa metade e um quarto da equipe: com banda ou
+     * cache saturados, menos threads podem terminar antes. */
+    int half = nthreads / 2, quarter = nthreads / 4;
+    for (int p = 0; p < TUNE_PHASES; p++) {
+        if (half >= 1)
+            add_cand((TunePhase)p, 1, 0, half);
+        if (quarter >= 1 && quarter != half)
+            add_cand((TunePhase)p, 1, 0, quarter);
+    }
+
+    tune_cycles = cycles;
+    tune_seen   = 0;
+    tuning      = cycles > 0;
+    if (tuning)
+        apply_round(0);
+}
+
+int autotune_active(void) {
+    return tuning;
+}
+
+#ifdef USE_MPI
+
+int autotune_record(const double t[TUNE_PHASES], MPI_Comm comm) {
+    if (!tuning) return 0;
+
+    double tmax[TUNE_PHASES];
+    MPI_Allreduce(t, tmax, TUNE_PHASES, MPI_DOUBLE, MPI_MAX, comm);
+
+    /* O primeiro ciclo aquece caches e a arena: descartado. */
+    if (tune_seen > 0) {
+        for (int p = 0; p < TUNE_PHASES; p++) {
+            int i = tune_seen % ncand[p];
+            sum[p][i] += tmax[p];
+            cnt[p][i]++;
+        }
+    }
+    tune_seen++;
+
+    if (tune_seen < tune_cycles) {
+        apply_round(tune_seen);
+        return 0;
+    }
+
+    /* Fixa, por fase, o candidato de menor média; sem amostras, o padrão. */
+    const TuneSetting defaults[TUNE_PHASES] = TUNE_DEFAULTS;
+    for (int p = 0; p < TUNE_PHASES; p++) {
+        double best = DBL_MAX;
+        current[p] = defaults[p];
+        for (int i = 0; i < ncand[p]; i++) {
+            if (cnt[p][i] == 0) continue;
+            double mean = sum[p][i] / cnt[p][i];
+            if (mean < best) {
+                best       = mean;
+                current[p] = cand[p][i];
+            }
+        }
+    }
+    tuning = 0;
+    return 1;
+}
+
+#endif /* USE_MPI */
@@ -0,0 +1,164 @@
+#include "benchrun.h"
+#include "arena.h"
+#include "halo.h"
+#include "workload.h"
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* Mesma ordem dos campos de tempo de CyclePerf. */
+static const char *const time_names[CYCLEPERF_NTIMES] = {
+    "cycle", "season", "halo", "workload", "agent", "reproduce",
+    "grid", "migrate", "metrics", "render", "overlap", "spread"
+};
+
+void benchrun_init(BenchRun *b, int reps, int warmup) {
+    memset(b, 0, sizeof(*b));
+    b->warmup     = warmup;
+    b->agent_rate = sim_calloc((size_t)reps, sizeof(double));
+    b->cell_rate  = sim_calloc((size_t)reps, sizeof(double));
+}
+
+void benchrun_cycle(BenchRun *b, const double *times, int agents,
+                    double cells) {
+    for (int k = 0; k < CYCLEPERF_NTIMES; k++) {
+        b->sum[k]   += times[k];
+        b->sumsq[k] += times[k] * times[k];
+    }
+    b->cycles++;
+    b->rep_time   += times[0];
+    b->rep_agents += agents;
+    b->rep_cells  += cells;
+}
+
+void benchrun_end_rep(BenchRun *b) {
+    if (b->rep_time > 0.0) {
+        b->agent_rate[b->reps] = b->rep_agents / b->rep_time;
+        b->cell_rate[b->reps]  = b->rep_cells / b->rep_time;
+    }
+    b->reps++;
+    b->rep_time = b->rep_agents = b->rep_cells = 0.0;
+}
+
+/* Média e desvio-padrão amostral (n - 1) de v[n]. */
+static void mean_std(const double *v, int n, double *mean, double *std) {
+    double s = 0.0, s2 = 0.0;
+    for (int i = 0; i < n; i++) {
+        s  += v[i];
+        s2 += v[i] * v[i];
+    }
+    *mean = n > 0 ? s / n : 0.0;
+    *std  = n > 1 ? sqrt(fmax(0.0, (s2 - s * *mean) / (n - 1))) : 0.0;
+}
+
+double benchrun_agent_rate(const BenchRun *b) {
+    double mean, std;
+    mean_std(b->agent_rate, b->reps, &mean, &std);
+    return mean;
+}
+
+/* Custo do tempo virtual (--model), ou null com a carga executada. */
+static void print_model(FILE *out, const SimConfig *cfg) {
+    if (cfg->model)
+        fprintf(out, ", \"model\": {\"ns_per_iter\": %.4f, \"threads\": %d}",
+                cfg->model_ns, cfg->model_threads);
+    else
+        fprintf(out, ", \"model\": null");
+}
+
+/* Média e desvio do tempo k de CyclePerf sobre os ciclos medidos. */
+static void pooled(const BenchRun *b, int k, double *mean, double *std) {
+    double n = (double)b->cycles;
+    *mean = n > 0 ? b->sum[k] / n : 0.0;
+    *std  = n > 1 ? sqrt(fmax(0.0, (b->sumsq[k] - b->sum[k] * *mean)
+                                   / (n - 1))) : 0.0;
+}
+
+void benchrun_print(FILE *out, const BenchRun *b, const SimConfig *cfg,
+                    int ranks, int threads, double ref_rate) {
+    double am, as, cm, cs;
+    mean_std(b->agent_rate, b->reps, &am, &as);
+    mean_std(b->cell_rate, b->reps, &cm, &cs);
+    const int cores = ranks * threads;
+
+    fprintf(out, "{\n  \"config\": {\"grid\": [%d, %d], \"agents\": %d, "
+            "\"cycles\": %d, \"workload\": %d, \"ranks\": %d, "
+            "\"threads\": %d, \"halo\": \"%s\", \"exec\": \"%s\", "
+            "\"workload_sched\": \"%s\", \"workload_profile\": \"%s\", "
+            "\"seed\": %llu",
+            cfg->global_w, cfg->global_h, cfg->num_agents, cfg->total_cycles,
+            cfg->max_workload, ranks, threads,
+            halo_mode_name((HaloMode)cfg->halo_mode),
+            cfg->exec_tasks ? "tasks" : "phased",
+            cfg->workload_lpt ? "lpt" : "omp",
+            workload_profile_name((WorkloadProfile)cfg->workload_profile),
+            (unsigned long long)cfg->seed);
+    print_model(out, cfg);
+    fprintf(out, "},\n");
+    fprintf(out, "  \"reps\": %d,\n  \"warmup_cycles\": %d,\n"
+            "  \"measured_cycles\": %ld,\n", b->reps, b->warmup, b->cycles);
+    fprintf(out, "  \"agent_updates_per_s\": {\"mean\": %.1f, \"stddev\": %.1f},\n",
+            am, as);
+    fprintf(out, "  \"cell_updates_per_s\": {\"mean\": %.1f, \"stddev\": %.1f},\n",
+            cm, cs);
+    fprintf(out, "  \"agent_updates_per_s_per_core\": %.1f,\n", am / cores);
+    if (ref_rate > 0.0)
+        fprintf(out, "  \"parallel_efficiency\": %.4f,\n"
+                "  \"reference_agent_updates_per_s\": %.1f,\n",
+                am / (cores * ref_rate), ref_rate);
+    else if (cores == 1)
+        fprintf(out, "  \"parallel_efficiency\": 1.0,\n"
+                "  \"reference_agent_updates_per_s\": null,\n");
+    else
+        fprintf(out, "  \"parallel_efficiency\": null,\n"
+                "  \"reference_agent_updates_per_s\": null,\n");
+
+    fprintf(out, "  \"phases_ms\": {");
+    for (int k = 0; k < CYCLEPERF_NTIMES; k++) {
+        double mean, std;
+        pooled(b, k, &mean, &std);
+        fprintf(out, "%s\n    \"%s\": {\"mean\": %.4f, \"stddev\": %.4f}",
+                k ? "," : "", time_names[k], mean * 1e3, std * 1e3);
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+
+void benchrun_weak_print(FILE *out, const WeakPoint *pts, int n,
+                         const SimConfig *cfg, int threads) {
+    double ref, ref_std;
+    mean_std(pts[0].run.agent_rate, pts[0].run.reps, &ref, &ref_std);
+
+    fprintf(out, "{\n  \"weak_scaling\": {\"cells_per_rank\": [%d, %d], "
+            "\"agents_per_rank\": %d, \"threads\": %d, \"cycles\": %d, "
+            "\"workload\": %d, \"workload_profile\": \"%s\", "
+            "\"halo\": \"%s\", \"reps\": %d, "
+            "\"warmup_cycles\": %d",
+            cfg->rank_w, cfg->rank_h, cfg->agents_per_rank, threads,
+            cfg->total_cycles, cfg->max_workload,
+            workload_profile_name((WorkloadProfile)cfg->workload_profile),
+            halo_mode_name((HaloMode)cfg->halo_mode),
+            pts[0].run.reps, pts[0].run.warmup);
+    print_model(out, cfg);
+    fprintf(out, "},\n  \"points\": [");
+    for (int i = 0; i < n; i++) {
+        const WeakPoint *w = &pts[i];
+        double am, as, cm, cs;
+        mean_std(w->run.agent_rate, w->run.reps, &am, &as);
+        pooled(&w->run, 0, &cm, &cs);
+        fprintf(out, "%s\n    {\"ranks\": %d, \"grid\": [%d, %d], "
+                "\"agents\": %d, \"cycle_ms\": {\"mean\": %.4f, "
+                "\"stddev\": %.4f}, \"agent_updates_per_s\": {\"mean\": %.1f, "
+                "\"stddev\": %.1f}, \"efficiency\": %.4f}",
+                i ? "," : "", w->ranks, w->global_w, w->global_h, w->agents,
+                cm * 1e3, cs * 1e3, am, as,
+                ref > 0.0 ? am / (w->ranks * ref) : 0.0);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void benchrun_free(BenchRun *b) {
+    free(b->agent_rate);
+    free(b->cell_rate);
+    b->agent_rate = b->cell_rate = NULL;
+}
@@ -0,0 +1,204 @@
+#include "commmat.h"
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int commmat_enabled = 0;
+
+static const char *const phase_names[WIRE_PHASE_COUNT] = {
+    "halo", "migrate", "gather"
+};
+
+static int       nr;
+static uint64_t *mat_bytes;    /* [fase][destino] */
+static uint64_t *mat_msgs;
+static uint64_t  size_hist[WIRE_PHASE_COUNT][COMMMAT_SIZE_BUCKETS];
+static uint64_t  migrants[COMMMAT_DIRS];
+static uint64_t  cur[WIRE_PHASE_COUNT][2];    /* bytes, mensagens */
+static uint64_t *cycles;       /* cur de cada ciclo fechado */
+static size_t    ncycles, cycles_cap;
+
+void commmat_init(int nranks) {
+    nr        = nranks;
+    mat_bytes = sim_calloc((size_t)WIRE_PHASE_COUNT * nr, sizeof(uint64_t));
+    mat_msgs  = sim_calloc((size_t)WIRE_PHASE_COUNT * nr, sizeof(uint64_t));
+    memset(size_hist, 0, sizeof(size_hist));
+    memset(migrants, 0, sizeof(migrants));
+    memset(cur, 0, sizeof(cur));
+    ncycles         = 0;
+    commmat_enabled = 1;
+}
+
+static int size_bucket(uint64_t bytes) {
+    int k = 0;
+    while (bytes > 1 && k < COMMMAT_SIZE_BUCKETS - 1) {
+        bytes >>= 1;
+        k++;
+    }
+    return k;
+}
+
+void commmat_record(WirePhase ph, int dest, uint64_t bytes) {
+    if (dest < 0 || dest >= nr) return;    /* MPI_PROC_NULL */
+    mat_bytes[ph * nr + dest] += bytes;
+    mat_msgs[ph * nr + dest]++;
+    size_hist[ph][size_bucket(bytes)]++;
+    cur[ph][0] += bytes;
+    cur[ph][1]++;
+}
+
+void commmat_record_migrant(int dir) {
+    migrants[dir]++;
+}
+
+void commmat_end_cycle(void) {
+    const size_t rec = WIRE_PHASE_COUNT * 2;
+    if ((ncycles + 1) * rec > cycles_cap) {
+        cycles_cap = cycles_cap ? 2 * cycles_cap : 256 * rec;
+        cycles = sim_realloc(cycles, sizeof(uint64_t) * cycles_cap);
+    }
+    memcpy(cycles + ncycles * rec, cur, sizeof(cur));
+    memset(cur, 0, sizeof(cur));
+    ncycles++;
+}
+
+#ifdef USE_MPI
+
+#include <mpi.h>
+
+static void write_matrix(FILE *f, const char *title, int ph,
+                         const uint64_t *all) {
+    fprintf(f, "# %s %s (row = sender, column = receiver)\nsrc",
+            phase_names[ph], title);
+    for (int d = 0; d < nr; d++)
+        fprintf(f, ",%d", d);
+    fprintf(f, "\n");
+    for (int s = 0; s < nr; s++) {
+        fprintf(f, "%d", s);
+        for (int d = 0; d < nr; d++)
+            fprintf(f, ",%llu", (unsigned long long)
+                    all[((size_t)s * WIRE_PHASE_COUNT + ph) * nr + d]);
+        fprintf(f, "\n");
+    }
+}
+
+int commmat_write(const char *path, const Partition *p, double *nbr_share) {
+    MPI_Comm comm = p->cart_comm;
+    const size_t row = (size_t)WIRE_PHASE_COUNT * nr;
+    const size_t rec = WIRE_PHASE_COUNT * 2;
+    commmat_enabled = 0;
+
+    /* Posição na grade de processos e nó de cada rank. */
+    int  coords[2] = { p->my_row, p->my_col };
+    char host[MPI_MAX_PROCESSOR_NAME] = {0};
+    int  hlen;
+    MPI_Get_processor_name(host, &hlen);
+
+    int      *all_coords = NULL;
+    char     *all_hosts  = NULL;
+    uint64_t *all_bytes  = NULL, *all_msgs = NULL, *sum_cycles = NULL;
+    uint64_t  sum_hist[WIRE_PHASE_COUNT][COMMMAT_SIZE_BUCKETS];
+    uint64_t  sum_mig[COMMMAT_DIRS];
+    if (p->rank == 0) {
+        all_coords = sim_malloc(sizeof(int) * 2 * (size_t)nr);
+        all_hosts  = sim_malloc((size_t)MPI_MAX_PROCESSOR_NAME * nr);
+        all_bytes  = sim_malloc(sizeof(uint64_t) * row * nr);
+        all_msgs   = sim_malloc(sizeof(uint64_t) * row * nr);
+        sum_cycles = sim_malloc(sizeof(uint64_t) * (ncycles * rec + 1));
+    }
+    MPI_Gather(coords, 2, MPI_INT, all_coords, 2, MPI_INT, 0, comm);
+    MPI_Gather(host, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+               all_hosts, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, comm);
+    MPI_Gather(mat_bytes, (int)row, MPI_UINT64_T,
+               all_bytes, (int)row, MPI_UINT64_T, 0, comm);
+    MPI_Gather(mat_msgs, (int)row, MPI_UINT64_T,
+               all_msgs, (int)row, MPI_UINT64_T, 0, comm);
+    MPI_Reduce(size_hist, sum_hist, WIRE_PHASE_COUNT * COMMMAT_SIZE_BUCKETS,
+               MPI_UINT64_T, MPI_SUM, 0, comm);
+    MPI_Reduce(migrants, sum_mig, COMMMAT_DIRS, MPI_UINT64_T, MPI_SUM, 0,
+               comm);
+    MPI_Reduce(cycles, sum_cycles, (int)(ncycles * rec), MPI_UINT64_T,
+               MPI_SUM, 0, comm);
+
+    int rc = 0;
+    if (p->rank == 0) {
+        uint64_t mig_total = 0;
+        for (int d = 0; d < COMMMAT_DIRS; d++)
+            mig_total += sum_mig[d];
+        *nbr_share = mig_total
+            ? 1.0 - (double)sum_mig[COMMMAT_DIR_OTHER] / (double)mig_total
+            : -1.0;
+
+        FILE *f = fopen(path, "w");
+        if (!f) {
+            rc = -1;
+        } else {
+            fprintf(f, "# comm matrix: %d ranks, process grid %dx%d "
+                    "(rows x cols)\n", nr, p->py, p->px);
+            fprintf(f, "# ranks\nrank,row,col,host\n");
+            for (int r = 0; r < nr; r++)
+                fprintf(f, "%d,%d,%d,%s\n", r, all_coords[2 * r],
+                        all_coords[2 * r + 1],
+                        all_hosts + (size_t)r * MPI_MAX_PROCESSOR_NAME);
+
+            for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++) {
+                write_matrix(f, "bytes", ph, all_bytes);
+                write_matrix(f, "messages", ph, all_msgs);
+            }
+
+            fprintf(f, "# message sizes (messages in [bytes_lo, 2*bytes_lo))\n"
+                    "bytes_lo");
+            for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++)
+                fprintf(f, ",%s", phase_names[ph]);
+            fprintf(f, "\n");
+            for (int k = 0; k < COMMMAT_SIZE_BUCKETS; k++) {
+                uint64_t any = 0;
+                for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++)
+                    any |= sum_hist[ph][k];
+                if (!any) continue;
+                fprintf(f, "%llu", 1ull << k);
+                for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++)
+                    fprintf(f, ",%llu", (unsigned long long)sum_hist[ph][k]);
+                fprintf(f, "\n");
+            }
+
+            fprintf(f, "# migrants per direction (other = owner is not the "
+                    "neighbour in that direction)\n"
+                    "N,S,E,W,NE,NW,SE,SW,other\n");
+            for (int d = 0; d < COMMMAT_DIRS; d++)
+                fprintf(f, "%s%llu", d ? "," : "",
+                        (unsigned long long)sum_mig[d]);
+            fprintf(f, "\n");
+
+            fprintf(f, "# per cycle (sum over ranks)\ncycle");
+            for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++)
+                fprintf(f, ",%s_bytes,%s_msgs", phase_names[ph],
+                        phase_names[ph]);
+            fprintf(f, "\n");
+            for (size_t c = 0; c < ncycles; c++) {
+                fprintf(f, "%zu", c);
+                for (size_t k = 0; k < rec; k++)
+                    fprintf(f, ",%llu",
+                            (unsigned long long)sum_cycles[c * rec + k]);
+                fprintf(f, "\n");
+            }
+            fclose(f);
+        }
+        free(all_coords);
+        free(all_hosts);
+        free(all_bytes);
+        free(all_msgs);
+        free(sum_cycles);
+    }
+
+    free(mat_bytes);
+    free(mat_msgs);
+    free(cycles);
+    mat_bytes  = mat_msgs = cycles = NULL;
+    cycles_cap = ncycles = 0;
+    return rc;
+}
+
+#endif /* USE_MPI */
@@ -0,0 +1,51 @@
+#include "commthread.h"
+
+#include <omp.h>
+
+static int compute_threads = 1;
+
+int comm_thread_init(int nthreads) {
+    if (nthreads < 2) return 0;
+    compute_threads = nthreads - 1;
+    omp_set_max_active_levels(2);
+    return 1;
+}
+
+int comm_thread_compute_threads(void) {
+    return compute_threads;
+}
+
+void comm_thread_overlap(CommTaskFn comm, void *comm_arg,
+                         CommTaskFn compute, void *compute_arg,
+                         OverlapTimes *t) {
+    double t_comm = 0.0, t_compute = 0.0;
+    double t0 = omp_get_wtime();
+
+    /* Thread 0 lidera a equipe de computação (mantém a afinidade da
+     * thread principal); a thread 1 faz o MPI. */
+    #pragma omp parallel num_threads(2)
+    {
+        double ts = omp_get_wtime();
+        if (omp_get_num_threads() < 2) {
+            /* Runtime negou a segunda thread: executa em sequência. */
+            if (comm) comm(comm_arg);
+            t_comm = omp_get_wtime() - ts;
+            ts = omp_get_wtime();
+            if (compute) compute(compute_arg);
+            t_compute = omp_get_wtime() - ts;
+        } else if (omp_get_thread_num() == 1) {
+            if (comm) comm(comm_arg);
+            t_comm = omp_get_wtime() - ts;
+        } else {
+            omp_set_num_threads(compute_threads);
+            if (compute) compute(compute_arg);
+            t_compute = omp_get_wtime() - ts;
+        }
+    }
+
+    double pair = omp_get_wtime() - t0;
+    double overlap = t_comm + t_compute - pair;
+    t->comm_time    += t_comm;
+    t->compute_time += t_compute;
+    t->overlap_time += (overlap > 0.0) ? overlap : 0.0;
+}
@@ -0,0 +1,83 @@
+#include "digest.h"
+#include "grid.h"
+#include "pool.h"
+
+#include <string.h>
+
+/* Finalizador do splitmix64: espalha cada bit da entrada. */
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline uint64_t double_bits(double v) {
+    uint64_t b;
+    memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+static inline uint64_t coord_key(int gx, int gy) {
+    return ((uint64_t)(uint32_t)gy << 32) | (uint32_t)gx;
+}
+
+void digest_local(const SubGrid *sg, const AgentPool *pool,
+                  uint64_t out[DIGEST_WORDS]) {
+    const int h = sg->halo;
+    uint64_t cells = 0, agents = 0, count = 0;
+
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static) reduction(+:cells) nowait
+        for (int r = h; r < h + sg->local_h; r++) {
+            const int gy = sg->offset_y + r - h;
+            for (int c = h; c < h + sg->local_w; c++) {
+                const Cell *cell = &sg->cells[CELL_AT(sg, r, c)];
+                uint64_t k = mix64(coord_key(sg->offset_x + c - h, gy));
+                k = mix64(k ^ double_bits(cell->resource));
+                k = mix64(k ^ double_bits(cell->max_resource));
+                cells += mix64(k ^ (uint64_t)cell->type);
+            }
+        }
+
+        /* Fantasmas do anel (--halo-depth) ficam fora do interior. */
+        #pragma omp for schedule(static) reduction(+:agents,count)
+        for (int i = 0; i < pool->count; i++) {
+            if (!pool_alive(pool, i) ||
+                !subgrid_interior(sg, pool->x[i], pool->y[i]))
+                continue;
+            uint32_t e;
+            memcpy(&e, &pool->energy[i], sizeof(e));
+            uint64_t k = mix64(pool->id[i] + 0x9e3779b97f4a7c15ULL);
+            k = mix64(k ^ coord_key(sg->offset_x + pool->x[i] - h,
+                                    sg->offset_y + pool->y[i] - h));
+            agents += mix64(k ^ e);
+            count++;
+        }
+    }
+
+    out[0] = cells;
+    out[1] = agents;
+    out[2] = count;
+}
+
+uint64_t digest_finish(const uint64_t sum[DIGEST_WORDS]) {
+    return mix64(sum[0] ^ mix64(sum[1] ^ mix64(sum[2])));
+}
+
+#ifdef USE_MPI
+
+#include <mpi.h>
+
+uint64_t digest_global(const SubGrid *sg, const AgentPool *pool,
+                       MPI_Comm comm) {
+    uint64_t local[DIGEST_WORDS], sum[DIGEST_WORDS] = {0};
+    digest_local(sg, pool, local);
+    MPI_Reduce(local, sum, DIGEST_WORDS, MPI_UINT64_T, MPI_SUM, 0, comm);
+    return digest_finish(sum);
+}
+
+#endif /* USE_MPI */
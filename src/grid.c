@@ -1,4 +1,7 @@
 #include "grid.h"
+#include "arena.h"
+#include "autotune.h"
+#include "trace.h"
 #include "partition.h"
 #include "rng.h"
 #include "season.h"
@@ -10,7 +13,7 @@
 #include <omp.h>
 #endif
 
-static const double max_resources[5] = {
+static const double max_resources[CELL_TYPES] = {
     0.5,  /* ALDEIA      */
     1.0,  /* PESCA       */
     0.8,  /* COLETA      */
@@ -18,8 +21,21 @@ static const double max_resources[5] = {
     0.0   /* INTERDITADA */
 };
 
+double grid_max_resource(CellType type) {
+    return max_resources[type];
+}
+
+/* Vizinho cardinal d (N, S, E, W = 0..3) existe? */
+static int has_neighbor(const Partition *p, int d) {
+#ifdef USE_MPI
+    return p->neighbors[d] != MPI_PROC_NULL;
+#else
+    return p->neighbors[d] >= 0;
+#endif
+}
+
 void subgrid_create(SubGrid *sg, Partition *p,
-                    int global_w, int global_h) {
+                    int global_w, int global_h, int halo) {
     int local_w, local_h, offset_x, offset_y;
     partition_subgrid_dims(p, global_w, global_h,
                            &local_w, &local_h, &offset_x, &offset_y);
@@ -28,58 +44,200 @@ void subgrid_create(SubGrid *sg, Partition *p,
     sg->local_h  = local_h;
     sg->offset_x = offset_x;
     sg->offset_y = offset_y;
-    sg->halo_w   = local_w + 2;
-    sg->halo_h   = local_h + 2;
-
-    sg->cells = calloc((size_t)sg->halo_h * sg->halo_w, sizeof(Cell));
+    sg->halo     = halo;
+    sg->halo_w   = local_w + 2 * halo;
+    sg->halo_h   = local_h + 2 * halo;
+
+    /* Interior; com halo profundo, estende sobre o anel dos lados com vizinho. */
+    int ring = (halo > 1) ? halo : 0;
+    sg->box_r0 = halo - (has_neighbor(p, 0) ? ring : 0);
+    sg->box_r1 = halo + local_h - 1 + (has_neighbor(p, 1) ? ring : 0);
+    sg->box_c0 = halo - (has_neighbor(p, 3) ? ring : 0);
+    sg->box_c1 = halo + local_w - 1 + (has_neighbor(p, 2) ? ring : 0);
+
+    sg->cells = sim_calloc((size_t)sg->halo_h * sg->halo_w, sizeof(Cell));
+
+    sg->plane_words   = (sg->halo_h * sg->halo_w + 63) / 64;
+    sg->access_planes = sim_calloc((size_t)SEASON_COUNT * sg->plane_words,
+                                   sizeof(uint64_t));
+    sg->access        = sg->access_planes;
 }
 
 void subgrid_init(SubGrid *sg, Partition *p, uint64_t seed) {
-    (void)p;  /* offsets já estão armazenados no SubGrid */
-
-    for (int r = 1; r <= sg->local_h; r++) {
-        for (int c = 1; c <= sg->local_w; c++) {
-            int gx = sg->offset_x + (c - 1);
-            int gy = sg->offset_y + (r - 1);
-
-            uint64_t cseed = rng_cell_seed(seed, gx, gy);
-            RngState rng   = rng_seed(cseed);
-
-            CellType type    = (CellType)(rng_next(&rng) % 5);
-            double   max_res = max_resources[type];
+    /*
+     * Inclui o halo: tipos são estáticos e derivam da seed por célula,
+     * então os planos de acessibilidade já nascem completos. Células de
+     * halo fora do domínio global (lados sem vizinho) ficam INTERDITADA.
+     */
+    const int h = sg->halo;
+    for (int r = 0; r < sg->halo_h; r++) {
+        for (int c = 0; c < sg->halo_w; c++) {
+            int outside = (r < h && !has_neighbor(p, 0)) ||
+                          (r >= h + sg->local_h && !has_neighbor(p, 1)) ||
+                          (c >= h + sg->local_w && !has_neighbor(p, 2)) ||
+                          (c < h && !has_neighbor(p, 3));
+            CellType type = INTERDITADA;
+            if (!outside) {
+                int gx = sg->offset_x + (c - h);
+                int gy = sg->offset_y + (r - h);
+
+                uint64_t cseed = rng_cell_seed(seed, gx, gy);
+                RngState rng   = rng_seed(cseed);
+                type = (CellType)(rng_next(&rng) % CELL_TYPES);
+            }
 
             int idx = CELL_AT(sg, r, c);
             sg->cells[idx].type         = type;
-            sg->cells[idx].max_resource = max_res;
+            sg->cells[idx].max_resource = max_resources[type];
             sg->cells[idx].resource     = 0.0;
-            sg->cells[idx].accessible   = 1;
+
+            for (int s = 0; s < SEASON_COUNT; s++) {
+                if (season_accessibility(type, (Season)s))
+                    sg->access_planes[(size_t)s * sg->plane_words + (idx >> 6)]
+                        |= 1ULL << (idx & 63);
+            }
         }
     }
 }
 
-void subgrid_update(SubGrid *sg, Season season) {
-    #pragma omp parallel for collapse(2) schedule(static)
-    for (int r = 1; r <= sg->local_h; r++) {
-        for (int c = 1; c <= sg->local_w; c++) {
-            int   idx  = CELL_AT(sg, r, c);
-            Cell *cell = &sg->cells[idx];
+/* Taxas por tipo, resolvidas uma vez por chamada. */
+typedef struct {
+    double regen[CELL_TYPES];
+} SweepTables;
 
-            double regen = season_regen_rate(cell->type, season);
-            cell->resource += regen * (cell->max_resource - cell->resource);
+static void sweep_tables(SweepTables *t, Season season) {
+    for (int k = 0; k < CELL_TYPES; k++)
+        t->regen[k] = season_regen_rate((CellType)k, season);
+}
+
+static inline void update_cell(Cell *cell, const SweepTables *t) {
+    cell->resource += t->regen[cell->type] * (cell->max_resource - cell->resource);
 
-            if (cell->resource < 0.0)
-                cell->resource = 0.0;
-            if (cell->resource > cell->max_resource)
-                cell->resource = cell->max_resource;
+    if (cell->resource < 0.0)
+        cell->resource = 0.0;
+    if (cell->resource > cell->max_resource)
+        cell->resource = cell->max_resource;
+}
+
+/* Regenera [c0, c1] da linha r; devolve a soma de [s0, s1) e por tipo. */
+static void sweep_span(Cell *row, const SweepTables *t, int c0, int c1,
+                       int s0, int s1, double *sum, double *type_sum) {
+    int c = c0;
+    for (; c < s0 && c <= c1; c++)
+        update_cell(&row[c], t);
+
+    double s = 0.0;
+    for (; c < s1 && c <= c1; c++) {
+        update_cell(&row[c], t);
+        s += row[c].resource;
+        type_sum[row[c].type] += row[c].resource;
+    }
+    *sum = s;
+
+    for (; c <= c1; c++)
+        update_cell(&row[c], t);
+}
+
+void grid_sweep_alloc(GridSweep *gs, const SubGrid *sg, Arena *arena) {
+    gs->row_resource  = arena_alloc(arena, sizeof(double) * (size_t)sg->local_h);
+    gs->type_resource = arena_alloc(arena, sizeof(double) * CELL_TYPES *
+                                           (size_t)sg->local_h);
+}
 
-            cell->accessible = season_accessibility(cell->type, season);
+void grid_sweep_total(const GridSweep *gs, const SubGrid *sg,
+                      double *total, double type_total[CELL_TYPES]) {
+    double s = 0.0;
+    for (int k = 0; k < CELL_TYPES; k++)
+        type_total[k] = 0.0;
+    for (int r = 0; r < sg->local_h; r++) {
+        s += gs->row_resource[r];
+        for (int k = 0; k < CELL_TYPES; k++)
+            type_total[k] += gs->type_resource[r * CELL_TYPES + k];
+    }
+    *total = s;
+}
+
+void subgrid_sum_rows_team(const SubGrid *sg, GridSweep *gs) {
+    const int h = sg->halo;
+    #pragma omp for schedule(static) nowait
+    for (int i = 0; i < sg->local_h; i++) {
+        const Cell *row = &sg->cells[CELL_AT(sg, h + i, 0)];
+        double *ts = &gs->type_resource[i * CELL_TYPES];
+        double  s  = 0.0;
+        for (int k = 0; k < CELL_TYPES; k++)
+            ts[k] = 0.0;
+        /* Mesma ordem de soma de sweep_span: resultados idênticos. */
+        for (int c = h; c < h + sg->local_w; c++) {
+            s += row[c].resource;
+            ts[row[c].type] += row[c].resource;
         }
+        gs->row_resource[i] = s;
+    }
+}
+
+void subgrid_update(SubGrid *sg, Season season, GridSweep *gs) {
+    #pragma omp parallel
+    subgrid_update_team(sg, season, gs);
+}
+
+void subgrid_update_team(SubGrid *sg, Season season, GridSweep *gs) {
+    int lo, hi;
+    if (tune_block(TUNE_GRID, sg->box_r1 - sg->box_r0 + 1, &lo, &hi)) {
+        /* Menos threads que a equipe (passada limitada por banda). */
+        if (lo == hi) return;
+        double t0 = trace_begin();
+        for (int r = sg->box_r0 + lo; r < sg->box_r0 + hi; r++)
+            subgrid_update_row(sg, season, r, gs);
+        trace_end(TR_GRID, t0);
+        return;
+    }
+
+    /* Padrão: chunks dinâmicos de 4 linhas — threads que chegam
+     * atrasadas (a master) pegam só o que sobrou. */
+    TRACE_SCOPE(TR_GRID) {
+        tune_apply(TUNE_GRID);
+        #pragma omp for schedule(runtime) nowait
+        for (int r = sg->box_r0; r <= sg->box_r1; r++)
+            subgrid_update_row(sg, season, r, gs);
+    }
+}
+
+void subgrid_update_row(SubGrid *sg, Season season, int r, GridSweep *gs) {
+    SweepTables t;
+    sweep_tables(&t, season);
+
+    const int h = sg->halo;
+    Cell *row = &sg->cells[CELL_AT(sg, r, 0)];
+    if (!gs || r < h || r >= h + sg->local_h) {
+        for (int c = sg->box_c0; c <= sg->box_c1; c++)
+            update_cell(&row[c], &t);
+        return;
     }
+
+    /* Linha do interior: regenera a caixa e acumula as parciais da
+     * linha na mesma passada. */
+    double *ts = &gs->type_resource[(r - h) * CELL_TYPES];
+    for (int k = 0; k < CELL_TYPES; k++)
+        ts[k] = 0.0;
+    sweep_span(row, &t, sg->box_c0, sg->box_c1, h, h + sg->local_w,
+               &gs->row_resource[r - h], ts);
+}
+
+void subgrid_update_span(SubGrid *sg, Season season, int r, int c0, int c1) {
+    SweepTables t;
+    sweep_tables(&t, season);
+
+    Cell *row = &sg->cells[CELL_AT(sg, r, 0)];
+    for (int c = c0; c <= c1; c++)
+        update_cell(&row[c], &t);
 }
 
 void subgrid_destroy(SubGrid *sg) {
     if (sg) {
         free(sg->cells);
-        sg->cells = NULL;
+        free(sg->access_planes);
+        sg->cells         = NULL;
+        sg->access_planes = NULL;
+        sg->access        = NULL;
     }
 }
@@ -1,119 +1,652 @@
-#ifdef USE_MPI
+#define _POSIX_C_SOURCE 200112L  /* sched_yield */
 
 #include "halo.h"
+#include "arena.h"
+#include "commmat.h"
+#include "grid.h"
+#include "pack.h"
+#include "trace.h"
 #include "types.h"
-#include <mpi.h>
+
+#include <stdio.h>
 #include <stdlib.h>
-#include <stddef.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-MPI_Datatype halo_cell_type(void)
+static const int opposite[8] = {
+    DIR_S, DIR_N, DIR_W, DIR_E, DIR_SW, DIR_SE, DIR_NW, DIR_NE
+};
+
+int halo_opposite(int dir)
 {
-    const int nfields = 4;
-    int          block_lengths[4] = {1, 1, 1, 1};
-    MPI_Datatype field_types[4]   = {MPI_INT, MPI_DOUBLE, MPI_DOUBLE, MPI_INT};
-    MPI_Aint     offsets[4];
+    return opposite[dir];
+}
 
-    offsets[0] = offsetof(Cell, type);
-    offsets[1] = offsetof(Cell, resource);
-    offsets[2] = offsetof(Cell, max_resource);
-    offsets[3] = offsetof(Cell, accessible);
+static const char *mode_names[] = {
+    "isend", "shm", "persistent", "rma", "partitioned"
+};
+
+int halo_parse_mode(const char *name)
+{
+    for (int m = 0; m < (int)(sizeof(mode_names) / sizeof(mode_names[0])); m++)
+        if (strcmp(name, mode_names[m]) == 0) return m;
+    return -1;
+}
 
-    MPI_Datatype dt;
-    MPI_Type_create_struct(nfields, block_lengths, offsets, field_types, &dt);
-    MPI_Type_commit(&dt);
-    return dt;
+const char *halo_mode_name(HaloMode mode)
+{
+    return mode_names[mode];
 }
 
-static void pack_column(const SubGrid *sg, int col, Cell *buf)
+/*
+ * Interior: linhas [H..H+local_h), colunas [H..H+local_w), H = sg->halo.
+ * Halo norte = linhas [0..H),  halo sul = linhas [H+local_h..).
+ * Halo oeste = colunas [0..H), halo leste = colunas [H+local_w..).
+ */
+
+HaloRect halo_send_rect(const SubGrid *sg, int dir)
 {
-    for (int r = 1; r <= sg->local_h; r++)
-        buf[r - 1] = sg->cells[CELL_AT(sg, r, col)];
+    const int lw = sg->local_w;
+    const int lh = sg->local_h;
+    const int H  = sg->halo;
+    switch (dir) {
+        case DIR_N:  return (HaloRect){ H,  H,  H,  lw };
+        case DIR_S:  return (HaloRect){ lh, H,  H,  lw };
+        case DIR_E:  return (HaloRect){ H,  lw, lh, H  };
+        case DIR_W:  return (HaloRect){ H,  H,  lh, H  };
+        case DIR_NE: return (HaloRect){ H,  lw, H,  H  };
+        case DIR_NW: return (HaloRect){ H,  H,  H,  H  };
+        case DIR_SE: return (HaloRect){ lh, lw, H,  H  };
+        default:     return (HaloRect){ lh, H,  H,  H  };   /* DIR_SW */
+    }
 }
 
-static void unpack_column(SubGrid *sg, int col, const Cell *buf)
+HaloRect halo_recv_rect(const SubGrid *sg, int dir)
 {
-    for (int r = 1; r <= sg->local_h; r++)
-        sg->cells[CELL_AT(sg, r, col)] = buf[r - 1];
+    const int lw = sg->local_w;
+    const int lh = sg->local_h;
+    const int H  = sg->halo;
+    switch (dir) {
+        case DIR_N:  return (HaloRect){ 0,      H,      H,  lw };
+        case DIR_S:  return (HaloRect){ H + lh, H,      H,  lw };
+        case DIR_E:  return (HaloRect){ H,      H + lw, lh, H  };
+        case DIR_W:  return (HaloRect){ H,      0,      lh, H  };
+        case DIR_NE: return (HaloRect){ 0,      H + lw, H,  H  };
+        case DIR_NW: return (HaloRect){ 0,      0,      H,  H  };
+        case DIR_SE: return (HaloRect){ H + lh, H + lw, H,  H  };
+        default:     return (HaloRect){ H + lh, 0,      H,  H  };   /* DIR_SW */
+    }
 }
 
+#ifdef USE_MPI
+
+#include <mpi.h>
+#include <sched.h>
+
 /*
- * Troca de halos não-bloqueante: posta pares Isend/Irecv para as
- * 4 direções cardinais + 4 diagonais, e espera com MPI_Waitall.
- *
- * Interior: linhas [1..local_h], colunas [1..local_w].
- * Halo norte = linha 0,  halo sul = linha local_h+1.
- * Halo oeste = coluna 0, halo leste = coluna local_w+1.
+ * Cabeçalho de cada segmento da janela compartilhada. Os flags ficam
+ * em linhas de cache separadas para que o spin de um vizinho não
+ * invalide a linha que o dono está escrevendo.
  */
+typedef struct {
+    uint64_t ready;      /* época cujas bordas já estão prontas para leitura */
+    char     pad0[56];
+    uint64_t done;       /* época cujos halos dos vizinhos já foram copiados */
+    char     pad1[56];
+    int32_t  local_w, local_h;
+    char     pad2[56];
+} ShmHeader;
+
+_Static_assert(sizeof(ShmHeader) % 64 == 0,
+               "ShmHeader deve ocupar linhas de cache inteiras");
+
+static Cell *shm_cells(void *hdr)
+{
+    return (Cell *)((char *)hdr + sizeof(ShmHeader));
+}
+
+static void shm_publish(MPI_Win win, uint64_t *flag, uint64_t epoch)
+{
+    MPI_Win_sync(win);
+    __atomic_store_n(flag, epoch, __ATOMIC_RELEASE);
+}
 
-void halo_exchange(SubGrid *sg, Partition *p)
+static void shm_wait(MPI_Win win, uint64_t *flag, uint64_t epoch)
 {
-    MPI_Datatype cell_t = halo_cell_type();
+    while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) < epoch) {
+        MPI_Win_sync(win);
+        sched_yield();   /* ranks podem dividir núcleos (--oversubscribe) */
+    }
+    MPI_Win_sync(win);
+}
+
+static void shm_init(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    MPI_Comm_split_type(p->cart_comm, MPI_COMM_TYPE_SHARED, p->rank,
+                        MPI_INFO_NULL, &ctx->node_comm);
+
+    /* Segmentos não contíguos: cada um fica na memória local do dono. */
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+
+    size_t cells_bytes = sizeof(Cell) * (size_t)sg->halo_w * sg->halo_h;
+    void *base = NULL;
+    MPI_Win_allocate_shared((MPI_Aint)(sizeof(ShmHeader) + cells_bytes), 1,
+                            info, ctx->node_comm, &base, &ctx->win);
+    MPI_Info_free(&info);
+
+    ShmHeader *hdr = base;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->local_w = sg->local_w;
+    hdr->local_h = sg->local_h;
+    memcpy(shm_cells(hdr), sg->cells, cells_bytes);
+    ctx->heap_cells = sg->cells;
+    sg->cells = shm_cells(hdr);
+    ctx->hdr  = hdr;
+
+    /* Epoch passivo para toda a execução; MPI_Win_sync ordena a memória. */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, ctx->win);
 
-    const int local_w = sg->local_w;
-    const int local_h = sg->local_h;
-    const int halo_w  = sg->halo_w;
+    /* Vizinho cartesiano -> rank no nó (MPI_UNDEFINED se está em outro nó). */
+    MPI_Group cart_group, node_group;
+    MPI_Comm_group(p->cart_comm, &cart_group);
+    MPI_Comm_group(ctx->node_comm, &node_group);
+    int node_rank[8];
+    MPI_Group_translate_ranks(cart_group, 8, p->neighbors,
+                              node_group, node_rank);
+    MPI_Group_free(&cart_group);
+    MPI_Group_free(&node_group);
 
-    Cell *send_west = malloc(sizeof(Cell) * local_h);
-    Cell *send_east = malloc(sizeof(Cell) * local_h);
-    Cell *recv_west = malloc(sizeof(Cell) * local_h);
-    Cell *recv_east = malloc(sizeof(Cell) * local_h);
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL || node_rank[d] == MPI_UNDEFINED)
+            continue;
+        MPI_Aint size;
+        int disp_unit;
+        void *peer;
+        MPI_Win_shared_query(ctx->win, node_rank[d], &size, &disp_unit, &peer);
+        ctx->peer_hdr[d] = peer;
+    }
 
+    /* Cabeçalhos e células iniciais visíveis antes da primeira troca. */
+    MPI_Win_sync(ctx->win);
+    MPI_Barrier(ctx->node_comm);
+    MPI_Win_sync(ctx->win);
+}
+
+static void persistent_init(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    MPI_Datatype cell_t = pack_cell_type();
+    const size_t cell_bytes = pack_cell_bytes();
+
+    /* Recvs primeiro: MPI_Startall os inicia antes dos sends. */
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+        HaloRect rr = halo_recv_rect(sg, d);
+        int n = rr.h * rr.w;
+        ctx->precv[d] = sim_malloc(cell_bytes * (size_t)n);
+        MPI_Recv_init(ctx->precv[d], n, cell_t, p->neighbors[d], d,
+                      p->cart_comm, &ctx->preq[ctx->npreq++]);
+    }
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+        HaloRect sr = halo_send_rect(sg, d);
+        int n = sr.h * sr.w;
+        ctx->psend[d] = sim_malloc(cell_bytes * (size_t)n);
+        MPI_Send_init(ctx->psend[d], n, cell_t, p->neighbors[d], opposite[d],
+                      p->cart_comm, &ctx->preq[ctx->npreq++]);
+    }
+}
+
+/* Dimensões locais (local_w, local_h) de cada vizinho, trocadas uma vez. */
+static void neighbor_dims(const SubGrid *sg, Partition *p, int dims[8][2])
+{
     MPI_Request reqs[16];
     int nreq = 0;
+    int mine[2] = { sg->local_w, sg->local_h };
+
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+        MPI_Irecv(dims[d], 2, MPI_INT, p->neighbors[d], d,
+                  p->cart_comm, &reqs[nreq++]);
+        MPI_Isend(mine, 2, MPI_INT, p->neighbors[d], opposite[d],
+                  p->cart_comm, &reqs[nreq++]);
+    }
+    MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
+}
+
+static void rma_init(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    MPI_Datatype raw_cell;
+    MPI_Type_contiguous((int)sizeof(Cell), MPI_BYTE, &raw_cell);
+
+    int dims[8][2];
+    neighbor_dims(sg, p, dims);
+
+    int members[8], nmembers = 0;
+    for (int d = 0; d < 8; d++) {
+        ctx->put_origin[d] = MPI_DATATYPE_NULL;
+        ctx->put_target[d] = MPI_DATATYPE_NULL;
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+
+        /* Nossa borda d vai para o halo oposto do vizinho, no layout dele. */
+        SubGrid peer = {
+            .local_w = dims[d][0], .local_h = dims[d][1], .halo = sg->halo,
+            .halo_w  = dims[d][0] + 2 * sg->halo,
+            .halo_h  = dims[d][1] + 2 * sg->halo
+        };
+        HaloRect sr = halo_send_rect(sg, d);
+        HaloRect tr = halo_recv_rect(&peer, opposite[d]);
+
+        MPI_Type_vector(sr.h, sr.w, sg->halo_w, raw_cell, &ctx->put_origin[d]);
+        MPI_Type_vector(tr.h, tr.w, peer.halo_w, raw_cell, &ctx->put_target[d]);
+        MPI_Type_commit(&ctx->put_origin[d]);
+        MPI_Type_commit(&ctx->put_target[d]);
+        ctx->put_disp[d] = (MPI_Aint)CELL_AT(&peer, tr.r0, tr.c0);
+
+        int dup = 0;
+        for (int k = 0; k < nmembers; k++)
+            if (members[k] == p->neighbors[d]) dup = 1;
+        if (!dup) members[nmembers++] = p->neighbors[d];
+    }
+    MPI_Type_free(&raw_cell);
+
+    MPI_Group cart_group;
+    MPI_Comm_group(p->cart_comm, &cart_group);
+    MPI_Group_incl(cart_group, nmembers, members, &ctx->nbr_group);
+    MPI_Group_free(&cart_group);
+
+    /*
+     * A janela aloca a própria memória (registrada para RMA) e as
+     * células passam a morar nela, como no modo shm.
+     */
+    size_t cells_bytes = sizeof(Cell) * (size_t)sg->halo_w * sg->halo_h;
+    Cell *base = NULL;
+    MPI_Win_allocate((MPI_Aint)cells_bytes, (int)sizeof(Cell), MPI_INFO_NULL,
+                     p->cart_comm, &base, &ctx->win);
+    memcpy(base, sg->cells, cells_bytes);
+    ctx->heap_cells = sg->cells;
+    sg->cells = base;
+}
+
+#if MPI_VERSION >= 4
+/*
+ * Partitioned (MPI-4): cada linha de uma região de borda é uma partição
+ * do envio, liberada com MPI_Pready pela thread que a regenerou. O
+ * receptor usa uma única partição (o padrão permite particionamentos
+ * diferentes nos dois lados, desde que o total coincida).
+ */
+static void partitioned_init(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    MPI_Datatype cell_t = pack_cell_type();
+    const size_t cell_bytes = pack_cell_bytes();
+
+    /* Recvs primeiro: MPI_Startall os inicia antes dos sends. */
+    for (int d = 0; d < 8; d++) {
+        ctx->part_send[d] = -1;
+        ctx->part_peer[d] = p->neighbors[d];
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+
+        HaloRect rr = halo_recv_rect(sg, d);
+        ctx->precv[d] = sim_malloc(cell_bytes * (size_t)(rr.h * rr.w));
+        MPI_Precv_init(ctx->precv[d], 1, (MPI_Count)(rr.h * rr.w), cell_t,
+                       p->neighbors[d], d, p->cart_comm, MPI_INFO_NULL,
+                       &ctx->part_req[ctx->npart++]);
+    }
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+
+        HaloRect sr = halo_send_rect(sg, d);
+        ctx->psend[d] = sim_malloc(cell_bytes * (size_t)(sr.h * sr.w));
+        ctx->part_send[d] = ctx->npart;
+        MPI_Psend_init(ctx->psend[d], sr.h, (MPI_Count)sr.w, cell_t,
+                       p->neighbors[d], opposite[d], p->cart_comm,
+                       MPI_INFO_NULL, &ctx->part_req[ctx->npart++]);
+    }
+}
+#endif
+
+HaloMode halo_effective_mode(HaloMode mode)
+{
+    if (mode != HALO_PARTITIONED)
+        return mode;
+    /* Pready vem de várias threads: exige MPI-4 e THREAD_MULTIPLE. */
+    int level = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&level);
+    return (MPI_VERSION < 4 || level < MPI_THREAD_MULTIPLE)
+           ? HALO_PERSISTENT : HALO_PARTITIONED;
+}
+
+void halo_init(HaloCtx *ctx, HaloMode mode, SubGrid *sg, Partition *p)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    mode = ctx->mode = halo_effective_mode(mode);
+    ctx->node_comm = MPI_COMM_NULL;
+    ctx->win       = MPI_WIN_NULL;
+    ctx->nbr_group = MPI_GROUP_NULL;
+
+    switch (mode) {
+        case HALO_SHM:        shm_init(ctx, sg, p);        break;
+        case HALO_PERSISTENT: persistent_init(ctx, sg, p); break;
+        case HALO_RMA:        rma_init(ctx, sg, p);        break;
+#if MPI_VERSION >= 4
+        case HALO_PARTITIONED: partitioned_init(ctx, sg, p); break;
+#endif
+        default:              break;
+    }
+}
+
+void halo_destroy(HaloCtx *ctx, SubGrid *sg)
+{
+    if (ctx->heap_cells) {
+        memcpy(ctx->heap_cells, sg->cells,
+               sizeof(Cell) * (size_t)sg->halo_w * sg->halo_h);
+        sg->cells = ctx->heap_cells;
+    }
+    if (ctx->mode == HALO_SHM) {
+        MPI_Win_unlock_all(ctx->win);
+        MPI_Win_free(&ctx->win);
+        MPI_Comm_free(&ctx->node_comm);
+    }
+    if (ctx->mode == HALO_PERSISTENT) {
+        for (int i = 0; i < ctx->npreq; i++)
+            MPI_Request_free(&ctx->preq[i]);
+        for (int d = 0; d < 8; d++) {
+            free(ctx->psend[d]);
+            free(ctx->precv[d]);
+        }
+    }
+#if MPI_VERSION >= 4
+    if (ctx->mode == HALO_PARTITIONED) {
+        /* Envios do último ciclo ainda em voo casam com os recvs. */
+        if (ctx->inflight)
+            MPI_Waitall(ctx->npart, ctx->part_req, MPI_STATUSES_IGNORE);
+        for (int i = 0; i < ctx->npart; i++)
+            MPI_Request_free(&ctx->part_req[i]);
+        for (int d = 0; d < 8; d++) {
+            free(ctx->psend[d]);
+            free(ctx->precv[d]);
+        }
+    }
+#endif
+    if (ctx->mode == HALO_RMA) {
+        MPI_Win_free(&ctx->win);
+        MPI_Group_free(&ctx->nbr_group);
+        for (int d = 0; d < 8; d++) {
+            if (ctx->put_origin[d] != MPI_DATATYPE_NULL)
+                MPI_Type_free(&ctx->put_origin[d]);
+            if (ctx->put_target[d] != MPI_DATATYPE_NULL)
+                MPI_Type_free(&ctx->put_target[d]);
+        }
+    }
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+/*
+ * Caminho de mensagens: posta os Irecv das direções remotas, empacota
+ * e envia as regiões de borda. Retorna o número de requisições em reqs.
+ */
+static int post_messages(const HaloCtx *ctx, SubGrid *sg, Partition *p,
+                         Arena *arena, MPI_Request reqs[16], void *recv_buf[8])
+{
+    MPI_Datatype cell_t = pack_cell_type();
+    const size_t cell_bytes = pack_cell_bytes();
+    int nreq = 0;
+
+    for (int d = 0; d < 8; d++) {
+        recv_buf[d] = NULL;
+        if (p->neighbors[d] == MPI_PROC_NULL || ctx->peer_hdr[d]) continue;
+
+        HaloRect rr = halo_recv_rect(sg, d);
+        int n = rr.h * rr.w;
+        recv_buf[d] = arena_alloc(arena, cell_bytes * (size_t)n);
+        MPI_Irecv(recv_buf[d], n, cell_t, p->neighbors[d], d,
+                  p->cart_comm, &reqs[nreq++]);
+    }
+
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL || ctx->peer_hdr[d]) continue;
+
+        HaloRect sr = halo_send_rect(sg, d);
+        int n = sr.h * sr.w;
+        void *buf = arena_alloc(arena, cell_bytes * (size_t)n);
+        size_t bytes = pack_cells(&sg->cells[CELL_AT(sg, sr.r0, sr.c0)],
+                                  sg->halo_w, sr.h, sr.w, buf);
+        MPI_Isend(buf, n, cell_t, p->neighbors[d], opposite[d],
+                  p->cart_comm, &reqs[nreq++]);
+        pack_bytes_add(WIRE_PHASE_HALO, bytes);
+        commmat_send(WIRE_PHASE_HALO, p->neighbors[d], bytes);
+    }
+    return nreq;
+}
+
+/*
+ * Caminho de memória compartilhada: publica "bordas prontas", copia a
+ * borda oposta de cada vizinho do nó direto para os nossos halos e
+ * publica "halos lidos". O vizinho só volta a escrever no interior
+ * depois de ver nosso "lido" (shm_wait no final de halo_exchange).
+ */
+static void copy_from_peers(HaloCtx *ctx, SubGrid *sg)
+{
+    ShmHeader *me = ctx->hdr;
+    shm_publish(ctx->win, &me->ready, ctx->epoch);
+
+    for (int d = 0; d < 8; d++) {
+        ShmHeader *peer = ctx->peer_hdr[d];
+        if (!peer) continue;
+        shm_wait(ctx->win, &peer->ready, ctx->epoch);
+
+        SubGrid psg = {
+            .local_w = peer->local_w, .local_h = peer->local_h,
+            .halo    = sg->halo,
+            .halo_w  = peer->local_w + 2 * sg->halo,
+            .halo_h  = peer->local_h + 2 * sg->halo,
+            .cells   = shm_cells(peer)
+        };
+        HaloRect sr = halo_send_rect(&psg, opposite[d]);
+        HaloRect rr = halo_recv_rect(sg, d);
+        /* Mesma quantização de --wire que as mensagens entre nós. */
+        pack_copy_cells(&sg->cells[CELL_AT(sg, rr.r0, rr.c0)], sg->halo_w,
+                        &psg.cells[CELL_AT(&psg, sr.r0, sr.c0)], psg.halo_w,
+                        rr.h, rr.w);
+    }
+
+    shm_publish(ctx->win, &me->done, ctx->epoch);
+}
+
+/* Requisições persistentes: empacota nos buffers fixos e MPI_Startall. */
+static void exchange_persistent(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    for (int d = 0; d < 8; d++) {
+        if (!ctx->psend[d]) continue;
+        HaloRect sr = halo_send_rect(sg, d);
+        size_t bytes = pack_cells(&sg->cells[CELL_AT(sg, sr.r0, sr.c0)],
+                                  sg->halo_w, sr.h, sr.w, ctx->psend[d]);
+        pack_bytes_add(WIRE_PHASE_HALO, bytes);
+        commmat_send(WIRE_PHASE_HALO, p->neighbors[d], bytes);
+    }
+
+    MPI_Startall(ctx->npreq, ctx->preq);
+    MPI_Waitall(ctx->npreq, ctx->preq, MPI_STATUSES_IGNORE);
+
+    for (int d = 0; d < 8; d++) {
+        if (!ctx->precv[d]) continue;
+        HaloRect rr = halo_recv_rect(sg, d);
+        unpack_cells(&sg->cells[CELL_AT(sg, rr.r0, rr.c0)],
+                     sg->halo_w, rr.h, rr.w, ctx->precv[d]);
+    }
+}
+
+/*
+ * PSCW: expõe nossos halos aos vizinhos (post), abre o acesso aos
+ * deles (start), coloca as 8 bordas com MPI_Put e fecha as duas
+ * épocas. Células viajam na representação nativa da struct Cell.
+ */
+static void exchange_rma(HaloCtx *ctx, SubGrid *sg, Partition *p)
+{
+    MPI_Win_post(ctx->nbr_group, 0, ctx->win);
+    MPI_Win_start(ctx->nbr_group, 0, ctx->win);
+
+    for (int d = 0; d < 8; d++) {
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+        HaloRect sr = halo_send_rect(sg, d);
+        MPI_Put(&sg->cells[CELL_AT(sg, sr.r0, sr.c0)], 1, ctx->put_origin[d],
+                p->neighbors[d], ctx->put_disp[d], 1, ctx->put_target[d],
+                ctx->win);
+        pack_bytes_add(WIRE_PHASE_HALO, sizeof(Cell) * (uint64_t)(sr.h * sr.w));
+        commmat_send(WIRE_PHASE_HALO, p->neighbors[d],
+                     sizeof(Cell) * (uint64_t)(sr.h * sr.w));
+    }
+
+    MPI_Win_complete(ctx->win);
+    MPI_Win_wait(ctx->win);
+}
+
+#if MPI_VERSION >= 4
+/*
+ * Conclui os envios particionados iniciados no fim do ciclo anterior
+ * (halo_update_and_send).
+ */
+static void finish_partitioned(HaloCtx *ctx, SubGrid *sg)
+{
+    MPI_Waitall(ctx->npart, ctx->part_req, MPI_STATUSES_IGNORE);
+    ctx->inflight = 0;
+
+    for (int d = 0; d < 8; d++) {
+        if (!ctx->precv[d]) continue;
+        HaloRect rr = halo_recv_rect(sg, d);
+        unpack_cells(&sg->cells[CELL_AT(sg, rr.r0, rr.c0)],
+                     sg->halo_w, rr.h, rr.w, ctx->precv[d]);
+    }
+}
+
+/* Empacota a linha r em cada região de borda que a contém e a libera. */
+static void ready_row(HaloCtx *ctx, SubGrid *sg, int r)
+{
+    const size_t cell_bytes = pack_cell_bytes();
+    for (int d = 0; d < 8; d++) {
+        if (!ctx->psend[d]) continue;
+        HaloRect sr = halo_send_rect(sg, d);
+        if (r < sr.r0 || r >= sr.r0 + sr.h) continue;
+        int part = r - sr.r0;
+        pack_cells(&sg->cells[CELL_AT(sg, r, sr.c0)], sg->halo_w, 1, sr.w,
+                   (char *)ctx->psend[d] + cell_bytes * (size_t)(part * sr.w));
+        MPI_Pready(part, ctx->part_req[ctx->part_send[d]]);
+    }
+}
+#endif
+
+void halo_update_and_send(HaloCtx *ctx, SubGrid *sg, Season season,
+                          int send, GridSweep *gs)
+{
+    if (ctx->mode == HALO_PARTITIONED && send) {
+        #pragma omp parallel
+        halo_update_and_send_team(ctx, sg, season, send, gs);
+        return;
+    }
+    subgrid_update(sg, season, gs);
+}
+
+void halo_update_and_send_team(HaloCtx *ctx, SubGrid *sg, Season season,
+                               int send, GridSweep *gs)
+{
+#if MPI_VERSION >= 4
+    if (ctx->mode == HALO_PARTITIONED && send) {
+        /* MPI_Pready exige o envio iniciado: só o Startall fica antes
+         * da barreira (o nível MULTIPLE cobre os MPI_Pready). */
+        #pragma omp master
+        {
+            MPI_Startall(ctx->npart, ctx->part_req);
+            ctx->inflight = 1;
+        }
+        #pragma omp barrier
+
+        /* Blocos contíguos de linhas por thread: as linhas de borda de
+         * cada região saem assim que a thread dona termina cada uma. */
+        int nt = 1, t = 0;
+#ifdef _OPENMP
+        nt = omp_get_num_threads();
+        t  = omp_get_thread_num();
+#endif
+        int nrows = sg->box_r1 - sg->box_r0 + 1;
+        int lo = sg->box_r0 + (int)((long)nrows * t / nt);
+        int hi = sg->box_r0 + (int)((long)nrows * (t + 1) / nt);
+        TRACE_SCOPE(TR_GRID) {
+            for (int r = lo; r < hi; r++) {
+                subgrid_update_row(sg, season, r, gs);
+                ready_row(ctx, sg, r);
+            }
+        }
+
+        /* Contabilidade de bytes depois das próprias linhas: nenhuma
+         * thread espera por ela. */
+        #pragma omp master
+        for (int d = 0; d < 8; d++) {
+            if (!ctx->psend[d]) continue;
+            HaloRect sr = halo_send_rect(sg, d);
+            pack_bytes_add(WIRE_PHASE_HALO,
+                           pack_cell_bytes() * (uint64_t)(sr.h * sr.w));
+            commmat_send(WIRE_PHASE_HALO, ctx->part_peer[d],
+                         pack_cell_bytes() * (uint64_t)(sr.h * sr.w));
+        }
+        return;
+    }
+#else
+    (void)ctx;
+    (void)send;
+#endif
+    subgrid_update_team(sg, season, gs);
+}
+
+/*
+ * Troca de halos: mensagens para vizinhos remotos são postadas
+ * primeiro, a cópia no nó acontece enquanto elas trafegam, e só então
+ * MPI_Waitall + desempacotamento.
+ */
+void halo_exchange(HaloCtx *ctx, SubGrid *sg, Partition *p, Arena *arena)
+{
+#if MPI_VERSION >= 4
+    if (ctx->mode == HALO_PARTITIONED && ctx->inflight) {
+        finish_partitioned(ctx, sg);
+        return;
+    }
+#endif
+    if (ctx->mode == HALO_PERSISTENT) {
+        exchange_persistent(ctx, sg, p);
+        return;
+    }
+    if (ctx->mode == HALO_RMA) {
+        exchange_rma(ctx, sg, p);
+        return;
+    }
+
+    MPI_Request reqs[16];
+    void *recv_buf[8];
+    ctx->epoch++;
+
+    int nreq = post_messages(ctx, sg, p, arena, reqs, recv_buf);
 
-    MPI_Isend(&sg->cells[CELL_AT(sg, 1, 1)],       local_w, cell_t,
-              p->neighbors[DIR_N], TAG_SOUTH, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, 0, 1)],       local_w, cell_t,
-              p->neighbors[DIR_N], TAG_NORTH, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(&sg->cells[CELL_AT(sg, local_h, 1)],     local_w, cell_t,
-              p->neighbors[DIR_S], TAG_NORTH, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, local_h + 1, 1)], local_w, cell_t,
-              p->neighbors[DIR_S], TAG_SOUTH, p->cart_comm, &reqs[nreq++]);
-
-    pack_column(sg, 1, send_west);
-    pack_column(sg, local_w, send_east);
-
-    MPI_Isend(send_west, local_h, cell_t,
-              p->neighbors[DIR_W], TAG_EAST, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(recv_west, local_h, cell_t,
-              p->neighbors[DIR_W], TAG_WEST, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(send_east, local_h, cell_t,
-              p->neighbors[DIR_E], TAG_WEST, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(recv_east, local_h, cell_t,
-              p->neighbors[DIR_E], TAG_EAST, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(&sg->cells[CELL_AT(sg, 1, 1)],                  1, cell_t,
-              p->neighbors[DIR_NW], TAG_SE, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, 0, 0)],                  1, cell_t,
-              p->neighbors[DIR_NW], TAG_NW, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(&sg->cells[CELL_AT(sg, 1, local_w)],            1, cell_t,
-              p->neighbors[DIR_NE], TAG_SW, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, 0, halo_w - 1)],        1, cell_t,
-              p->neighbors[DIR_NE], TAG_NE, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(&sg->cells[CELL_AT(sg, local_h, 1)],            1, cell_t,
-              p->neighbors[DIR_SW], TAG_NE, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, sg->halo_h - 1, 0)],    1, cell_t,
-              p->neighbors[DIR_SW], TAG_SW, p->cart_comm, &reqs[nreq++]);
-
-    MPI_Isend(&sg->cells[CELL_AT(sg, local_h, local_w)],      1, cell_t,
-              p->neighbors[DIR_SE], TAG_NW, p->cart_comm, &reqs[nreq++]);
-    MPI_Irecv(&sg->cells[CELL_AT(sg, sg->halo_h - 1, halo_w - 1)], 1, cell_t,
-              p->neighbors[DIR_SE], TAG_SE, p->cart_comm, &reqs[nreq++]);
+    if (ctx->mode == HALO_SHM)
+        copy_from_peers(ctx, sg);
 
     MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
 
-    unpack_column(sg, 0,           recv_west);
-    unpack_column(sg, local_w + 1, recv_east);
+    for (int d = 0; d < 8; d++) {
+        if (!recv_buf[d]) continue;
+        HaloRect rr = halo_recv_rect(sg, d);
+        unpack_cells(&sg->cells[CELL_AT(sg, rr.r0, rr.c0)],
+                     sg->halo_w, rr.h, rr.w, recv_buf[d]);
+    }
 
-    free(send_west);
-    free(send_east);
-    free(recv_west);
-    free(recv_east);
-    MPI_Type_free(&cell_t);
+    if (ctx->mode == HALO_SHM) {
+        for (int d = 0; d < 8; d++)
+            if (ctx->peer_hdr[d])
+                shm_wait(ctx->win, &((ShmHeader *)ctx->peer_hdr[d])->done,
+                         ctx->epoch);
+    }
 }
 
 #endif /* USE_MPI */
@@ -0,0 +1,80 @@
+#include "lpt.h"
+
+#include <string.h>
+
+#define LPT_PACK(h, t) (((uint64_t)(uint32_t)(h) << 32) | (uint32_t)(t))
+
+/* Fila da k-ésima tarefa em ordem LPT: zigue-zague 0..n-1, n-1..0, ... */
+static int deal_queue(int k, int nq) {
+    int round = k / nq, pos = k % nq;
+    return (round & 1) ? nq - 1 - pos : pos;
+}
+
+/* Faixa do custo c: custos acima de max_cost caem na mais cara. */
+static int bucket_of(int c, long long span) {
+    long long b = (long long)c * LPT_BUCKETS / span;
+    return b < LPT_BUCKETS ? (int)b : LPT_BUCKETS - 1;
+}
+
+void lpt_build(LptPlan *plan, const int *cost, int n, int max_cost,
+               int nqueues, Arena *arena) {
+    int count[LPT_BUCKETS];
+    memset(count, 0, sizeof(count));
+
+    const long long span = (long long)max_cost + 1;
+    for (int i = 0; i < n; i++)
+        if (cost[i] > 0)
+            count[bucket_of(cost[i], span)]++;
+
+    /* Faixas em ordem decrescente de custo: a mais cara começa em 0. */
+    int m = 0;
+    int start[LPT_BUCKETS];
+    for (int b = LPT_BUCKETS - 1; b >= 0; b--) {
+        start[b] = m;
+        m += count[b];
+    }
+
+    int *sorted = arena_alloc(arena, sizeof(int) * (size_t)(m > 0 ? m : 1));
+    for (int i = 0; i < n; i++)
+        if (cost[i] > 0)
+            sorted[start[bucket_of(cost[i], span)]++] = i;
+
+    int *fill = arena_calloc(arena, (size_t)nqueues, sizeof(int));
+    for (int k = 0; k < m; k++)
+        fill[deal_queue(k, nqueues)]++;
+
+    plan->items   = arena_alloc(arena, sizeof(int) * (size_t)(m > 0 ? m : 1));
+    plan->queues  = arena_alloc(arena, sizeof(LptQueue) * (size_t)nqueues);
+    plan->nqueues = nqueues;
+    plan->ntasks  = m;
+
+    int off = 0;
+    for (int q = 0; q < nqueues; q++) {
+        plan->queues[q].ht = LPT_PACK(off, off + fill[q]);
+        int len = fill[q];
+        fill[q] = off;
+        off += len;
+    }
+    for (int k = 0; k < m; k++)
+        plan->items[fill[deal_queue(k, nqueues)]++] = sorted[k];
+}
+
+/* Retira da frente (dono) ou do fundo (ladrão); -1 se a fila está vazia. */
+static int queue_take(LptQueue *q, int front) {
+    uint64_t ht = __atomic_load_n(&q->ht, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t h = (uint32_t)(ht >> 32), t = (uint32_t)ht;
+        if (h >= t) return -1;
+        uint64_t next = front ? LPT_PACK(h + 1, t) : LPT_PACK(h, t - 1);
+        if (__atomic_compare_exchange_n(&q->ht, &ht, next, 1,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return (int)(front ? h : t - 1);
+    }
+}
+
+int lpt_next(LptPlan *plan, int self) {
+    int pos = queue_take(&plan->queues[self], 1);
+    for (int v = 1; pos < 0 && v < plan->nqueues; v++)
+        pos = queue_take(&plan->queues[(self + v) % plan->nqueues], 0);
+    return pos < 0 ? -1 : plan->items[pos];
+}
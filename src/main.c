@@ -1,22 +1,298 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <unistd.h>
 #include <mpi.h>
 #include <omp.h>
 
 #include "types.h"
+#include "arena.h"
+#include "autotune.h"
+#include "benchrun.h"
+#include "commmat.h"
 #include "config.h"
+#include "digest.h"
 #include "rng.h"
 #include "season.h"
 #include "workload.h"
 #include "grid.h"
+#include "hwcount.h"
 #include "partition.h"
 #include "agent.h"
+#include "pool.h"
 #include "halo.h"
 #include "migrate.h"
+#include "pack.h"
 #include "metrics.h"
+#include "mpiprof.h"
+#include "commthread.h"
+#include "taskgraph.h"
+#include "trace.h"
 #include "tui.h"
+#include "vtime.h"
+
+/* Fases do ciclo, para o relatório de alocações (--alloc-stats) e o de
+ * espera (--wait-report). Mesma ordem dos campos de CyclePerf a partir
+ * de season_time. */
+enum {
+    PH_SEASON, PH_HALO, PH_WORKLOAD, PH_AGENT, PH_REPRODUCE,
+    PH_GRID, PH_MIGRATE, PH_METRICS, PH_RENDER, PH_COUNT
+};
+
+/* Próximo passo do laço de ciclos: decidido pela master, lido pela equipe. */
+enum { CYCLE_RUN, CYCLE_PAUSED, CYCLE_QUIT };
+
+static const char *phase_names[PH_COUNT] = {
+    "season", "halo", "workload", "agent", "reproduce",
+    "grid", "migrate", "metrics", "render"
+};
+
+/* Acumula as alocações no heap feitas desde a última marca na fase `ph`. */
+#define PHASE_ALLOCS(ph) do {                                         \
+    uint64_t _now = sim_alloc_count();                                \
+    phase_allocs[ph] += _now - alloc_mark;                            \
+    cycle_allocs     += _now - alloc_mark;                            \
+    alloc_mark        = _now;                                         \
+} while (0)
+
+/*
+ * Fases do ciclo empacotadas como tarefas, para que pares independentes
+ * (halo × carga sintética, migração × regeneração) possam rodar ao mesmo
+ * tempo com --comm-thread.
+ */
+typedef struct {
+    HaloCtx   *halo;
+    SubGrid   *sg;
+    Partition *p;
+    Arena     *arena;
+    int        active;     /* 0 nos ciclos sem troca (--halo-depth) */
+} HaloJob;
+
+typedef struct {
+    AgentPool *pool;
+    SubGrid   *sg;
+    int        max_workload;
+    LptPlan   *plan;       /* --workload-sched lpt: montado antes */
+    double    *finish;     /* fim da carga por thread */
+} WorkloadJob;
+
+typedef struct {
+    AgentPool *pool;
+    Partition *p;
+    SubGrid   *sg;
+    int        global_w, global_h;
+    Arena     *arena;
+    int        depth, cycle;
+} MigrateJob;
+
+typedef struct {
+    HaloCtx *halo;
+    SubGrid *sg;
+    Season   season;
+    int      send;         /* próximo ciclo troca halos */
+    GridSweep *gs;         /* parciais da passada fundida */
+} GridJob;
+
+static void run_halo(void *arg) {
+    HaloJob *j = arg;
+    if (j->active)
+        TRACE_SCOPE(TR_HALO)
+            halo_exchange(j->halo, j->sg, j->p, j->arena);
+}
+
+static void run_workload(void *arg) {
+    WorkloadJob *j = arg;
+    if (j->plan)
+        agents_workload_lpt(j->plan, j->pool, j->sg, j->max_workload,
+                            j->finish);
+    else
+        agents_workload(j->pool, j->sg, j->max_workload, j->finish);
+}
+
+/* Dispersão entre o primeiro e o último fim de carga (finish[t] < 0:
+ * thread que não participou). */
+static double finish_spread(const double *finish, int n) {
+    double lo = 0.0, hi = 0.0;
+    int    seen = 0;
+    for (int t = 0; t < n; t++) {
+        if (finish[t] < 0.0) continue;
+        if (!seen || finish[t] < lo) lo = finish[t];
+        if (!seen || finish[t] > hi) hi = finish[t];
+        seen = 1;
+    }
+    return hi - lo;
+}
+
+static double hw_ratio(double num, double den) {
+    return den > 0.0 ? num / den : 0.0;
+}
+
+/*
+ * Relatório de --hwcounters: contagens somadas entre ranks e threads; o
+ * tempo de cada fase é o do rank mais lento. Falhas de LLC por agente nas
+ * fases de agentes e por célula nas demais; GB/s supõe uma linha de cache
+ * trazida da memória por falha. Coletiva em comm.
+ */
+static void hw_report(FILE *out, uint64_t total[PH_COUNT][HW_EVENTS],
+                      const double *time, double agent_cycles,
+                      double cell_cycles, double peak, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    uint64_t sum[PH_COUNT][HW_EVENTS];
+    double   tmax[PH_COUNT];
+    MPI_Reduce(total, sum, PH_COUNT * HW_EVENTS, MPI_UINT64_T, MPI_SUM, 0,
+               comm);
+    MPI_Reduce(time, tmax, PH_COUNT, MPI_DOUBLE, MPI_MAX, 0, comm);
+    if (rank != 0) return;
+
+    fprintf(out, "\n=== Hardware counters per phase (sum over ranks and threads) ===\n");
+    fprintf(out, "%-10s %10s %10s %5s %10s %10s %12s %8s %6s\n", "phase",
+            "cycles_M", "instr_M", "ipc", "llc_K", "branch_K",
+            "llc/unit", "GB/s", "%peak");
+    for (int ph = 0; ph < PH_RENDER; ph++) {
+        const uint64_t *c = sum[ph];
+        int    per_agent = ph == PH_WORKLOAD || ph == PH_AGENT ||
+                           ph == PH_REPRODUCE || ph == PH_MIGRATE;
+        double gbs = hw_ratio((double)c[HW_LLC_MISSES] * HW_LINE_BYTES,
+                              tmax[ph] * 1e9);
+        fprintf(out, "%-10s %10.1f %10.1f %5.2f %10.1f %10.1f %7.3f/%-4s "
+                "%8.2f %6.1f\n", phase_names[ph],
+                c[HW_CYCLES] / 1e6, c[HW_INSTRUCTIONS] / 1e6,
+                hw_ratio(c[HW_INSTRUCTIONS], c[HW_CYCLES]),
+                c[HW_LLC_MISSES] / 1e3, c[HW_BRANCH_MISSES] / 1e3,
+                hw_ratio(c[HW_LLC_MISSES],
+                         per_agent ? agent_cycles : cell_cycles),
+                per_agent ? "agt" : "cell",
+                gbs, hw_ratio(100.0 * gbs, peak));
+    }
+    fprintf(out, "Triad peak: %.1f GB/s | units are per agent-cycle or "
+            "cell-cycle\n", peak);
+    fprintf(out, "=================================================================\n");
+}
+
+/* Halo profundo: sincroniza o anel no último ciclo de cada janela. */
+static void run_migrate(void *arg) {
+    MigrateJob *j = arg;
+    TRACE_SCOPE(TR_MIGRATE) {
+        if (j->depth == 1)
+            migrate_agents(j->pool, j->p, j->sg,
+                           j->global_w, j->global_h, j->arena);
+        else if ((j->cycle + 1) % j->depth == 0)
+            migrate_sync_ring(j->pool, j->p, j->sg,
+                              j->global_w, j->global_h, j->arena);
+    }
+}
+
+static void run_grid(void *arg) {
+    GridJob *j = arg;
+    halo_update_and_send(j->halo, j->sg, j->season, j->send, j->gs);
+}
+
+/* Coleta grade e agentes no rank 0 para a TUI (full_grid é NULL nos
+ * demais ranks). Coletiva em p->cart_comm. */
+static void gather_frame(SubGrid *sg, const AgentPool *pool, Partition *p,
+                         const SimConfig *cfg, Cell *full_grid,
+                         Agent **agents, int *n_agents, Arena *arena) {
+    tui_gather_grid(sg, p, full_grid, cfg->global_w, cfg->global_h,
+                    p->cart_comm, arena);
+    tui_gather_agents(pool, sg, p, cfg->global_w, cfg->global_h, agents,
+                      n_agents, p->cart_comm, arena);
+}
+
+/*
+ * Tempos do ciclo reduzidos por máximo entre ranks (um único MPI_Reduce
+ * sobre os campos contíguos de CyclePerf) e balanço de carga pelos
+ * agentes vivos por rank. Coletiva; `global` só vale no rank 0.
+ */
+static void reduce_cycle_perf(const CyclePerf *local, int alive,
+                              CyclePerf *global, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    memset(global, 0, sizeof(*global));
+    MPI_Reduce(&local->cycle_time, &global->cycle_time, CYCLEPERF_NTIMES,
+               MPI_DOUBLE, MPI_MAX, 0, comm);
+
+    /* Mínimo e máximo numa só redução: max(-alive) = -min(alive). */
+    int lo_hi[2] = { -alive, alive }, ext[2];
+    MPI_Reduce(lo_hi, ext, 2, MPI_INT, MPI_MAX, 0, comm);
+
+    global->load_balance = (ext[1] > 0) ? (double)-ext[0] / ext[1] : 1.0;
+    double compute_sum = global->workload_time + global->agent_time
+                       + global->reproduce_time + global->grid_time;
+    double comm_sum = global->season_time + global->halo_time
+                    + global->migrate_time;
+    global->comm_compute = (compute_sum > 0.0) ? comm_sum / compute_sum : 0.0;
+    global->mpi_size     = size;
+    global->omp_threads  = omp_get_max_threads();
+}
+
+/* Linha do --csv para o ciclo (rank 0). Coletiva: reduz também os bytes
+ * do fio e, com --hwcounters, os contadores do ciclo. */
+static void csv_row(int cycle, Season season, const CyclePerf *perf,
+                    const SimMetrics *m, uint64_t hw_cycle[PH_COUNT][HW_EVENTS],
+                    const SimConfig *cfg, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    uint64_t local_bytes[WIRE_PHASE_COUNT], cycle_bytes[WIRE_PHASE_COUNT];
+    pack_bytes_get(local_bytes);
+    MPI_Reduce(local_bytes, cycle_bytes, WIRE_PHASE_COUNT, MPI_UINT64_T,
+               MPI_SUM, 0, comm);
+
+    uint64_t hw_sum[PH_COUNT][HW_EVENTS];
+    if (cfg->hwcounters)
+        MPI_Reduce(hw_cycle, hw_sum, PH_COUNT * HW_EVENTS,
+                   MPI_UINT64_T, MPI_SUM, 0, comm);
+
+    if (rank != 0) return;
+
+    double cycle_ms    = perf->cycle_time    * 1000.0;
+    double season_ms   = perf->season_time   * 1000.0;
+    double halo_ms     = perf->halo_time     * 1000.0;
+    double workload_ms = perf->workload_time * 1000.0;
+    double agent_ms    = perf->agent_time    * 1000.0;
+    double repro_ms    = perf->reproduce_time * 1000.0;
+    double grid_ms     = perf->grid_time     * 1000.0;
+    double migrate_ms  = perf->migrate_time  * 1000.0;
+    double metrics_ms  = perf->metrics_time  * 1000.0;
+    double workload_pct = (cycle_ms > 0.0)
+        ? workload_ms / cycle_ms * 100.0 : 0.0;
+    double comm_pct = (cycle_ms > 0.0)
+        ? (season_ms + halo_ms + migrate_ms) / cycle_ms * 100.0
+        : 0.0;
+    printf("%d,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,"
+           "%d,%.1f,%.3f,%.4f,%.2f,%.2f,%.3f,%llu,%llu,%.3f,%.3f",
+           cycle,
+           season_name(season),
+           season_ms, halo_ms, workload_ms, agent_ms,
+           grid_ms, migrate_ms, metrics_ms, cycle_ms,
+           m->alive_agents,
+           m->total_resource,
+           m->avg_energy,
+           perf->load_balance, workload_pct, comm_pct, repro_ms,
+           (unsigned long long)cycle_bytes[WIRE_PHASE_HALO],
+           (unsigned long long)cycle_bytes[WIRE_PHASE_MIGRATE],
+           perf->overlap_time * 1000.0,
+           perf->spread_time * 1000.0);
+    if (cfg->hwcounters) {
+        double cells = (double)cfg->global_w * cfg->global_h;
+        printf(",%.3f,%.3f,%.3f,%.3f,%.4f,%.2f",
+               hw_ratio(hw_sum[PH_WORKLOAD][HW_INSTRUCTIONS],
+                        hw_sum[PH_WORKLOAD][HW_CYCLES]),
+               hw_ratio(hw_sum[PH_AGENT][HW_INSTRUCTIONS],
+                        hw_sum[PH_AGENT][HW_CYCLES]),
+               hw_ratio(hw_sum[PH_GRID][HW_INSTRUCTIONS],
+                        hw_sum[PH_GRID][HW_CYCLES]),
+               hw_ratio(hw_sum[PH_AGENT][HW_LLC_MISSES],
+                        m->alive_agents),
+               hw_ratio(hw_sum[PH_GRID][HW_LLC_MISSES], cells),
+               hw_ratio(hw_sum[PH_GRID][HW_LLC_MISSES]
+                        * (double)HW_LINE_BYTES,
+                        perf->grid_time * 1e9));
+    }
+    printf("\n");
+}
 
 static void parse_args(int argc, char **argv, SimConfig *cfg) {
     for (int i = 1; i < argc; i++) {
@@ -46,6 +322,76 @@ static void parse_args(int argc, char **argv, SimConfig *cfg) {
             cfg->reproduce_threshold = atof(argv[++i]);
         else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
             cfg->reproduce_cost = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alloc-stats") == 0)
+            cfg->alloc_stats = 1;
+        else if (strcmp(argv[i], "--wire") == 0 && i + 1 < argc)
+            cfg->wire_quant = pack_parse_quant(argv[++i]);
+        else if (strcmp(argv[i], "--halo") == 0 && i + 1 < argc)
+            cfg->halo_mode = halo_parse_mode(argv[++i]);
+        else if (strcmp(argv[i], "--halo-depth") == 0 && i + 1 < argc)
+            cfg->halo_depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--comm-thread") == 0)
+            cfg->comm_thread = 1;
+        else if (strcmp(argv[i], "--tasks") == 0)
+            cfg->exec_tasks = 1;
+        else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc)
+            cfg->tile_size = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--autotune") == 0 && i + 1 < argc)
+            cfg->autotune = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tune-file") == 0 && i + 1 < argc)
+            strncpy(cfg->tune_file, argv[++i], sizeof(cfg->tune_file) - 1);
+        else if (strcmp(argv[i], "--seasons") == 0 && i + 1 < argc)
+            strncpy(cfg->seasons, argv[++i], sizeof(cfg->seasons) - 1);
+        else if (strcmp(argv[i], "--workload-sched") == 0 && i + 1 < argc) {
+            const char *m = argv[++i];
+            cfg->workload_lpt = strcmp(m, "lpt") == 0 ? 1
+                              : strcmp(m, "omp") == 0 ? 0 : -1;
+        }
+        else if (strcmp(argv[i], "--workload-profile") == 0 && i + 1 < argc)
+            cfg->workload_profile = workload_parse_profile(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            strncpy(cfg->trace_file, argv[++i], sizeof(cfg->trace_file) - 1);
+        else if (strcmp(argv[i], "--trace-every") == 0 && i + 1 < argc)
+            cfg->trace_every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--wait-report") == 0)
+            cfg->wait_report = 1;
+        else if (strcmp(argv[i], "--hwcounters") == 0)
+            cfg->hwcounters = 1;
+        else if (strcmp(argv[i], "--comm-matrix") == 0 && i + 1 < argc)
+            strncpy(cfg->comm_matrix, argv[++i], sizeof(cfg->comm_matrix) - 1);
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+            cfg->bench_reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench-warmup") == 0 && i + 1 < argc)
+            cfg->bench_warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench-json") == 0 && i + 1 < argc)
+            strncpy(cfg->bench_json, argv[++i], sizeof(cfg->bench_json) - 1);
+        else if (strcmp(argv[i], "--bench-ref") == 0 && i + 1 < argc)
+            cfg->bench_ref = atof(argv[++i]);
+        else if (strcmp(argv[i], "--cells-per-rank") == 0 && i + 1 < argc) {
+            /* WxH, ou N células numa sub-grade quadrada de lado ~sqrt(N). */
+            const char *v = argv[++i];
+            if (sscanf(v, "%dx%d", &cfg->rank_w, &cfg->rank_h) != 2) {
+                long n = atol(v);
+                cfg->rank_w = cfg->rank_h = n > 0 ? (int)lround(sqrt((double)n))
+                                                  : -1;
+            }
+        }
+        else if (strcmp(argv[i], "--agents-per-rank") == 0 && i + 1 < argc)
+            cfg->agents_per_rank = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--weak-scaling") == 0)
+            cfg->weak_scaling = 1;
+        else if (strcmp(argv[i], "--digest-every") == 0 && i + 1 < argc)
+            cfg->digest_every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--model") == 0)
+            cfg->model = 1;
+        else if (strcmp(argv[i], "--model-ns") == 0 && i + 1 < argc) {
+            cfg->model    = 1;
+            cfg->model_ns = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--model-threads") == 0 && i + 1 < argc) {
+            cfg->model         = 1;
+            cfg->model_threads = atoi(argv[++i]);
+        }
     }
 }
 
@@ -56,6 +402,8 @@ static void usage(const char *prog) {
         "  -h HEIGHT         Grid height (default %d)\n"
         "  -c CYCLES         Total cycles (default %d)\n"
         "  -s SEASON_LEN     Cycles per season (default %d)\n"
+        "  --seasons LIST    Season schedule name[:cycles],... with names\n"
+        "                    dry|wet|rising|falling (default %s)\n"
         "  -a AGENTS         Number of agents (default %d)\n"
         "  -W WORKLOAD       Max workload iterations (default %d)\n"
         "  -S SEED           Random seed (default %llu)\n"
@@ -64,86 +412,184 @@ static void usage(const char *prog) {
         "  --tui-file PATH   Write TUI frames to file (for MPI compatibility)\n"
         "  --csv             Output per-cycle timing as CSV to stdout\n"
         "  -R THRESHOLD      Energy threshold to reproduce (default %.1f)\n"
-        "  -r COST           Energy given to child / deducted from parent (default %.1f)\n",
+        "  -r COST           Energy given to child / deducted from parent (default %.1f)\n"
+        "  --alloc-stats     Report heap allocations per phase at exit\n"
+        "  --wire MODE       Cell resource on the wire: double|float|fixed16 (default double)\n"
+        "  --halo MODE       Halo backend: isend|shm|persistent|rma|partitioned\n"
+        "                    (default isend)\n"
+        "  --halo-depth K    Exchange halos/agents every K cycles (default %d)\n"
+        "  --comm-thread     Dedicate one OpenMP thread to MPI, overlapping compute\n"
+        "  --tasks           Run local phases as a per-tile OpenMP task graph\n"
+        "  --tile N          Tile side for --tasks (default %d)\n"
+        "  --autotune N      Try OpenMP schedules during the first N cycles\n"
+        "                    and keep the fastest per phase\n"
+        "  --tune-file PATH  Schedules file: written after --autotune,\n"
+        "                    read at startup otherwise\n"
+        "  --workload-sched MODE  Agent workload order: omp (runtime schedule)\n"
+        "                    or lpt (predicted cost, work stealing; default omp)\n"
+        "  --workload-profile NAME  Synthetic workload kernel: compute, memory\n"
+        "                    (random reads), chase (pointer chase) or stochastic\n"
+        "                    (random cost); same nominal cost (default compute)\n"
+        "  --trace PATH      Write a per-rank, per-thread timeline (Chrome Trace JSON)\n"
+        "  --trace-every N   Flush the trace every N cycles (default 0: at exit)\n"
+        "  --wait-report     Split MPI wait from transfer (PMPI) and report\n"
+        "                    per-phase percentiles and the critical-path rank\n"
+        "  --hwcounters      Per-phase cycles, instructions, LLC and branch misses\n"
+        "                    (perf_event_open); IPC and GB/s in CSV and report\n"
+        "  --comm-matrix PATH  Write rank x rank bytes/messages per phase, message\n"
+        "                    sizes and migrants per direction to PATH\n"
+        "  --bench R         Run R repetitions in-process (no TUI) and print\n"
+        "                    throughput and per-phase timings as JSON\n"
+        "  --bench-warmup N  Cycles discarded per repetition (default %d)\n"
+        "  --bench-json PATH Write the --bench JSON to PATH (default stdout)\n"
+        "  --bench-ref RATE  Agent updates/s of a 1-rank, 1-thread run, for\n"
+        "                    the parallel efficiency (default: measured after\n"
+        "                    the repetitions, R more on rank 0 with 1 thread)\n"
+        "  --cells-per-rank N|WxH  Derive -w/-h so every rank gets a WxH subgrid\n"
+        "                    (N: square of side ~sqrt(N))\n"
+        "  --agents-per-rank N  Set -a to N x ranks\n"
+        "  --weak-scaling    Run --bench on 1, 2, 4, ... ranks and all ranks with\n"
+        "                    --cells-per-rank/--agents-per-rank; report efficiency\n"
+        "                    relative to 1 rank (default %d repetitions)\n"
+        "  --digest-every N  Print a 64-bit digest of the grid and agents every\n"
+        "                    N cycles; invariant to agent order and thread count,\n"
+        "                    comparable across NP only when the trajectory is\n"
+        "  --model           Charge the agent workload in virtual time (calibrated\n"
+        "                    ns/iteration) instead of running it; the rest runs\n"
+        "  --model-ns NS     Cost per workload iteration for --model (default:\n"
+        "                    calibrated at startup)\n"
+        "  --model-threads T Threads assumed for the modelled workload (default:\n"
+        "                    the compute threads of the run)\n",
         prog,
         DEFAULT_GLOBAL_W, DEFAULT_GLOBAL_H, DEFAULT_TOTAL_CYCLES,
-        DEFAULT_SEASON_LENGTH, DEFAULT_NUM_AGENTS, DEFAULT_MAX_WORKLOAD,
+        DEFAULT_SEASON_LENGTH, DEFAULT_SEASONS,
+        DEFAULT_NUM_AGENTS, DEFAULT_MAX_WORKLOAD,
         (unsigned long long)DEFAULT_SEED, DEFAULT_TUI_INTERVAL,
-        DEFAULT_REPRODUCE_THRESHOLD, DEFAULT_REPRODUCE_COST);
+        DEFAULT_REPRODUCE_THRESHOLD, DEFAULT_REPRODUCE_COST,
+        DEFAULT_HALO_DEPTH, DEFAULT_TILE_SIZE, DEFAULT_BENCH_WARMUP,
+        DEFAULT_WEAK_REPS);
 }
 
-int main(int argc, char **argv) {
-    int provided;
-    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
-    if (provided < MPI_THREAD_FUNNELED) {
-        fprintf(stderr, "Error: MPI_THREAD_FUNNELED not supported "
-                "(requested %d, got %d)\n",
-                MPI_THREAD_FUNNELED, provided);
-        MPI_Abort(MPI_COMM_WORLD, 1);
+/* Threads por rank nos relatórios do --bench: as do modelo com --model. */
+static int run_threads(const SimConfig *cfg) {
+    return cfg->model ? cfg->model_threads : omp_get_max_threads();
+}
+
+/* Barreira em MPI_COMM_WORLD para quando só parte dos ranks mede: os
+ * de fora (`idle`) esperam sem ocupar o núcleo. */
+static void wait_measuring_ranks(int idle) {
+    MPI_Request req;
+    int done = 0;
+    MPI_Ibarrier(MPI_COMM_WORLD, &req);
+    while (!done) {
+        MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+        if (!done && idle)
+            usleep(1000);
     }
+}
 
+/* Destino do JSON do --bench: --bench-json PATH ou stdout. */
+static FILE *bench_out(const SimConfig *cfg) {
+    if (!cfg->bench_json[0])
+        return stdout;
+    FILE *out = fopen(cfg->bench_json, "w");
+    if (!out) {
+        fprintf(stderr, "Warning: cannot write %s; JSON to stdout\n",
+                cfg->bench_json);
+        out = stdout;
+    }
+    return out;
+}
+
+/*
+ * Uma execução completa: partição, grade, agentes, laço de ciclos e
+ * relatórios finais. Com `br` (--bench), os tempos de cada ciclo após o
+ * aquecimento vão para o BenchRun e o resumo final não é impresso; main
+ * chama de novo para cada repetição. `comm` é MPI_COMM_WORLD, ou os
+ * primeiros ranks na varredura do --weak-scaling. Retorna 0, ou 1 se a
+ * configuração não cabe na decomposição.
+ */
+static int run_simulation(SimConfig cfg, MPI_Comm comm, int halo_width,
+                          double hw_peak, BenchRun *br) {
     int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
 
-    SimConfig cfg = SIM_CONFIG_DEFAULTS;
-    parse_args(argc, argv, &cfg);
+    Partition partition;
+    partition_init(&partition, cfg.global_w, cfg.global_h, comm);
 
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--help") == 0) {
-            if (rank == 0) usage(argv[0]);
-            MPI_Finalize();
-            return 0;
-        }
-    }
+    /* Datatypes do fio criados uma única vez e reutilizados todo ciclo. */
+    pack_types_init();
 
-    if (rank == 0) {
-        FILE *info = cfg.csv_output ? stderr : stdout;
-        fprintf(info, "=== IPPD Simulation ===\n");
-        fprintf(info, "Grid: %dx%d | Cycles: %d | Agents: %d | Ranks: %d\n",
-                cfg.global_w, cfg.global_h, cfg.total_cycles,
-                cfg.num_agents, size);
-        fprintf(info, "Season length: %d | Seed: %llu | Workload: %d\n",
-                cfg.season_length, (unsigned long long)cfg.seed,
-                cfg.max_workload);
-        fprintf(info, "Reproduce: threshold=%.2f cost=%.2f\n",
-                cfg.reproduce_threshold, cfg.reproduce_cost);
-        fprintf(info, "TUI: %s (interval %d) | OMP threads: %d\n",
-                cfg.tui_enabled ? "on" : "off", cfg.tui_interval,
-                omp_get_max_threads());
-        fprintf(info, "=======================\n");
-
-        if (cfg.csv_output) {
-            printf("cycle,season,season_ms,halo_ms,workload_ms,agent_ms,"
-                   "grid_ms,migrate_ms,metrics_ms,cycle_ms,"
-                   "total_agents,total_resource,avg_energy,"
-                   "load_balance,workload_pct,comm_pct\n");
-            fflush(stdout);
+    /* O halo de cada rank vem inteiro do interior de um único vizinho. */
+    {
+        int lw, lh, ox, oy, dims[2], min_dims[2];
+        partition_subgrid_dims(&partition, cfg.global_w, cfg.global_h,
+                               &lw, &lh, &ox, &oy);
+        dims[0] = lw;
+        dims[1] = lh;
+        MPI_Allreduce(dims, min_dims, 2, MPI_INT, MPI_MIN, partition.cart_comm);
+        if (halo_width > 1 &&
+            (min_dims[0] < halo_width || min_dims[1] < halo_width)) {
+            if (rank == 0)
+                fprintf(stderr, "Error: --halo-depth %d needs subgrids of at "
+                        "least %dx%d cells (smallest is %dx%d)\n",
+                        cfg.halo_depth, halo_width, halo_width,
+                        min_dims[0], min_dims[1]);
+            pack_types_free();
+            partition_destroy(&partition);
+            return 1;
         }
     }
-
-    Partition partition;
-    partition_init(&partition, cfg.global_w, cfg.global_h, MPI_COMM_WORLD);
+    if (agent_ids_init(cfg.total_cycles, cfg.global_w, cfg.global_h) != 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: child ids need %d bits for the birth "
+                    "order; -c %d on a %dx%d grid leaves fewer\n",
+                    AGENT_ID_MIN_RANK_BITS, cfg.total_cycles,
+                    cfg.global_w, cfg.global_h);
+        pack_types_free();
+        partition_destroy(&partition);
+        return 1;
+    }
 
     SubGrid sg;
-    subgrid_create(&sg, &partition, cfg.global_w, cfg.global_h);
+    subgrid_create(&sg, &partition, cfg.global_w, cfg.global_h, halo_width);
     subgrid_init(&sg, &partition, cfg.seed);
 
-    int agent_count = 0;
-    int agent_capacity = cfg.num_agents * 2;
-    Agent *agents = malloc(sizeof(Agent) * (size_t)agent_capacity);
-    agents_init(agents, &agent_count, cfg.num_agents,
+    HaloCtx halo;
+    halo_init(&halo, (HaloMode)cfg.halo_mode, &sg, &partition);
+
+    /* Ids 0..num_agents-1 são dos agentes iniciais; filhos recebem
+     * ids de (ciclo, célula, posição na célula) — ver agent_child_id. */
+    AgentPool pool;
+    pool_init(&pool, 2 * cfg.num_agents / size + 16);
+    agents_init(&pool, cfg.num_agents,
                 &sg, &partition, cfg.global_w, cfg.global_h,
                 cfg.initial_energy, cfg.seed);
 
+    /* Buffers por ciclo (halos, migração, TUI) vêm desta arena. */
+    Arena frame;
+    arena_init(&frame, 1 << 16);
+
+    /* Halo profundo: fantasmas iniciais dos vizinhos. */
+    if (cfg.halo_depth > 1)
+        migrate_sync_ring(&pool, &partition, &sg,
+                          cfg.global_w, cfg.global_h, &frame);
+
+    /* Estado inicial: igual para qualquer NP e número de threads. */
+    if (cfg.digest_every > 0) {
+        uint64_t d = digest_global(&sg, &pool, partition.cart_comm);
+        if (rank == 0 && !(cfg.tui_enabled && !cfg.tui_file[0]))
+            fprintf((cfg.csv_output || br) ? stderr : stdout,
+                    "Digest: init %016llx\n", (unsigned long long)d);
+    }
+
     Cell *full_grid = NULL;
     if (rank == 0 && cfg.tui_enabled) {
-        full_grid = malloc(sizeof(Cell) *
-                           (size_t)cfg.global_w * (size_t)cfg.global_h);
+        full_grid = sim_malloc(sizeof(Cell) *
+                               (size_t)cfg.global_w * (size_t)cfg.global_h);
     }
 
-    int next_agent_id = cfg.num_agents;  /* IDs 0..num_agents-1 already used */
-
     TuiControl ctrl = { .state = TUI_RUNNING, .speed_ms = 100 };
 
     if (cfg.tui_enabled && rank == 0 && !cfg.tui_file[0])
@@ -152,254 +598,510 @@ int main(int argc, char **argv) {
     if (cfg.tui_file[0] && rank == 0)
         tui_set_output_file(cfg.tui_file);
 
+    uint64_t phase_allocs[PH_COUNT] = {0};
+    uint64_t alloc_mark  = 0;
+    uint64_t cycle_allocs = 0;
+    int      zero_alloc_cycles = 0;
+
+    /* Bytes enviados por fase, acumulados ao longo da execução. */
+    uint64_t wire_total[WIRE_PHASE_COUNT] = {0};
+
+    /* Último resumo do estado e custo dos resumos (--digest-every). */
+    uint64_t last_digest  = 0;
+    int      digest_count = 0;
+    double   digest_time  = 0.0;
+
+    /* Carga modelada acumulada (--model). */
+    double model_time = 0.0;
+
+    /* Dispersão do fim da carga entre threads: soma e pior ciclo. */
+    double spread_stats[2] = {0.0, 0.0};
+
+    /* Contadores de hardware: deste ciclo, da execução, e tempo das fases
+     * e agentes×ciclos e células×ciclos para as razões do relatório. */
+    uint64_t hw_cycle[PH_COUNT][HW_EVENTS];
+    uint64_t hw_total[PH_COUNT][HW_EVENTS] = {{0}};
+    double   hw_time[PH_COUNT] = {0};
+    double   hw_agent_cycles = 0.0;
+
+    if (cfg.trace_file[0] &&
+        trace_init(cfg.trace_file, partition.cart_comm) != 0 && rank == 0)
+        fprintf(stderr, "Warning: cannot write trace to %s; tracing off\n",
+                cfg.trace_file);
+
+    if (cfg.wait_report)
+        waitrep_begin(PH_COUNT, phase_names, partition.cart_comm);
+
+    if (cfg.comm_matrix[0])
+        commmat_init(size);
+
     double t_start = MPI_Wtime();
     int cycle = 0;
     CyclePerf last_perf = {0};
     int have_last_perf = 0;
 
-    while (cycle < cfg.total_cycles && ctrl.state != TUI_QUIT) {
-        int step_requested = 0;
+    /* Estado do ciclo compartilhado pela equipe. A região abaixo dura a
+     * execução inteira: o que a master prepara para as fases, ou lê
+     * delas, vive fora dela. */
+    const int   team_mode   = !cfg.comm_thread && !cfg.exec_tasks;
+    const int   max_threads = omp_get_max_threads();
+    int         step = CYCLE_RUN;
+    double      t_cycle_start = 0.0, t_trace_cycle = 0.0, t0 = 0.0;
+    CyclePerf   local_perf;
+    Season      season = DRY;
+    GridSweep   sweep;
+    double     *finish = NULL;
+    HaloJob     halo_job;
+    WorkloadJob work_job;
+    GridJob     grid_job;
+    MigrateJob  mig_job;
+    SimMetrics  local_metrics, global_metrics;
+
+    /* Uma única equipe OpenMP para todos os ciclos. As fases são
+     * construções órfãs (_team) separadas só pelas barreiras necessárias;
+     * MPI e cronometragem ficam na master (MPI_THREAD_FUNNELED), e as
+     * demais threads adiantam a carga durante a troca de halos e a
+     * regeneração durante a migração. Entre dois ciclos só a master
+     * trabalha (TUI e pausa, reduções, CSV, autotune) e as demais
+     * esperam na barreira seguinte; a master difunde em `step` se o
+     * ciclo roda, pausa ou encerra a execução.
+     *
+     * --comm-thread e --tasks abrem as próprias equipes (o par
+     * comunicação/computação e o grafo de tarefas): lá a região fica
+     * inativa, com uma thread, e as equipes internas continuam no
+     * primeiro nível ativo. */
+    #pragma omp parallel if (team_mode)
+    for (;;) {
+        #pragma omp master
+        {
+            step = cycle < cfg.total_cycles && ctrl.state != TUI_QUIT
+                 ? CYCLE_RUN : CYCLE_QUIT;
+            if (step == CYCLE_RUN) {
+                int step_requested = 0;
 
-        if (rank == 0 && cfg.tui_enabled && !cfg.tui_file[0])
-            step_requested = tui_poll_input(&ctrl);
+                arena_reset(&frame);
 
-        MPI_Bcast(&ctrl, sizeof(ctrl), MPI_BYTE, 0, partition.cart_comm);
-        MPI_Bcast(&step_requested, 1, MPI_INT, 0, partition.cart_comm);
+                if (rank == 0 && cfg.tui_enabled && !cfg.tui_file[0])
+                    step_requested = tui_poll_input(&ctrl);
 
-        if (ctrl.state == TUI_QUIT) break;
+                MPI_Bcast(&ctrl, sizeof(ctrl), MPI_BYTE, 0,
+                          partition.cart_comm);
+                MPI_Bcast(&step_requested, 1, MPI_INT, 0,
+                          partition.cart_comm);
 
-        if (ctrl.state == TUI_PAUSED && !step_requested) {
-            if (rank == 0 && cfg.tui_enabled) {
-                tui_gather_grid(&sg, &partition, full_grid,
-                                cfg.global_w, cfg.global_h,
-                                partition.cart_comm);
+                if (ctrl.state == TUI_QUIT)
+                    step = CYCLE_QUIT;
+                else if (ctrl.state == TUI_PAUSED && !step_requested)
+                    step = CYCLE_PAUSED;
+            }
 
+            if (step == CYCLE_PAUSED) {
                 Agent *all_agents = NULL;
                 int total_agents = 0;
-                tui_gather_agents(agents, agent_count, &all_agents,
-                                  &total_agents, partition.cart_comm);
+                gather_frame(&sg, &pool, &partition, &cfg, full_grid,
+                             &all_agents, &total_agents, &frame);
 
                 SimMetrics local_m, global_m;
-                metrics_compute_local(&sg, agents, agent_count, &local_m);
-                metrics_reduce_global(&local_m, &global_m,
-                                      partition.cart_comm);
+                metrics_compute_local(&sg, &pool, NULL, &local_m, &frame);
+                metrics_reduce_global(&local_m, &global_m, partition.cart_comm);
 
-                tui_render(full_grid, cfg.global_w, cfg.global_h,
-                           all_agents, total_agents,
-                           cycle, cfg.total_cycles,
-                           season_for_cycle(cycle, cfg.season_length),
-                           &global_m,
-                           have_last_perf ? &last_perf : NULL,
-                           &ctrl);
-                free(all_agents);
-                usleep(50000); /* 50ms poll interval to avoid busy-wait */
-            } else {
-                /* Ranks não-zero participam das chamadas coletivas mesmo em pausa. */
-                tui_gather_grid(&sg, &partition, NULL,
-                                cfg.global_w, cfg.global_h,
-                                partition.cart_comm);
-                Agent *dummy = NULL;
-                int dummy_count = 0;
-                tui_gather_agents(agents, agent_count, &dummy,
-                                  &dummy_count, partition.cart_comm);
-                free(dummy);
+                if (rank == 0 && cfg.tui_enabled) {
+                    tui_render(full_grid, cfg.global_w, cfg.global_h,
+                               all_agents, total_agents,
+                               cycle, cfg.total_cycles,
+                               season_for_cycle(cycle),
+                               &global_m,
+                               have_last_perf ? &last_perf : NULL,
+                               &ctrl, &frame);
+                    usleep(50000); /* 50ms poll interval to avoid busy-wait */
+                }
+                MPI_Barrier(partition.cart_comm);
+            } else if (step == CYCLE_RUN) {
+                t_cycle_start = MPI_Wtime();
+                t_trace_cycle = trace_begin();
+                local_perf    = (CyclePerf){0};
+                trace_set_cycle(cycle);
+                alloc_mark   = sim_alloc_count();
+                cycle_allocs = 0;
+                pack_bytes_reset();
 
-                SimMetrics local_m, global_m;
-                metrics_compute_local(&sg, agents, agent_count, &local_m);
-                metrics_reduce_global(&local_m, &global_m,
-                                      partition.cart_comm);
+                season = season_for_cycle(cycle);
+                grid_sweep_alloc(&sweep, &sg, &frame);
+                halo_job = (HaloJob){ &halo, &sg, &partition, &frame,
+                                      cycle % cfg.halo_depth == 0 };
+                finish = arena_alloc(&frame,
+                                     sizeof(double) * (size_t)max_threads);
+                for (int t = 0; t < max_threads; t++)
+                    finish[t] = -1.0;
+                work_job = (WorkloadJob){ &pool, &sg, cfg.max_workload,
+                                          NULL, finish };
+                grid_job = (GridJob){ &halo, &sg, season,
+                                      (cycle + 1) % cfg.halo_depth == 0,
+                                      &sweep };
+                mig_job  = (MigrateJob){ &pool, &partition, &sg,
+                                         cfg.global_w, cfg.global_h, &frame,
+                                         cfg.halo_depth, cycle };
             }
-            MPI_Barrier(partition.cart_comm);
+        }
+        #pragma omp barrier
+        if (step == CYCLE_QUIT)
+            break;
+        if (step == CYCLE_PAUSED) {
+            /* Todas leram `step` antes de a master reescrevê-lo. */
+            #pragma omp barrier
             continue;
         }
 
-        double t_cycle_start = MPI_Wtime();
-        CyclePerf local_perf = {0};
-
-        /* Phase 1: season broadcast + accessibility */
-        double t0 = MPI_Wtime();
-        Season season = season_for_cycle(cycle, cfg.season_length);
-        MPI_Bcast(&season, 1, MPI_INT, 0, partition.cart_comm);
-        for (int r = 1; r <= sg.local_h; r++) {
-            for (int c = 1; c <= sg.local_w; c++) {
-                Cell *cell = &sg.cells[CELL_AT(&sg, r, c)];
-                cell->accessible = season_accessibility(cell->type, season);
+        if (team_mode) {
+            hw_mark();
+
+            /* LPT: custos e filas antes da troca de halos (a carga só
+             * lê o interior), para a master não segurar as demais. */
+            LptPlan *plan = NULL;
+            if (cfg.workload_lpt) {
+                #pragma omp master
+                t0 = MPI_Wtime();
+                plan = agents_workload_plan_team(&pool, &sg,
+                                                 cfg.max_workload, &frame);
+                #pragma omp master
+                local_perf.workload_time = MPI_Wtime() - t0;
+                hw_sample(PH_WORKLOAD);
             }
-        }
-        local_perf.season_time = MPI_Wtime() - t0;
-
-        /* Phase 2: halo exchange */
-        t0 = MPI_Wtime();
-        halo_exchange(&sg, &partition);
-        local_perf.halo_time = MPI_Wtime() - t0;
-
-        /* Phase 3: synthetic workload (busy-loop only) */
-        t0 = MPI_Wtime();
-        agents_workload(agents, agent_count, &sg, cfg.max_workload);
-        local_perf.workload_time = MPI_Wtime() - t0;
-
-        /* Phase 4: agent decision logic */
-        t0 = MPI_Wtime();
-        agents_decide_all(agents, agent_count, &sg, season,
-                          cfg.seed, cfg.energy_gain, cfg.energy_loss);
-        local_perf.agent_time = MPI_Wtime() - t0;
-
-        /* Phase 4b: reproduction */
-        agents_reproduce(&agents, &agent_count, &agent_capacity,
-                         &next_agent_id, cfg.reproduce_threshold,
-                         cfg.reproduce_cost);
-
-        /* Phase 5: grid regeneration */
-        t0 = MPI_Wtime();
-        subgrid_update(&sg, season);
-        local_perf.grid_time = MPI_Wtime() - t0;
-
-        /* Phase 6: agent migration */
-        t0 = MPI_Wtime();
-        migrate_agents(&agents, &agent_count, &agent_capacity,
-                       &partition, &sg, cfg.global_w, cfg.global_h);
-        local_perf.migrate_time = MPI_Wtime() - t0;
-
-        /* Phase 7: metrics */
-        t0 = MPI_Wtime();
-        SimMetrics local_metrics, global_metrics;
-        metrics_compute_local(&sg, agents, agent_count, &local_metrics);
-        metrics_reduce_global(&local_metrics, &global_metrics,
-                              partition.cart_comm);
-        local_perf.metrics_time = MPI_Wtime() - t0;
 
-        int do_render = cfg.tui_enabled &&
-            (cycle % cfg.tui_interval == 0 ||
-             cycle == cfg.total_cycles - 1);
+            /* Phases 1-3: estação e troca de halos (master)
+             * || synthetic workload. */
+            #pragma omp master
+            {
+                t0 = MPI_Wtime();
+                TRACE_SCOPE(TR_SEASON)
+                    subgrid_set_season(&sg, season);
+                local_perf.season_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_SEASON);
+                hw_sample(PH_SEASON);
+                t0 = MPI_Wtime();
+                run_halo(&halo_job);
+                local_perf.halo_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_HALO);
+                hw_sample(PH_HALO);
+                t0 = MPI_Wtime();
+            }
+            if (plan)
+                agents_workload_lpt_team(plan, &pool, &sg,
+                                         cfg.max_workload, finish);
+            else
+                agents_workload_team(&pool, &sg, cfg.max_workload,
+                                     finish);
+            #pragma omp barrier
+            hw_sample(PH_WORKLOAD);
 
-        t0 = MPI_Wtime();
-        if (do_render) {
-            if (rank == 0) {
-                tui_gather_grid(&sg, &partition, full_grid,
-                                cfg.global_w, cfg.global_h,
-                                partition.cart_comm);
+            /* Phase 4: agent decision logic */
+            #pragma omp master
+            {
+                local_perf.workload_time += MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_WORKLOAD);
+                t0 = MPI_Wtime();
+            }
+            uint64_t *kid = agents_decide_all_team(&pool, &sg, cfg.seed,
+                                                   cycle, cfg.energy_gain,
+                                                   cfg.energy_loss, &frame);
+            hw_sample(PH_AGENT);
 
-                Agent *all_agents = NULL;
-                int total_agents = 0;
-                tui_gather_agents(agents, agent_count, &all_agents,
-                                  &total_agents, partition.cart_comm);
+            /* Phase 4b: reproduction */
+            #pragma omp master
+            {
+                local_perf.agent_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_AGENT);
+                t0 = MPI_Wtime();
+            }
+            agents_reproduce_team(&pool, kid, cfg.reproduce_threshold,
+                                  cfg.reproduce_cost, &frame);
+            hw_sample(PH_REPRODUCE);
 
-                local_perf.render_time = MPI_Wtime() - t0;
-                local_perf.cycle_time = MPI_Wtime() - t_cycle_start;
+            /* Phases 5+6: migration (master) || grid regeneration */
+            #pragma omp master
+            {
+                local_perf.reproduce_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_REPRODUCE);
+                t0 = MPI_Wtime();
+                run_migrate(&mig_job);
+                local_perf.migrate_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_MIGRATE);
+                hw_sample(PH_MIGRATE);
+                t0 = MPI_Wtime();
+            }
+            halo_update_and_send_team(&halo, &sg, season, grid_job.send,
+                                      &sweep);
+            #pragma omp barrier
+            hw_sample(PH_GRID);
 
-                /* Single MPI_Reduce on 9 contiguous doubles (MPI_MAX). */
-                CyclePerf global_perf = {0};
-                MPI_Reduce(&local_perf.cycle_time, &global_perf.cycle_time,
-                           9, MPI_DOUBLE, MPI_MAX, 0, partition.cart_comm);
-
-                int min_agents, max_agents;
-                MPI_Reduce(&agent_count, &min_agents, 1, MPI_INT,
-                           MPI_MIN, 0, partition.cart_comm);
-                MPI_Reduce(&agent_count, &max_agents, 1, MPI_INT,
-                           MPI_MAX, 0, partition.cart_comm);
-
-                global_perf.load_balance = (max_agents > 0)
-                    ? (double)min_agents / (double)max_agents : 1.0;
-                double compute_sum = global_perf.workload_time
-                                   + global_perf.agent_time
-                                   + global_perf.grid_time;
-                double comm_sum = global_perf.season_time
-                                + global_perf.halo_time
-                                + global_perf.migrate_time;
-                global_perf.comm_compute = (compute_sum > 0.0)
-                    ? comm_sum / compute_sum : 0.0;
-                global_perf.mpi_size    = size;
-                global_perf.omp_threads = omp_get_max_threads();
-
-                tui_render(full_grid, cfg.global_w, cfg.global_h,
-                           all_agents, total_agents,
-                           cycle, cfg.total_cycles,
-                           season, &global_metrics,
-                           &global_perf, &ctrl);
-
-                last_perf = global_perf;
-                have_last_perf = 1;
-
-                free(all_agents);
-                usleep((unsigned int)(ctrl.speed_ms * 1000));
+            /* Phase 7 (parte local): metrics */
+            #pragma omp master
+            {
+                local_perf.grid_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_GRID);
+                t0 = MPI_Wtime();
+            }
+            metrics_compute_local_team(&sg, &pool, &sweep,
+                                       &local_metrics, &frame);
+            hw_sample(PH_METRICS);
+        } else {
+            /* Phase 1: estação (troca do plano de acessibilidade) */
+            t0 = MPI_Wtime();
+            TRACE_SCOPE(TR_SEASON)
+                subgrid_set_season(&sg, season);
+            local_perf.season_time = MPI_Wtime() - t0;
+            PHASE_ALLOCS(PH_SEASON);
+
+            /* Phases 2+3: halo exchange (a cada halo_depth ciclos) and
+             * synthetic workload. Independentes: a carga só lê o interior. */
+            if (cfg.exec_tasks) {
+                /* A carga roda dentro do grafo de tarefas (phase 4). */
+                t0 = MPI_Wtime();
+                run_halo(&halo_job);
+                local_perf.halo_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_HALO);
             } else {
-                /* Ranks não-zero participam dos gathers e reduções de perf. */
-                tui_gather_grid(&sg, &partition, NULL,
-                                cfg.global_w, cfg.global_h,
-                                partition.cart_comm);
-                Agent *dummy = NULL;
-                int dummy_count = 0;
-                tui_gather_agents(agents, agent_count, &dummy,
-                                  &dummy_count, partition.cart_comm);
-                free(dummy);
+                /* A arena não é thread-safe e run_halo aloca dela na
+                 * thread de comunicação: o plano LPT sai antes do par. */
+                double t_plan = 0.0;
+                if (cfg.workload_lpt) {
+                    t0 = MPI_Wtime();
+                    work_job.plan = agents_workload_plan(
+                        &pool, &sg, cfg.max_workload,
+                        comm_thread_compute_threads(), &frame);
+                    t_plan = MPI_Wtime() - t0;
+                }
+                OverlapTimes ot = {0};
+                comm_thread_overlap(run_halo, &halo_job,
+                                    run_workload, &work_job, &ot);
+                local_perf.halo_time     = ot.comm_time;
+                local_perf.workload_time = ot.compute_time + t_plan;
+                local_perf.overlap_time += ot.overlap_time;
+                PHASE_ALLOCS(PH_HALO);
+            }
 
-                local_perf.render_time = MPI_Wtime() - t0;
+            /* Phase 4: agent decision logic (--tasks: workload, decisão,
+             * consumo e regeneração num único grafo de tarefas por tile) */
+            t0 = MPI_Wtime();
+            uint64_t *kid;
+            if (cfg.exec_tasks)
+                TRACE_SCOPE(TR_TASKS)
+                    kid = taskgraph_step(&pool, &sg, season, &cfg, cycle,
+                                         &frame);
+            else
+                kid = agents_decide_all(&pool, &sg, cfg.seed, cycle,
+                                        cfg.energy_gain, cfg.energy_loss,
+                                        &frame);
+            local_perf.agent_time = MPI_Wtime() - t0;
+            PHASE_ALLOCS(PH_AGENT);
+
+            /* Phase 4b: reproduction */
+            t0 = MPI_Wtime();
+            agents_reproduce(&pool, kid, cfg.reproduce_threshold,
+                             cfg.reproduce_cost, &frame);
+            local_perf.reproduce_time = MPI_Wtime() - t0;
+            PHASE_ALLOCS(PH_REPRODUCE);
+
+            /* Phases 5+6: grid regeneration and agent migration.
+             * Independentes: uma só toca células, a outra só o pool. */
+            if (cfg.exec_tasks) {
+                t0 = MPI_Wtime();
+                run_migrate(&mig_job);
+                local_perf.migrate_time = MPI_Wtime() - t0;
+                PHASE_ALLOCS(PH_MIGRATE);
+            } else {
+                OverlapTimes ot = {0};
+                comm_thread_overlap(run_migrate, &mig_job,
+                                    run_grid, &grid_job, &ot);
+                local_perf.migrate_time  = ot.comm_time;
+                local_perf.grid_time     = ot.compute_time;
+                local_perf.overlap_time += ot.overlap_time;
+                PHASE_ALLOCS(PH_MIGRATE);
+            }
+
+            /* Phase 7: metrics */
+            t0 = MPI_Wtime();
+            metrics_compute_local(&sg, &pool,
+                                  cfg.exec_tasks ? NULL : &sweep,
+                                  &local_metrics, &frame);
+        }
+        /* Fecha as fases como o fim de uma região: contadores e eventos
+         * de rastro de todas as threads estão gravados, e o que a master
+         * lê a seguir (métricas, fim da carga) está completo. */
+        #pragma omp barrier
+
+        #pragma omp master
+        {
+            /* Fora do par do --comm-thread: a redução depende das
+             * métricas locais, o último trabalho do ciclo, e tudo o que
+             * vem depois (CSV, TUI, autotune) depende dela. */
+            TRACE_SCOPE(TR_REDUCE)
+                metrics_reduce_global(&local_metrics, &global_metrics,
+                                      partition.cart_comm);
+            local_perf.metrics_time = MPI_Wtime() - t0;
+            PHASE_ALLOCS(PH_METRICS);
+
+            if (cfg.hwcounters) {
+                hw_take(hw_cycle);
+                for (int ph = 0; ph < PH_COUNT; ph++) {
+                    for (int e = 0; e < HW_EVENTS; e++)
+                        hw_total[ph][e] += hw_cycle[ph][e];
+                    hw_time[ph] += (&local_perf.season_time)[ph];
+                }
+                hw_agent_cycles += global_metrics.alive_agents;
+            }
+
+            /* --model: o relógio do ciclo passa a contar a carga modelada,
+             * que não rodou. */
+            if (vtime_enabled) {
+                double iters, vt = vtime_take(&iters);
+                local_perf.workload_time += vt;
+                t_cycle_start            -= vt;
+                model_time               += vt;
+            }
+
+            /* Estado no fim do ciclo; com halo profundo, só após a
+             * sincronização do anel (N múltiplo de --halo-depth). */
+            if (cfg.digest_every > 0 && (cycle + 1) % cfg.digest_every == 0) {
+                double t_digest = MPI_Wtime();
+                last_digest = digest_global(&sg, &pool, partition.cart_comm);
+                digest_time += MPI_Wtime() - t_digest;
+                digest_count++;
+                if (rank == 0 && !(cfg.tui_enabled && !cfg.tui_file[0]))
+                    fprintf((cfg.csv_output || br) ? stderr : stdout,
+                            "Digest: cycle %d %016llx\n", cycle,
+                            (unsigned long long)last_digest);
+            }
+
+            local_perf.spread_time = finish_spread(finish, max_threads);
+            spread_stats[0] += local_perf.spread_time;
+            if (local_perf.spread_time > spread_stats[1])
+                spread_stats[1] = local_perf.spread_time;
+
+            /* Autotune: carga inclui a troca de halos e a regeneração inclui
+             * a migração, que correm junto com elas. */
+            if (autotune_active()) TRACE_SCOPE(TR_AUTOTUNE) {
+                double tt[TUNE_PHASES] = {
+                    local_perf.halo_time + local_perf.workload_time,
+                    local_perf.agent_time,
+                    local_perf.migrate_time + local_perf.grid_time
+                };
+                if (autotune_record(tt, partition.cart_comm) && rank == 0) {
+                    FILE *info = (cfg.csv_output || br) ? stderr : stdout;
+                    char b0[48], b1[48], b2[48];
+                    fprintf(info,
+                            "Autotune: workload=%s | decide=%s | grid=%s\n",
+                            tune_format(tune_get(TUNE_WORKLOAD),
+                                        b0, sizeof(b0)),
+                            tune_format(tune_get(TUNE_DECIDE),
+                                        b1, sizeof(b1)),
+                            tune_format(tune_get(TUNE_GRID),
+                                        b2, sizeof(b2)));
+                    if (cfg.tune_file[0]) {
+                        char note[128];
+                        snprintf(note, sizeof(note),
+                                 "autotune: np=%d omp=%d grid=%dx%d agents=%d",
+                                 size, omp_get_max_threads(),
+                                 cfg.global_w, cfg.global_h, cfg.num_agents);
+                        if (tune_save(cfg.tune_file, note) != 0)
+                            fprintf(stderr, "Warning: cannot write %s\n",
+                                    cfg.tune_file);
+                    }
+                }
+            }
+
+            int do_render = cfg.tui_enabled &&
+                (cycle % cfg.tui_interval == 0 ||
+                 cycle == cfg.total_cycles - 1);
+
+            t0 = MPI_Wtime();
+            double t_trace_out = trace_begin();
+            if (do_render || cfg.csv_output || br) {
+                Agent *all_agents = NULL;
+                int total_agents = 0;
+                if (do_render) {
+                    gather_frame(&sg, &pool, &partition, &cfg, full_grid,
+                                 &all_agents, &total_agents, &frame);
+                    local_perf.render_time = MPI_Wtime() - t0;
+                }
                 local_perf.cycle_time = MPI_Wtime() - t_cycle_start;
 
-                CyclePerf global_perf = {0};
-                MPI_Reduce(&local_perf.cycle_time, &global_perf.cycle_time,
-                           9, MPI_DOUBLE, MPI_MAX, 0, partition.cart_comm);
+                CyclePerf global_perf;
+                reduce_cycle_perf(&local_perf, local_metrics.alive_agents,
+                                  &global_perf, partition.cart_comm);
 
-                int min_agents, max_agents;
-                MPI_Reduce(&agent_count, &min_agents, 1, MPI_INT,
-                           MPI_MIN, 0, partition.cart_comm);
-                MPI_Reduce(&agent_count, &max_agents, 1, MPI_INT,
-                           MPI_MAX, 0, partition.cart_comm);
+                if (do_render) {
+                    if (rank == 0) {
+                        tui_render(full_grid, cfg.global_w, cfg.global_h,
+                                   all_agents, total_agents,
+                                   cycle, cfg.total_cycles,
+                                   season, &global_metrics,
+                                   &global_perf, &ctrl, &frame);
+                        last_perf = global_perf;
+                        have_last_perf = 1;
+                        usleep((unsigned int)(ctrl.speed_ms * 1000));
+                    }
+                } else if (cfg.csv_output) {
+                    csv_row(cycle, season, &global_perf, &global_metrics,
+                            hw_cycle, &cfg, partition.cart_comm);
+                } else if (rank == 0 && cycle >= br->warmup) {
+                    /* --bench: só os tempos do ciclo, como no CSV. */
+                    benchrun_cycle(br, &global_perf.cycle_time,
+                                   global_metrics.alive_agents,
+                                   (double)cfg.global_w * cfg.global_h);
+                }
             }
-        } else if (cfg.csv_output) {
-            /* CSV mode: lightweight per-cycle perf without TUI gathering. */
-            local_perf.cycle_time = MPI_Wtime() - t_cycle_start;
-
-            CyclePerf global_perf = {0};
-            MPI_Reduce(&local_perf.cycle_time, &global_perf.cycle_time,
-                       9, MPI_DOUBLE, MPI_MAX, 0, partition.cart_comm);
-
-            int min_agents, max_agents;
-            MPI_Reduce(&agent_count, &min_agents, 1, MPI_INT,
-                       MPI_MIN, 0, partition.cart_comm);
-            MPI_Reduce(&agent_count, &max_agents, 1, MPI_INT,
-                       MPI_MAX, 0, partition.cart_comm);
-
-            if (rank == 0) {
-                double lb = (max_agents > 0)
-                    ? (double)min_agents / (double)max_agents : 1.0;
-                double cycle_ms    = global_perf.cycle_time    * 1000.0;
-                double season_ms   = global_perf.season_time   * 1000.0;
-                double halo_ms     = global_perf.halo_time     * 1000.0;
-                double workload_ms = global_perf.workload_time * 1000.0;
-                double agent_ms    = global_perf.agent_time    * 1000.0;
-                double grid_ms     = global_perf.grid_time     * 1000.0;
-                double migrate_ms  = global_perf.migrate_time  * 1000.0;
-                double metrics_ms  = global_perf.metrics_time  * 1000.0;
-                double workload_pct = (cycle_ms > 0.0)
-                    ? workload_ms / cycle_ms * 100.0 : 0.0;
-                double comm_pct = (cycle_ms > 0.0)
-                    ? (season_ms + halo_ms + migrate_ms) / cycle_ms * 100.0
-                    : 0.0;
-                printf("%d,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,"
-                       "%d,%.1f,%.3f,%.4f,%.2f,%.2f\n",
-                       cycle,
-                       season == DRY ? "dry" : "wet",
-                       season_ms, halo_ms, workload_ms, agent_ms,
-                       grid_ms, migrate_ms, metrics_ms, cycle_ms,
-                       global_metrics.alive_agents,
-                       global_metrics.total_resource,
-                       global_metrics.avg_energy,
-                       lb, workload_pct, comm_pct);
+            trace_end(TR_OUTPUT, t_trace_out);
+            PHASE_ALLOCS(PH_RENDER);
+
+            if (cfg.wait_report) {
+                local_perf.render_time = MPI_Wtime() - t0;
+                waitrep_cycle(&local_perf.season_time,
+                              MPI_Wtime() - t_cycle_start, partition.cart_comm);
             }
-        }
 
-        cycle++;
+            uint64_t cycle_wire[WIRE_PHASE_COUNT];
+            pack_bytes_get(cycle_wire);
+            for (int ph = 0; ph < WIRE_PHASE_COUNT; ph++)
+                wire_total[ph] += cycle_wire[ph];
+            if (commmat_enabled)
+                commmat_end_cycle();
+
+            if (cycle_allocs == 0)
+                zero_alloc_cycles++;
+
+            trace_end(TR_CYCLE, t_trace_cycle);
+            if (cfg.trace_every > 0 && (cycle + 1) % cfg.trace_every == 0)
+                trace_flush(partition.cart_comm);
+
+            cycle++;
+        }
     }
 
     double t_end = MPI_Wtime();
+    if (br && rank == 0)
+        benchrun_end_rep(br);
 
     if (rank == 0 && cfg.tui_enabled && !cfg.tui_file[0])
         tui_restore_terminal();
 
-    if (rank == 0) {
+    long long trace_lost = trace_finalize(partition.cart_comm);
+    mpiprof_enable(0);
+
+    uint64_t wire_sum[WIRE_PHASE_COUNT] = {0};
+    MPI_Reduce(wire_total, wire_sum, WIRE_PHASE_COUNT, MPI_UINT64_T,
+               MPI_SUM, 0, partition.cart_comm);
+    double spread_max[2];
+    MPI_Reduce(spread_stats, spread_max, 2, MPI_DOUBLE, MPI_MAX, 0,
+               partition.cart_comm);
+    double model_max = 0.0;
+    if (cfg.model)
+        MPI_Reduce(&model_time, &model_max, 1, MPI_DOUBLE, MPI_MAX, 0,
+                   partition.cart_comm);
+
+    if (rank == 0 && !br) {
         SimMetrics final_local, final_global;
-        metrics_compute_local(&sg, agents, agent_count, &final_local);
+        metrics_compute_local(&sg, &pool, NULL, &final_local, &frame);
         metrics_reduce_global(&final_local, &final_global,
                               partition.cart_comm);
 
@@ -407,24 +1109,602 @@ int main(int argc, char **argv) {
         fprintf(info, "\n=== Simulation Complete ===\n");
         fprintf(info, "Total time:     %.3f s\n", t_end - t_start);
         fprintf(info, "Total resource: %.1f\n", final_global.total_resource);
+        fprintf(info, "  by type:      aldeia %.1f | pesca %.1f | coleta %.1f"
+                      " | rocado %.1f | interditada %.1f\n",
+                final_global.type_resource[ALDEIA],
+                final_global.type_resource[PESCA],
+                final_global.type_resource[COLETA],
+                final_global.type_resource[ROCADO],
+                final_global.type_resource[INTERDITADA]);
         fprintf(info, "Alive agents:   %d\n", final_global.alive_agents);
         fprintf(info, "Avg energy:     %.3f\n", final_global.avg_energy);
         fprintf(info, "Max energy:     %.3f\n", final_global.max_energy);
         fprintf(info, "Min energy:     %.3f\n", final_global.min_energy);
+        fprintf(info, "Wire bytes:     halo %llu | migrate %llu | gather %llu\n",
+                (unsigned long long)wire_sum[WIRE_PHASE_HALO],
+                (unsigned long long)wire_sum[WIRE_PHASE_MIGRATE],
+                (unsigned long long)wire_sum[WIRE_PHASE_GATHER]);
+        if (!cfg.exec_tasks && cycle > 0)
+            fprintf(info, "Workload spread: avg %.3f ms | worst %.3f ms "
+                    "(%s)\n", spread_max[0] / cycle * 1000.0,
+                    spread_max[1] * 1000.0,
+                    cfg.workload_lpt ? "lpt" : "omp");
+        if (digest_count > 0)
+            fprintf(info, "Digest:         %016llx (%d digests, %.3f ms "
+                    "each on rank 0)\n", (unsigned long long)last_digest,
+                    digest_count, digest_time / digest_count * 1000.0);
+        if (cfg.model)
+            fprintf(info, "Model time:     %.3f s (run %.3f s + modelled "
+                    "workload %.3f s, slowest rank)\n",
+                    t_end - t_start + model_max, t_end - t_start, model_max);
+        if (cfg.trace_file[0])
+            fprintf(info, "Trace:          %s (%lld events lost)\n",
+                    cfg.trace_file, trace_lost);
         fprintf(info, "===========================\n");
     } else {
-        /* Ranks não-zero participam da redução final. */
+        /* Ranks não-zero (e o rank 0 no --bench) participam da redução
+         * final. */
         SimMetrics final_local, final_global;
-        metrics_compute_local(&sg, agents, agent_count, &final_local);
+        metrics_compute_local(&sg, &pool, NULL, &final_local, &frame);
         metrics_reduce_global(&final_local, &final_global,
                               partition.cart_comm);
     }
 
-    free(agents);
+    if (cfg.wait_report)
+        waitrep_print(cfg.csv_output ? stderr : stdout, partition.cart_comm);
+
+    if (cfg.hwcounters) {
+        hw_report(cfg.csv_output ? stderr : stdout, hw_total, hw_time,
+                  hw_agent_cycles,
+                  (double)cfg.global_w * cfg.global_h * cycle, hw_peak,
+                  partition.cart_comm);
+        hw_shutdown();
+    }
+
+    if (cfg.comm_matrix[0]) {
+        double nbr_share = 1.0;
+        int rc = commmat_write(cfg.comm_matrix, &partition, &nbr_share);
+        if (rank == 0) {
+            if (rc != 0)
+                fprintf(stderr, "Warning: cannot write comm matrix to %s\n",
+                        cfg.comm_matrix);
+            else if (nbr_share < 0.0)
+                fprintf(cfg.csv_output ? stderr : stdout,
+                        "Comm matrix: %s (no migrants)\n", cfg.comm_matrix);
+            else
+                fprintf(cfg.csv_output ? stderr : stdout,
+                        "Comm matrix: %s (%.1f%% of migrants went to the "
+                        "neighbour in their direction)\n",
+                        cfg.comm_matrix, 100.0 * nbr_share);
+        }
+    }
+
+    if (cfg.alloc_stats) {
+        /* Máximo entre ranks: o pior rank define o regime estacionário. */
+        uint64_t max_allocs[PH_COUNT];
+        int min_zero = 0;
+        MPI_Reduce(phase_allocs, max_allocs, PH_COUNT, MPI_UINT64_T,
+                   MPI_MAX, 0, partition.cart_comm);
+        MPI_Reduce(&zero_alloc_cycles, &min_zero, 1, MPI_INT,
+                   MPI_MIN, 0, partition.cart_comm);
+        if (rank == 0) {
+            FILE *info = cfg.csv_output ? stderr : stdout;
+            fprintf(info, "\n=== Heap allocations per phase (max over ranks) ===\n");
+            for (int ph = 0; ph < PH_COUNT; ph++)
+                fprintf(info, "%-10s %10llu\n", phase_names[ph],
+                        (unsigned long long)max_allocs[ph]);
+            fprintf(info, "Zero-alloc cycles: %d/%d | arena high-water: %zu bytes\n",
+                    min_zero, cycle, frame.high_water);
+            fprintf(info, "====================================================\n");
+        }
+    }
+
+    arena_destroy(&frame);
+    pool_destroy(&pool);
     free(full_grid);
+    halo_destroy(&halo, &sg);
     subgrid_destroy(&sg);
+    pack_types_free();
     partition_destroy(&partition);
-    MPI_Finalize();
 
     return 0;
 }
+
+/*
+ * Referência da eficiência paralela do --bench sem --bench-ref: as
+ * mesmas R repetições no rank 0 sozinho, com 1 thread (com --model, 1
+ * thread modelada), enquanto os demais esperam. Roda depois das
+ * repetições medidas para que o --autotune já tenha fixado a escolha em
+ * todos os ranks. *rate recebe a taxa média de atualizações de agente
+ * em todos os ranks (0 se não deu para medir).
+ */
+static int bench_reference(const SimConfig *cfg, int halo_width,
+                           double hw_peak, double *rate) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    *rate = 0.0;
+    if (autotune_active()) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --autotune still running after "
+                    "--bench; parallel_efficiency needs --bench-ref\n");
+        return 0;
+    }
+
+    SimConfig pc = *cfg;
+    pc.comm_thread   = 0;
+    pc.model_threads = 1;
+    BenchRun ref;
+    benchrun_init(&ref, cfg->bench_reps, cfg->bench_warmup);
+
+    int rc = 0;
+    MPI_Comm one;
+    MPI_Comm_split(MPI_COMM_WORLD, rank == 0 ? 0 : MPI_UNDEFINED, rank,
+                   &one);
+    if (one != MPI_COMM_NULL) {
+        const int threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+        if (cfg->model) {
+            vtime_shutdown();
+            vtime_init(cfg->model_ns, 1);
+        }
+        for (int r = 0; r < cfg->bench_reps && rc == 0; r++)
+            rc = run_simulation(pc, one, halo_width, hw_peak, &ref);
+        omp_set_num_threads(threads);
+        if (cfg->model) {
+            vtime_shutdown();
+            vtime_init(cfg->model_ns, cfg->model_threads);
+        }
+        MPI_Comm_free(&one);
+        if (rc == 0) {
+            *rate = benchrun_agent_rate(&ref);
+            fprintf(stderr, "Bench: reference (1 rank, 1 thread) done, "
+                    "%.1f agent updates/s\n", *rate);
+        }
+    }
+    wait_measuring_ranks(rank != 0);
+    benchrun_free(&ref);
+
+    MPI_Bcast(rate, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&rc, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    /* Os argumentos decidem o nível de threads pedido ao MPI. */
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    parse_args(argc, argv, &cfg);
+
+    int required = (cfg.comm_thread || cfg.halo_mode == HALO_PARTITIONED)
+                 ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
+    int provided;
+    MPI_Init_thread(&argc, &argv, required, &provided);
+    if (provided < MPI_THREAD_FUNNELED) {
+        fprintf(stderr, "Error: MPI_THREAD_FUNNELED not supported "
+                "(requested %d, got %d)\n",
+                MPI_THREAD_FUNNELED, provided);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (cfg.exec_tasks && cfg.comm_thread) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --tasks already overlaps the local "
+                    "phases; --comm-thread disabled\n");
+        cfg.comm_thread = 0;
+    }
+    if (cfg.comm_thread && provided < MPI_THREAD_MULTIPLE) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: MPI_THREAD_MULTIPLE not supported "
+                    "(got %d); --comm-thread disabled\n", provided);
+        cfg.comm_thread = 0;
+    }
+    if (cfg.comm_thread && !comm_thread_init(omp_get_max_threads())) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --comm-thread needs at least 2 OpenMP "
+                    "threads; disabled\n");
+        cfg.comm_thread = 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0) {
+            if (rank == 0) usage(argv[0]);
+            MPI_Finalize();
+            return 0;
+        }
+    }
+
+    if (cfg.wire_quant < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --wire expects double, float or fixed16\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.halo_mode < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --halo expects isend, shm, persistent, rma "
+                    "or partitioned\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.halo_mode == HALO_PARTITIONED && cfg.exec_tasks) {
+        /* O grafo de tarefas regenera a grade por tile, fora de
+         * halo_update_and_send: nenhuma linha seria liberada. */
+        if (rank == 0)
+            fprintf(stderr, "Error: --halo partitioned sends rows from the "
+                    "phased grid pass; it cannot run with --tasks\n");
+        MPI_Finalize();
+        return 1;
+    }
+    /* O banner, o JSON do --bench e halo_init veem o backend efetivo. */
+    if (cfg.halo_mode == HALO_PARTITIONED &&
+        halo_effective_mode(HALO_PARTITIONED) != HALO_PARTITIONED) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --halo partitioned needs MPI-4 and "
+                    "MPI_THREAD_MULTIPLE (have MPI %d.%d, thread level %d); "
+                    "using persistent\n",
+                    MPI_VERSION, MPI_SUBVERSION, provided);
+        cfg.halo_mode = HALO_PERSISTENT;
+    }
+    if (cfg.halo_mode == HALO_RMA && cfg.wire_quant != WIRE_DOUBLE) {
+        /* MPI_Put leva as células como estão, sem empacotar. */
+        if (rank == 0)
+            fprintf(stderr, "Error: --halo rma puts raw cells; --wire float "
+                    "and fixed16 need isend, shm, persistent or partitioned\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (season_schedule_set(cfg.seasons, cfg.season_length) != 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --seasons expects name[:cycles],... with "
+                    "names dry, wet, rising or falling (and -s >= 1)\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.tile_size < 1) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --tile expects N >= 1\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.halo_depth < 1) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --halo-depth expects K >= 1\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.workload_lpt < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --workload-sched expects omp or lpt\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.workload_profile < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --workload-profile expects compute, "
+                    "memory, chase or stochastic\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.workload_lpt && cfg.exec_tasks) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --tasks runs the workload per tile; "
+                    "--workload-sched lpt ignored\n");
+        cfg.workload_lpt = 0;
+    }
+    if (cfg.trace_every < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --trace-every expects N >= 0\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.autotune < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --autotune expects N >= 0\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.autotune > 0 && cfg.exec_tasks) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --tasks has no OpenMP loops to tune; "
+                    "--autotune disabled\n");
+        cfg.autotune = 0;
+    }
+    if (cfg.rank_w < 0 || cfg.rank_h < 0 || (!cfg.rank_w != !cfg.rank_h)) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --cells-per-rank expects N >= 1 or WxH\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.agents_per_rank < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --agents-per-rank expects N >= 0\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.weak_scaling && (!cfg.rank_w || !cfg.agents_per_rank)) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --weak-scaling needs --cells-per-rank and "
+                    "--agents-per-rank\n");
+        MPI_Finalize();
+        return 1;
+    }
+    /* Problema por rank: grade exata para a fatoração de partition_init. */
+    if (cfg.rank_w > 0)
+        partition_weak_dims(size, cfg.rank_w, cfg.rank_h,
+                            &cfg.global_w, &cfg.global_h);
+    if (cfg.agents_per_rank > 0)
+        cfg.num_agents = cfg.agents_per_rank * size;
+    if (cfg.weak_scaling && cfg.bench_reps == 0)
+        cfg.bench_reps = DEFAULT_WEAK_REPS;
+    if (cfg.bench_reps < 0 || cfg.bench_ref < 0.0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --bench expects R >= 1 and --bench-ref "
+                    "RATE >= 0\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.bench_reps > 0) {
+        if (cfg.bench_warmup < 0 || cfg.bench_warmup >= cfg.total_cycles) {
+            if (rank == 0)
+                fprintf(stderr, "Error: --bench-warmup expects 0 <= N < -c "
+                        "(%d)\n", cfg.total_cycles);
+            MPI_Finalize();
+            return 1;
+        }
+        /* Cada repetição mede só o ciclo: saídas por ciclo e relatórios
+         * de diagnóstico ficam de fora. */
+        if (rank == 0 && (cfg.csv_output || cfg.trace_file[0] ||
+                          cfg.wait_report || cfg.hwcounters ||
+                          cfg.comm_matrix[0] || cfg.alloc_stats))
+            fprintf(stderr, "Warning: --bench disables --csv, --trace, "
+                    "--wait-report, --hwcounters, --comm-matrix and "
+                    "--alloc-stats\n");
+        cfg.tui_enabled    = 0;
+        cfg.tui_file[0]    = '\0';
+        cfg.csv_output     = 0;
+        cfg.trace_file[0]  = '\0';
+        cfg.wait_report    = 0;
+        cfg.hwcounters     = 0;
+        cfg.comm_matrix[0] = '\0';
+        cfg.alloc_stats    = 0;
+    }
+    if (cfg.hwcounters && (cfg.comm_thread || cfg.exec_tasks)) {
+        if (rank == 0)
+            fprintf(stderr, "Warning: --hwcounters samples the phased cycle "
+                    "only; disabled with --comm-thread and --tasks\n");
+        cfg.hwcounters = 0;
+    }
+    /* Contadores: ligados só se todos os ranks conseguem abri-los; a
+     * banda de pico é medida com todos os ranks ao mesmo tempo. */
+    double hw_peak = 0.0;
+    if (cfg.hwcounters) {
+        const char *why = "";
+        int ok = hw_init(PH_COUNT, &why) == 0, all_ok;
+        MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (all_ok) {
+            double peak = hw_stream_peak();
+            MPI_Allreduce(&peak, &hw_peak, 1, MPI_DOUBLE, MPI_SUM,
+                          MPI_COMM_WORLD);
+        } else {
+            if (rank == 0)
+                fprintf(stderr, "Warning: hardware counters unavailable (%s); "
+                        "--hwcounters disabled\n",
+                        ok ? "on another rank" : why);
+            hw_shutdown();
+            cfg.hwcounters = 0;
+        }
+    }
+    if (cfg.digest_every < 0 ||
+        (cfg.digest_every > 0 && cfg.digest_every % cfg.halo_depth != 0)) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --digest-every expects N >= 0, a multiple "
+                    "of --halo-depth (%d)\n", cfg.halo_depth);
+        MPI_Finalize();
+        return 1;
+    }
+    if (cfg.model_ns < 0.0 || cfg.model_threads < 0) {
+        if (rank == 0)
+            fprintf(stderr, "Error: --model-ns expects NS >= 0 and "
+                    "--model-threads T >= 1\n");
+        MPI_Finalize();
+        return 1;
+    }
+    /* Perfil antes do --model, que calibra o kernel do perfil. */
+    workload_set_profile((WorkloadProfile)cfg.workload_profile);
+    /* Tempo virtual: o laço é calibrado em todos os ranks ao mesmo tempo
+     * e vale o custo do mais lento. */
+    if (cfg.model) {
+        if (cfg.model_ns == 0.0) {
+            double ns = vtime_calibrate();
+            MPI_Allreduce(&ns, &cfg.model_ns, 1, MPI_DOUBLE, MPI_MAX,
+                          MPI_COMM_WORLD);
+        }
+        if (cfg.model_threads == 0)
+            cfg.model_threads = cfg.comm_thread ? omp_get_max_threads() - 1
+                                                : omp_get_max_threads();
+        vtime_init(cfg.model_ns, cfg.model_threads);
+    }
+    pack_set_quant((WireQuant)cfg.wire_quant);
+
+    /* Escalonamentos: rank 0 lê o arquivo e difunde; com --autotune o
+     * arquivo é o destino da escolha. */
+    if (cfg.autotune > 0) {
+        autotune_begin(cfg.autotune, cfg.comm_thread
+                                     ? omp_get_max_threads() - 1
+                                     : omp_get_max_threads());
+    } else if (cfg.tune_file[0]) {
+        TuneSetting ts[TUNE_PHASES];
+        if (rank == 0) {
+            if (tune_load(cfg.tune_file) != 0)
+                fprintf(stderr, "Warning: cannot read schedules from %s; "
+                        "using defaults\n", cfg.tune_file);
+            for (int ph = 0; ph < TUNE_PHASES; ph++)
+                ts[ph] = tune_get((TunePhase)ph);
+        }
+        MPI_Bcast(ts, (int)sizeof(ts), MPI_BYTE, 0, MPI_COMM_WORLD);
+        for (int ph = 0; ph < TUNE_PHASES; ph++)
+            tune_set((TunePhase)ph, ts[ph]);
+    }
+
+    /* Um passo depende de células a até 2 de distância (agentes vizinhos
+     * do destino), então K passos sem troca exigem halo de 2K. Com K = 1
+     * a migração a cada ciclo dispensa o anel e o halo fica em 1. */
+    const int halo_width = (cfg.halo_depth > 1) ? 2 * cfg.halo_depth : 1;
+
+    if (rank == 0) {
+        FILE *info = (cfg.csv_output || cfg.bench_reps) ? stderr : stdout;
+        fprintf(info, "=== IPPD Simulation ===\n");
+        fprintf(info, "Grid: %dx%d | Cycles: %d | Agents: %d | Ranks: %d\n",
+                cfg.global_w, cfg.global_h, cfg.total_cycles,
+                cfg.num_agents, size);
+        fprintf(info, "Seasons: %s (default length %d) | Seed: %llu | "
+                "Workload: %d\n",
+                cfg.seasons, cfg.season_length, (unsigned long long)cfg.seed,
+                cfg.max_workload);
+        fprintf(info, "Reproduce: threshold=%.2f cost=%.2f\n",
+                cfg.reproduce_threshold, cfg.reproduce_cost);
+        fprintf(info, "TUI: %s (interval %d) | OMP threads: %d\n",
+                cfg.tui_enabled ? "on" : "off", cfg.tui_interval,
+                omp_get_max_threads());
+        fprintf(info, "Wire: %s (%zu bytes/cell, %zu bytes/agent)\n",
+                cfg.wire_quant == WIRE_FIXED16 ? "fixed16" :
+                cfg.wire_quant == WIRE_FLOAT   ? "float" : "double",
+                pack_cell_bytes(), sizeof(WireAgent));
+        fprintf(info, "Halo: %s (depth %d, width %d)\n",
+                halo_mode_name((HaloMode)cfg.halo_mode),
+                cfg.halo_depth, halo_width);
+        if (cfg.comm_thread)
+            fprintf(info, "Comm thread: on (1 MPI + %d compute threads)\n",
+                    omp_get_max_threads() - 1);
+        fprintf(info, "Execution: %s", cfg.exec_tasks ? "tasks" : "phased");
+        if (cfg.exec_tasks)
+            fprintf(info, " (tile %dx%d)", cfg.tile_size, cfg.tile_size);
+        fprintf(info, "\n");
+        if (cfg.autotune > 0) {
+            fprintf(info, "Schedules: autotune over %d cycles\n", cfg.autotune);
+        }
+        if (cfg.workload_lpt)
+            fprintf(info, "Workload schedule: lpt (predicted cost, work stealing)\n");
+        if (cfg.workload_profile != WL_COMPUTE)
+            fprintf(info, "Workload profile: %s (%.3f kernel steps per "
+                    "iteration)\n",
+                    workload_profile_name((WorkloadProfile)cfg.workload_profile),
+                    workload_profile_scale());
+        if (cfg.hwcounters)
+            fprintf(info, "HW counters: on | triad peak %.1f GB/s "
+                    "(sum over ranks)\n", hw_peak);
+        if (cfg.model)
+            fprintf(info, "Model: virtual workload at %.3f ns/iteration, "
+                    "%d threads\n", cfg.model_ns, cfg.model_threads);
+        if (cfg.rank_w > 0)
+            fprintf(info, "Per rank: %dx%d cells, %d agents\n",
+                    cfg.rank_w, cfg.rank_h, cfg.num_agents / size);
+        if (cfg.bench_reps)
+            fprintf(info, "Bench: %d repetitions, %d warmup cycles each\n",
+                    cfg.bench_reps, cfg.bench_warmup);
+        if (cfg.weak_scaling)
+            fprintf(info, "Weak scaling: 1, 2, 4, ... up to %d ranks\n", size);
+        if (cfg.autotune == 0 && !cfg.exec_tasks) {
+            char b0[48], b1[48], b2[48];
+            fprintf(info, "Schedules: workload=%s | decide=%s | grid=%s\n",
+                    tune_format(tune_get(TUNE_WORKLOAD), b0, sizeof(b0)),
+                    tune_format(tune_get(TUNE_DECIDE), b1, sizeof(b1)),
+                    tune_format(tune_get(TUNE_GRID), b2, sizeof(b2)));
+        }
+        fprintf(info, "=======================\n");
+
+        if (cfg.csv_output) {
+            printf("cycle,season,season_ms,halo_ms,workload_ms,agent_ms,"
+                   "grid_ms,migrate_ms,metrics_ms,cycle_ms,"
+                   "total_agents,total_resource,avg_energy,"
+                   "load_balance,workload_pct,comm_pct,reproduce_ms,"
+                   "halo_bytes,migrate_bytes,overlap_ms,spread_ms");
+            if (cfg.hwcounters)
+                printf(",ipc_workload,ipc_agent,ipc_grid,llc_per_agent,"
+                       "llc_per_cell,grid_gbs");
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+
+    int rc = 0;
+    if (cfg.weak_scaling) {
+        /* 1, 2, 4, ... ranks e o total, cada ponto com --bench R nos
+         * primeiros ranks; os demais esperam sem ocupar o núcleo. */
+        int counts[32], npts = 0;
+        for (int k = 1; k < size; k *= 2)
+            counts[npts++] = k;
+        counts[npts++] = size;
+        WeakPoint *pts = sim_calloc((size_t)npts, sizeof(WeakPoint));
+        for (int i = 0; i < npts && rc == 0; i++) {
+            WeakPoint *wp = &pts[i];
+            SimConfig  pc = cfg;
+            wp->ranks = counts[i];
+            partition_weak_dims(wp->ranks, cfg.rank_w, cfg.rank_h,
+                                &pc.global_w, &pc.global_h);
+            pc.num_agents = cfg.agents_per_rank * wp->ranks;
+            wp->global_w  = pc.global_w;
+            wp->global_h  = pc.global_h;
+            wp->agents    = pc.num_agents;
+            benchrun_init(&wp->run, cfg.bench_reps, cfg.bench_warmup);
+
+            MPI_Comm sub;
+            MPI_Comm_split(MPI_COMM_WORLD, rank < wp->ranks ? 0 : MPI_UNDEFINED,
+                           rank, &sub);
+            if (sub != MPI_COMM_NULL) {
+                for (int r = 0; r < cfg.bench_reps && rc == 0; r++)
+                    rc = run_simulation(pc, sub, halo_width, hw_peak, &wp->run);
+                MPI_Comm_free(&sub);
+            }
+            wait_measuring_ranks(rank >= wp->ranks);
+            int any_rc;
+            MPI_Allreduce(&rc, &any_rc, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            rc = any_rc;
+            if (rank == 0 && rc == 0)
+                fprintf(stderr, "Weak scaling: %d ranks done (grid %dx%d, "
+                        "%d agents)\n", wp->ranks, wp->global_w,
+                        wp->global_h, wp->agents);
+        }
+        if (rank == 0 && rc == 0) {
+            FILE *out = bench_out(&cfg);
+            benchrun_weak_print(out, pts, npts, &cfg, run_threads(&cfg));
+            if (out != stdout)
+                fclose(out);
+        }
+        for (int i = 0; i < npts; i++)
+            benchrun_free(&pts[i].run);
+        free(pts);
+    } else if (cfg.bench_reps > 0) {
+        BenchRun br;
+        benchrun_init(&br, cfg.bench_reps, cfg.bench_warmup);
+        for (int r = 0; r < cfg.bench_reps && rc == 0; r++) {
+            rc = run_simulation(cfg, MPI_COMM_WORLD, halo_width, hw_peak, &br);
+            if (rank == 0 && rc == 0)
+                fprintf(stderr, "Bench: repetition %d/%d done\n",
+                        r + 1, cfg.bench_reps);
+        }
+        double ref_rate = cfg.bench_ref;
+        if (rc == 0 && ref_rate == 0.0 && size * run_threads(&cfg) > 1)
+            rc = bench_reference(&cfg, halo_width, hw_peak, &ref_rate);
+        if (rank == 0 && rc == 0) {
+            FILE *out = bench_out(&cfg);
+            benchrun_print(out, &br, &cfg, size, run_threads(&cfg),
+                           ref_rate);
+            if (out != stdout)
+                fclose(out);
+        }
+        benchrun_free(&br);
+    } else {
+        rc = run_simulation(cfg, MPI_COMM_WORLD, halo_width, hw_peak, NULL);
+    }
+
+    if (cfg.model)
+        vtime_shutdown();
+    workload_shutdown();
+    MPI_Finalize();
+
+    return rc;
+}
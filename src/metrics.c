@@ -1,38 +1,90 @@
 #include "metrics.h"
+#include "grid.h"
+#include "pool.h"
+#include "trace.h"
 #include "types.h"
 #include <float.h>
 
-void metrics_compute_local(const SubGrid *sg, const Agent *agents,
-                           int count, SimMetrics *local)
+/* Slots do pool por parcial de energia. */
+#define METRICS_BLOCK 1024
+
+typedef struct {
+    double sum, max, min;
+    int    alive;
+} EnergyPart;
+
+void metrics_compute_local(const SubGrid *sg, const AgentPool *pool,
+                           const GridSweep *gs, SimMetrics *local,
+                           Arena *arena)
 {
-    double total_res = 0.0;
-    for (int r = 1; r <= sg->local_h; r++) {
-        for (int c = 1; c <= sg->local_w; c++) {
-            total_res += sg->cells[CELL_AT(sg, r, c)].resource;
-        }
+    #pragma omp parallel
+    metrics_compute_local_team(sg, pool, gs, local, arena);
+}
+
+void metrics_compute_local_team(const SubGrid *sg, const AgentPool *pool,
+                                const GridSweep *gs, SimMetrics *local,
+                                Arena *arena)
+{
+    double t_trace = trace_begin();
+    const int nblocks = (pool->count + METRICS_BLOCK - 1) / METRICS_BLOCK;
+
+    /* Parciais por linha (da passada fundida, ou calculadas aqui) e por
+     * bloco de slots, combinadas em ordem fixa: a soma não depende do
+     * número de threads. */
+    GridSweep   own;
+    EnergyPart *part;
+    #pragma omp single copyprivate(own, part)
+    {
+        if (!gs)
+            grid_sweep_alloc(&own, sg, arena);
+        part = arena_alloc(arena, sizeof(EnergyPart) *
+                           (size_t)(nblocks > 0 ? nblocks : 1));
     }
-    local->total_resource = total_res;
-
-    double sum_energy = 0.0;
-    double max_e      = -DBL_MAX;
-    double min_e      =  DBL_MAX;
-    int    alive      = 0;
-
-    for (int i = 0; i < count; i++) {
-        if (!agents[i].alive) continue;
-        double e = agents[i].energy;
-        sum_energy += e;
-        if (e > max_e) max_e = e;
-        if (e < min_e) min_e = e;
-        alive++;
+    if (!gs)
+        subgrid_sum_rows_team(sg, &own);
+
+    #pragma omp for schedule(static)
+    for (int b = 0; b < nblocks; b++) {
+        EnergyPart ep = { 0.0, -DBL_MAX, DBL_MAX, 0 };
+        int end = (b + 1) * METRICS_BLOCK;
+        if (end > pool->count) end = pool->count;
+        for (int i = b * METRICS_BLOCK; i < end; i++) {
+            if (!pool_alive(pool, i)) continue;
+            /* Fantasmas do halo profundo pertencem ao vizinho. */
+            if (!subgrid_interior(sg, pool->x[i], pool->y[i])) continue;
+            double e = pool->energy[i];
+            ep.sum += e;
+            if (e > ep.max) ep.max = e;
+            if (e < ep.min) ep.min = e;
+            ep.alive++;
+        }
+        part[b] = ep;
     }
 
-    local->alive_agents = alive;
-    local->max_energy   = (alive > 0) ? max_e : 0.0;
-    local->min_energy   = (alive > 0) ? min_e : 0.0;
-    /* Guarda a soma por enquanto; o passo de redução calcula a média
-       real como soma_global / vivos_global. */
-    local->avg_energy   = sum_energy;
+    #pragma omp single
+    {
+        grid_sweep_total(gs ? gs : &own, sg,
+                         &local->total_resource, local->type_resource);
+
+        double sum_energy = 0.0;
+        double max_e      = -DBL_MAX;
+        double min_e      =  DBL_MAX;
+        int    alive      = 0;
+        for (int b = 0; b < nblocks; b++) {
+            sum_energy += part[b].sum;
+            if (part[b].max > max_e) max_e = part[b].max;
+            if (part[b].min < min_e) min_e = part[b].min;
+            alive += part[b].alive;
+        }
+
+        local->alive_agents = alive;
+        local->max_energy   = (alive > 0) ? max_e : 0.0;
+        local->min_energy   = (alive > 0) ? min_e : 0.0;
+        /* Guarda a soma por enquanto; o passo de redução calcula a média
+           real como soma_global / vivos_global. */
+        local->avg_energy   = sum_energy;
+    }
+    trace_end(TR_METRICS, t_trace);
 }
 
 #ifdef USE_MPI
@@ -42,34 +94,37 @@ void metrics_compute_local(const SubGrid *sg, const Agent *agents,
 void metrics_reduce_global(const SimMetrics *local, SimMetrics *global,
                            MPI_Comm comm)
 {
-    MPI_Allreduce(&local->total_resource, &global->total_resource,
-                  1, MPI_DOUBLE, MPI_SUM, comm);
-
-    MPI_Allreduce(&local->alive_agents, &global->alive_agents,
-                  1, MPI_INT, MPI_SUM, comm);
-
-    /* avg_energy armazena a soma local; reduz a soma e divide pelo total de vivos. */
-    double energy_sum_local = local->avg_energy;
-    double energy_sum_global;
-    MPI_Allreduce(&energy_sum_local, &energy_sum_global,
-                  1, MPI_DOUBLE, MPI_SUM, comm);
-    global->avg_energy = (global->alive_agents > 0)
-                       ? energy_sum_global / global->alive_agents
-                       : 0.0;
-
-    MPI_Allreduce(&local->max_energy, &global->max_energy,
-                  1, MPI_DOUBLE, MPI_MAX, comm);
+    /* Duas reduções em vez de uma por campo: somas num vetor (vivos
+     * viajam como double, exatos até 2^53) e max/min num MPI_MAX, com o
+     * mínimo negado. avg_energy armazena a soma local. */
+    enum { S_TOTAL, S_TYPE, S_ENERGY = S_TYPE + CELL_TYPES, S_ALIVE, S_COUNT };
+    double sum_local[S_COUNT], sum_global[S_COUNT];
+    sum_local[S_TOTAL] = local->total_resource;
+    for (int t = 0; t < CELL_TYPES; t++)
+        sum_local[S_TYPE + t] = local->type_resource[t];
+    sum_local[S_ENERGY] = local->avg_energy;
+    sum_local[S_ALIVE]  = (double)local->alive_agents;
 
     /* Sentinela DBL_MAX para ranks sem agentes vivos, evitando que
        um min espúrio contamine o resultado global. */
-    double local_min = (local->alive_agents > 0)
-                     ? local->min_energy
-                     : DBL_MAX;
-    MPI_Allreduce(&local_min, &global->min_energy,
-                  1, MPI_DOUBLE, MPI_MIN, comm);
-
-    if (global->alive_agents == 0)
-        global->min_energy = 0.0;
+    double max_local[2] = {
+        local->max_energy,
+        -((local->alive_agents > 0) ? local->min_energy : DBL_MAX)
+    };
+    double max_global[2];
+
+    MPI_Allreduce(sum_local, sum_global, S_COUNT, MPI_DOUBLE, MPI_SUM, comm);
+    MPI_Allreduce(max_local, max_global, 2, MPI_DOUBLE, MPI_MAX, comm);
+
+    global->total_resource = sum_global[S_TOTAL];
+    for (int t = 0; t < CELL_TYPES; t++)
+        global->type_resource[t] = sum_global[S_TYPE + t];
+    global->alive_agents = (int)sum_global[S_ALIVE];
+    global->avg_energy   = (global->alive_agents > 0)
+                         ? sum_global[S_ENERGY] / global->alive_agents
+                         : 0.0;
+    global->max_energy = max_global[0];
+    global->min_energy = (global->alive_agents > 0) ? -max_global[1] : 0.0;
 }
 
 #endif /* USE_MPI */
@@ -1,163 +1,252 @@
 #ifdef USE_MPI
 
 #include "migrate.h"
+#include "commmat.h"
+#include "grid.h"
+#include "halo.h"
+#include "pack.h"
+#include "partition.h"
+#include "pool.h"
 #include "types.h"
 #include <mpi.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stddef.h>
 
-extern int partition_rank_for_global(const Partition *p, int gx, int gy,
-                                     int global_w, int global_h);
+/*
+ * Migração all-to-all em duas fases:
+ *   Fase 1 — classifica agentes em locais/migrantes (destino por slot),
+ *            conta por rank destino, troca contagens via MPI_Alltoall.
+ *   Fase 2 — empacota por destino (counting sort) em WireAgent, com
+ *            coordenadas já relativas à sub-grade do destino, e troca
+ *            via MPI_Alltoallv com o datatype em cache.
+ * Ao final, migrantes são marcados mortos no pool, os recebidos são
+ * anexados e a compactação é feita de forma amortizada.
+ * Todos os buffers temporários vêm da arena do ciclo.
+ */
 
-MPI_Datatype migrate_agent_type(void)
+/* Direção (DIR_* de halo.h) por onde o agente em (lc, lr), fora do
+ * interior, deixou a sub-grade; COMMMAT_DIR_OTHER se o dono da célula
+ * não é o vizinho cartesiano dessa direção. */
+static int migrant_dir(const Partition *p, const SubGrid *sg,
+                       int lc, int lr, int dest)
 {
-    const int nfields = 5;
-    int          block_lengths[5] = {1, 1, 1, 1, 1};
-    MPI_Datatype field_types[5]   = {MPI_INT, MPI_INT, MPI_INT,
-                                     MPI_DOUBLE, MPI_INT};
-    MPI_Aint     offsets[5];
-
-    offsets[0] = offsetof(Agent, id);
-    offsets[1] = offsetof(Agent, gx);
-    offsets[2] = offsetof(Agent, gy);
-    offsets[3] = offsetof(Agent, energy);
-    offsets[4] = offsetof(Agent, alive);
-
-    MPI_Datatype dt;
-    MPI_Type_create_struct(nfields, block_lengths, offsets, field_types, &dt);
-    MPI_Type_commit(&dt);
-    return dt;
+    static const int dir_of[3][3] = {        /* [dy + 1][dx + 1] */
+        { DIR_NW, DIR_N, DIR_NE },
+        { DIR_W,  -1,    DIR_E  },
+        { DIR_SW, DIR_S, DIR_SE }
+    };
+    int dx = lc < sg->halo ? -1 : lc >= sg->halo + sg->local_w ? 1 : 0;
+    int dy = lr < sg->halo ? -1 : lr >= sg->halo + sg->local_h ? 1 : 0;
+    int d  = dir_of[dy + 1][dx + 1];
+    return (d >= 0 && p->neighbors[d] == dest) ? d : COMMMAT_DIR_OTHER;
 }
 
-/*
- * Migração all-to-all em duas fases:
- *   Fase 1 — classifica agentes em locais/migrantes, agrupa por rank
- *            destino, troca contagens via MPI_Alltoall.
- *   Fase 2 — troca structs Agent via MPI_Alltoallv.
- * Ao final, compacta o array local removendo migrantes e
- * anexando os agentes recebidos.
- */
+/* Matriz de comunicação: uma contagem (MPI_Alltoall) para cada outro
+ * rank e, para quem recebe agentes, a carga do MPI_Alltoallv. */
+static void record_messages(const int *send_counts, int nprocs, int self)
+{
+    if (!commmat_enabled) return;
+    for (int r = 0; r < nprocs; r++) {
+        if (r == self) continue;
+        commmat_send(WIRE_PHASE_MIGRATE, r, sizeof(int));
+        if (send_counts[r] > 0)
+            commmat_send(WIRE_PHASE_MIGRATE, r,
+                         sizeof(WireAgent) * (uint64_t)send_counts[r]);
+    }
+}
 
-void migrate_agents(Agent **agents, int *count, int *capacity,
-                    Partition *p, SubGrid *sg,
-                    int global_w, int global_h)
+void migrate_agents(AgentPool *pool, Partition *p, SubGrid *sg,
+                    int global_w, int global_h, Arena *arena)
 {
     const int nprocs  = p->size;
     const int my_rank = p->rank;
 
-    const int x0 = sg->offset_x;
-    const int y0 = sg->offset_y;
-    const int x1 = x0 + sg->local_w - 1;
-    const int y1 = y0 + sg->local_h - 1;
-
-    Agent *ag    = *agents;
-    int    n     = *count;
-
-    int *send_counts = calloc(nprocs, sizeof(int));
-
-    int **per_rank_idx = calloc(nprocs, sizeof(int *));
-    int  *per_rank_cap = calloc(nprocs, sizeof(int));
+    const int n = pool->count;
 
-    int stay_count = 0;
+    int *send_counts = arena_calloc(arena, (size_t)nprocs, sizeof(int));
+    int *dest_of     = arena_alloc(arena, sizeof(int) * (size_t)(n > 0 ? n : 1));
 
     for (int i = 0; i < n; i++) {
-        if (!ag[i].alive) continue;
+        dest_of[i] = -1;
+        if (!pool_alive(pool, i)) continue;
 
-        int gx = ag[i].gx;
-        int gy = ag[i].gy;
+        int lc = pool->x[i];
+        int lr = pool->y[i];
 
-        if (gx >= x0 && gx <= x1 && gy >= y0 && gy <= y1) {
-            stay_count++;
+        if (subgrid_interior(sg, lc, lr))
             continue;
-        }
+
+        int gx = sg->offset_x + lc - sg->halo;
+        int gy = sg->offset_y + lr - sg->halo;
 
         int dest = partition_rank_for_global(p, gx, gy, global_w, global_h);
         if (dest == my_rank) {
             /* Caso raro: partition_rank_for_global pode retornar o próprio rank em bordas. */
-            stay_count++;
             continue;
         }
 
-        if (send_counts[dest] >= per_rank_cap[dest]) {
-            per_rank_cap[dest] = per_rank_cap[dest] ? per_rank_cap[dest] * 2 : 8;
-            per_rank_idx[dest] = realloc(per_rank_idx[dest],
-                                         sizeof(int) * per_rank_cap[dest]);
-        }
-        per_rank_idx[dest][send_counts[dest]] = i;
+        dest_of[i] = dest;
         send_counts[dest]++;
+        if (commmat_enabled)
+            commmat_migrant(migrant_dir(p, sg, lc, lr, dest));
     }
 
-    int *recv_counts = malloc(sizeof(int) * nprocs);
+    int *recv_counts = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
     MPI_Alltoall(send_counts, 1, MPI_INT,
                  recv_counts, 1, MPI_INT, p->cart_comm);
 
-    int *send_displs = malloc(sizeof(int) * nprocs);
-    int *recv_displs = malloc(sizeof(int) * nprocs);
+    int *send_displs = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    int *recv_displs = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    int *cursor      = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    /* Origem da sub-grade de cada destino: delta de coordenadas no fio. */
+    int *shift_x     = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    int *shift_y     = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
 
     int total_send = 0, total_recv = 0;
     for (int r = 0; r < nprocs; r++) {
         send_displs[r] = total_send;
         recv_displs[r] = total_recv;
+        cursor[r]      = total_send;
         total_send += send_counts[r];
         total_recv += recv_counts[r];
+
+        if (send_counts[r] > 0) {
+            int lw, lh, ox, oy;
+            partition_rank_dims(p, r, global_w, global_h, &lw, &lh, &ox, &oy);
+            shift_x[r] = sg->offset_x - ox;
+            shift_y[r] = sg->offset_y - oy;
+        }
     }
 
-    MPI_Datatype agent_t = migrate_agent_type();
+    WireAgent *send_buf = arena_alloc(arena, sizeof(WireAgent) *
+                                      (size_t)(total_send > 0 ? total_send : 1));
+    for (int i = 0; i < n; i++) {
+        int dest = dest_of[i];
+        if (dest < 0) continue;
+        WireAgent *a = &send_buf[cursor[dest]++];
+        a->id     = pool->id[i];
+        a->energy = pool->energy[i];
+        a->x      = (uint16_t)(pool->x[i] + shift_x[dest]);
+        a->y      = (uint16_t)(pool->y[i] + shift_y[dest]);
+        pool_kill(pool, i);
+    }
 
-    Agent *send_buf = malloc(sizeof(Agent) * (total_send > 0 ? total_send : 1));
-    int pos = 0;
-    for (int r = 0; r < nprocs; r++) {
-        for (int j = 0; j < send_counts[r]; j++) {
-            send_buf[pos++] = ag[per_rank_idx[r][j]];
+    WireAgent *recv_buf = arena_alloc(arena, sizeof(WireAgent) *
+                                      (size_t)(total_recv > 0 ? total_recv : 1));
+
+    MPI_Alltoallv(send_buf, send_counts, send_displs, pack_agent_type(),
+                  recv_buf, recv_counts, recv_displs, pack_agent_type(),
+                  p->cart_comm);
+    pack_bytes_add(WIRE_PHASE_MIGRATE,
+                   sizeof(int) * (uint64_t)(nprocs - 1) +
+                   sizeof(WireAgent) * (uint64_t)total_send);
+    record_messages(send_counts, nprocs, my_rank);
+
+    pool_maybe_compact(pool);
+
+    pool_reserve(pool, pool->count + total_recv);
+    for (int k = 0; k < total_recv; k++) {
+        const WireAgent *a = &recv_buf[k];
+        pool_push(pool, a->id, a->x, a->y, a->energy);
+    }
+}
+
+/*
+ * Sincronização do anel de agentes (halo profundo): descarta tudo o que
+ * está fora do interior — fantasmas e agentes que saíram, já recomputados
+ * pelo dono — e replica cada agente do interior que está na faixa
+ * halo_send_rect(d) para o vizinho d, em coordenadas de halo dele.
+ * Mesmo protocolo em duas fases de migrate_agents.
+ */
+void migrate_sync_ring(AgentPool *pool, Partition *p, SubGrid *sg,
+                       int global_w, int global_h, Arena *arena)
+{
+    const int nprocs = p->size;
+    const int n      = pool->count;
+
+    HaloRect rect[8];
+    int      shift_x[8], shift_y[8];
+    for (int d = 0; d < 8; d++) {
+        rect[d] = halo_send_rect(sg, d);
+        shift_x[d] = shift_y[d] = 0;
+        if (p->neighbors[d] == MPI_PROC_NULL) continue;
+        int lw, lh, ox, oy;
+        partition_rank_dims(p, p->neighbors[d], global_w, global_h,
+                            &lw, &lh, &ox, &oy);
+        shift_x[d] = sg->offset_x - ox;
+        shift_y[d] = sg->offset_y - oy;
+    }
+
+    /* Máscara de direções de cada slot; 0 = não enviado. */
+    unsigned char *dirs = arena_calloc(arena, (size_t)(n > 0 ? n : 1), 1);
+    int *send_counts    = arena_calloc(arena, (size_t)nprocs, sizeof(int));
+
+    for (int i = 0; i < n; i++) {
+        if (!pool_alive(pool, i)) continue;
+        int lc = pool->x[i];
+        int lr = pool->y[i];
+        if (!subgrid_interior(sg, lc, lr)) {
+            pool_kill(pool, i);
+            continue;
+        }
+        for (int d = 0; d < 8; d++) {
+            if (p->neighbors[d] == MPI_PROC_NULL) continue;
+            const HaloRect *rc = &rect[d];
+            if (lr >= rc->r0 && lr < rc->r0 + rc->h &&
+                lc >= rc->c0 && lc < rc->c0 + rc->w) {
+                dirs[i] |= (unsigned char)(1u << d);
+                send_counts[p->neighbors[d]]++;
+            }
         }
     }
 
-    Agent *recv_buf = malloc(sizeof(Agent) * (total_recv > 0 ? total_recv : 1));
+    int *recv_counts = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    MPI_Alltoall(send_counts, 1, MPI_INT,
+                 recv_counts, 1, MPI_INT, p->cart_comm);
 
-    MPI_Alltoallv(send_buf, send_counts, send_displs, agent_t,
-                  recv_buf, recv_counts, recv_displs, agent_t,
-                  p->cart_comm);
+    int *send_displs = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    int *recv_displs = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
+    int *cursor      = arena_alloc(arena, sizeof(int) * (size_t)nprocs);
 
+    int total_send = 0, total_recv = 0;
     for (int r = 0; r < nprocs; r++) {
-        for (int j = 0; j < send_counts[r]; j++) {
-            ag[per_rank_idx[r][j]].alive = 0;
-        }
+        send_displs[r] = total_send;
+        recv_displs[r] = total_recv;
+        cursor[r]      = total_send;
+        total_send += send_counts[r];
+        total_recv += recv_counts[r];
     }
 
-    int write_idx = 0;
+    WireAgent *send_buf = arena_alloc(arena, sizeof(WireAgent) *
+                                      (size_t)(total_send > 0 ? total_send : 1));
     for (int i = 0; i < n; i++) {
-        if (ag[i].alive) {
-            if (write_idx != i)
-                ag[write_idx] = ag[i];
-            write_idx++;
+        if (!dirs[i]) continue;
+        for (int d = 0; d < 8; d++) {
+            if (!(dirs[i] & (1u << d))) continue;
+            WireAgent *a = &send_buf[cursor[p->neighbors[d]]++];
+            a->id     = pool->id[i];
+            a->energy = pool->energy[i];
+            a->x      = (uint16_t)(pool->x[i] + shift_x[d]);
+            a->y      = (uint16_t)(pool->y[i] + shift_y[d]);
         }
     }
 
-    int new_count = write_idx + total_recv;
-    if (new_count > *capacity) {
-        int new_cap = *capacity;
-        while (new_cap < new_count)
-            new_cap = new_cap ? new_cap * 2 : 16;
-        ag = realloc(ag, sizeof(Agent) * new_cap);
-        *agents   = ag;
-        *capacity = new_cap;
-    }
+    WireAgent *recv_buf = arena_alloc(arena, sizeof(WireAgent) *
+                                      (size_t)(total_recv > 0 ? total_recv : 1));
+
+    MPI_Alltoallv(send_buf, send_counts, send_displs, pack_agent_type(),
+                  recv_buf, recv_counts, recv_displs, pack_agent_type(),
+                  p->cart_comm);
+    pack_bytes_add(WIRE_PHASE_MIGRATE,
+                   sizeof(int) * (uint64_t)(nprocs - 1) +
+                   sizeof(WireAgent) * (uint64_t)total_send);
+    record_messages(send_counts, nprocs, p->rank);
+
+    pool_maybe_compact(pool);
 
-    memcpy(&ag[write_idx], recv_buf, sizeof(Agent) * total_recv);
-    *count = new_count;
-
-    MPI_Type_free(&agent_t);
-    free(send_buf);
-    free(recv_buf);
-    free(send_counts);
-    free(recv_counts);
-    free(send_displs);
-    free(recv_displs);
-    for (int r = 0; r < nprocs; r++)
-        free(per_rank_idx[r]);
-    free(per_rank_idx);
-    free(per_rank_cap);
+    pool_reserve(pool, pool->count + total_recv);
+    for (int k = 0; k < total_recv; k++) {
+        const WireAgent *a = &recv_buf[k];
+        pool_push(pool, a->id, a->x, a->y, a->energy);
+    }
 }
 
 #endif /* USE_MPI */
@@ -0,0 +1,243 @@
+#include "mpiprof.h"
+#include "arena.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const op_names[MPROF_OPS] = {
+    "allreduce", "alltoall", "alltoallv", "waitall"
+};
+
+static int       enabled;
+static long long calls[MPROF_OPS];
+static double    wait_s[MPROF_OPS];
+static double    xfer_s[MPROF_OPS];
+static double    cycle_wait;
+
+void mpiprof_enable(int on) {
+    enabled = on;
+}
+
+double mpiprof_take_wait(void) {
+    double w = cycle_wait;
+    cycle_wait = 0.0;
+    return w;
+}
+
+/* Barreira antes da coletiva: a espera pelos ranks atrasados. */
+static double collective_wait(MpiProfOp op, MPI_Comm comm) {
+    double t0 = MPI_Wtime(), tt = trace_begin();
+    PMPI_Barrier(comm);
+    trace_end(TR_MPI_WAIT, tt);
+    double t1 = MPI_Wtime();
+    calls[op]++;
+    wait_s[op] += t1 - t0;
+    cycle_wait += t1 - t0;
+    return t1;
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    if (!enabled)
+        return PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    double t = collective_wait(MPROF_ALLREDUCE, comm);
+    int rc = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    xfer_s[MPROF_ALLREDUCE] += MPI_Wtime() - t;
+    return rc;
+}
+
+int MPI_Alltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                 MPI_Comm comm) {
+    if (!enabled)
+        return PMPI_Alltoall(sendbuf, sendcount, sendtype,
+                             recvbuf, recvcount, recvtype, comm);
+    double t = collective_wait(MPROF_ALLTOALL, comm);
+    int rc = PMPI_Alltoall(sendbuf, sendcount, sendtype,
+                           recvbuf, recvcount, recvtype, comm);
+    xfer_s[MPROF_ALLTOALL] += MPI_Wtime() - t;
+    return rc;
+}
+
+int MPI_Alltoallv(const void *sendbuf, const int sendcounts[],
+                  const int sdispls[], MPI_Datatype sendtype,
+                  void *recvbuf, const int recvcounts[],
+                  const int rdispls[], MPI_Datatype recvtype,
+                  MPI_Comm comm) {
+    if (!enabled)
+        return PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype,
+                              recvbuf, recvcounts, rdispls, recvtype, comm);
+    double t = collective_wait(MPROF_ALLTOALLV, comm);
+    int rc = PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype,
+                            recvbuf, recvcounts, rdispls, recvtype, comm);
+    xfer_s[MPROF_ALLTOALLV] += MPI_Wtime() - t;
+    return rc;
+}
+
+int MPI_Waitall(int count, MPI_Request array_of_requests[],
+                MPI_Status *array_of_statuses) {
+    if (!enabled)
+        return PMPI_Waitall(count, array_of_requests, array_of_statuses);
+    double t0 = MPI_Wtime(), tt = trace_begin();
+    int rc = PMPI_Waitall(count, array_of_requests, array_of_statuses);
+    trace_end(TR_MPI_WAIT, tt);
+    double w = MPI_Wtime() - t0;
+    calls[MPROF_WAITALL]++;
+    wait_s[MPROF_WAITALL] += w;
+    cycle_wait += w;
+    return rc;
+}
+
+/* ── Relatório ──────────────────────────────────────────────── */
+
+/* Por ciclo e rank: nphases tempos, tempo do ciclo e espera. */
+static int                nph;
+static const char *const *ph_names;
+static int                nranks;
+static int                ncycles;
+static double            *samples;     /* rank 0 */
+static size_t             samples_cap;
+static double            *row;         /* registro local do ciclo */
+
+#define REC(p) ((p) + 2)              /* doubles por registro */
+
+void waitrep_begin(int nphases, const char *const *names, MPI_Comm comm) {
+    MPI_Comm_size(comm, &nranks);
+    nph      = nphases;
+    ph_names = names;
+    ncycles  = 0;
+    row      = sim_malloc(sizeof(double) * (size_t)REC(nph));
+    mpiprof_take_wait();
+    mpiprof_enable(1);
+}
+
+void waitrep_cycle(const double *times, double cycle_time, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    memcpy(row, times, sizeof(double) * (size_t)nph);
+    row[nph]     = cycle_time;
+    row[nph + 1] = mpiprof_take_wait();
+
+    const size_t per_cycle = (size_t)nranks * REC(nph);
+    if (rank == 0 && (size_t)(ncycles + 1) * per_cycle > samples_cap) {
+        samples_cap = samples_cap ? 2 * samples_cap : 64 * per_cycle;
+        samples = sim_realloc(samples, sizeof(double) * samples_cap);
+    }
+    MPI_Gather(row, REC(nph), MPI_DOUBLE,
+               rank == 0 ? samples + (size_t)ncycles * per_cycle : NULL,
+               REC(nph), MPI_DOUBLE, 0, comm);
+    ncycles++;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Percentil pelo posto mais próximo sobre v[n] já ordenado. */
+static double percentile(const double *v, int n, double p) {
+    int k = (int)(p * n + 0.999999) - 1;
+    if (k < 0) k = 0;
+    if (k >= n) k = n - 1;
+    return v[k];
+}
+
+#define SAMPLE(c, r, k) samples[((size_t)(c) * nranks + (r)) * REC(nph) + (k)]
+
+void waitrep_print(FILE *out, MPI_Comm comm) {
+    mpiprof_enable(0);
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    long long call_sum[MPROF_OPS];
+    double    wait_sum[MPROF_OPS], xfer_sum[MPROF_OPS];
+    MPI_Reduce(calls, call_sum, MPROF_OPS, MPI_LONG_LONG, MPI_MAX, 0, comm);
+    MPI_Reduce(wait_s, wait_sum, MPROF_OPS, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(xfer_s, xfer_sum, MPROF_OPS, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+    if (rank == 0 && ncycles > 0) {
+        fprintf(out, "\n=== MPI wait vs transfer (s summed over ranks; calls per rank) ===\n");
+        fprintf(out, "%-10s %8s %10s %10s\n", "op", "calls", "wait_s", "xfer_s");
+        for (int op = 0; op < MPROF_OPS; op++) {
+            if (call_sum[op] == 0) continue;
+            if (op == MPROF_WAITALL)
+                fprintf(out, "%-10s %8lld %10.4f %10s\n", op_names[op],
+                        call_sum[op], wait_sum[op], "-");
+            else
+                fprintf(out, "%-10s %8lld %10.4f %10.4f\n", op_names[op],
+                        call_sum[op], wait_sum[op], xfer_sum[op]);
+        }
+
+        /* Percentis de cada fase sobre ciclos × ranks; desbalanceamento
+         * = soma, por ciclo, de (máximo - média) entre os ranks. */
+        const int ns = ncycles * nranks;
+        double *v     = sim_malloc(sizeof(double) * (size_t)ns);
+        double *total = sim_malloc(sizeof(double) * (size_t)nranks);
+        fprintf(out, "\n=== Phase time per rank (ms; %d cycles x %d ranks) ===\n",
+                ncycles, nranks);
+        fprintf(out, "%-10s %9s %9s %9s %9s %12s %8s\n", "phase", "p50",
+                "p95", "p99", "max", "imbalance_s", "slowest");
+        for (int k = 0; k <= nph; k++) {
+            double imb = 0.0;
+            memset(total, 0, sizeof(double) * (size_t)nranks);
+            for (int c = 0; c < ncycles; c++) {
+                double mx = 0.0, sum = 0.0;
+                for (int r = 0; r < nranks; r++) {
+                    double t = SAMPLE(c, r, k);
+                    v[c * nranks + r] = t;
+                    total[r] += t;
+                    sum += t;
+                    if (t > mx) mx = t;
+                }
+                imb += mx - sum / nranks;
+            }
+            int slow = 0;
+            for (int r = 1; r < nranks; r++)
+                if (total[r] > total[slow]) slow = r;
+            qsort(v, (size_t)ns, sizeof(double), cmp_double);
+            fprintf(out, "%-10s %9.3f %9.3f %9.3f %9.3f %12.4f %8d\n",
+                    k < nph ? ph_names[k] : "cycle",
+                    percentile(v, ns, 0.50) * 1e3,
+                    percentile(v, ns, 0.95) * 1e3,
+                    percentile(v, ns, 0.99) * 1e3,
+                    v[ns - 1] * 1e3, imb, slow);
+        }
+
+        /* Caminho crítico: o rank mais ocupado (ciclo - espera) de cada
+         * ciclo é o que os outros esperaram. */
+        int   *crit = sim_calloc((size_t)nranks, sizeof(int));
+        double imbalance = 0.0;
+        for (int c = 0; c < ncycles; c++) {
+            double mx = -1.0, sum = 0.0;
+            int    who = 0;
+            for (int r = 0; r < nranks; r++) {
+                double busy = SAMPLE(c, r, nph) - SAMPLE(c, r, nph + 1);
+                sum += busy;
+                if (busy > mx) { mx = busy; who = r; }
+            }
+            crit[who]++;
+            imbalance += mx - sum / nranks;
+        }
+        fprintf(out, "\nCritical path:");
+        const char *sep = " ";
+        for (int r = 0; r < nranks; r++) {
+            if (crit[r] == 0) continue;
+            fprintf(out, "%srank %d in %d/%d cycles", sep, r, crit[r], ncycles);
+            sep = " | ";
+        }
+        fprintf(out, "\nImbalance cost: %.4f s (per cycle, busiest rank minus "
+                "mean busy time)\n", imbalance);
+        fprintf(out, "=============================================================\n");
+        free(crit);
+        free(total);
+        free(v);
+    }
+
+    free(samples);
+    free(row);
+    samples     = NULL;
+    row         = NULL;
+    samples_cap = 0;
+}
@@ -0,0 +1,186 @@
+#include "pack.h"
+#include "grid.h"
+
+#include <string.h>
+
+#define TAG_TYPE_MASK  0x7Fu
+
+static WireQuant wire_quant = WIRE_DOUBLE;
+static uint64_t  wire_bytes[WIRE_PHASE_COUNT];
+
+void pack_set_quant(WireQuant q) {
+    wire_quant = q;
+}
+
+WireQuant pack_quant(void) {
+    return wire_quant;
+}
+
+int pack_parse_quant(const char *name) {
+    if (strcmp(name, "double") == 0)  return WIRE_DOUBLE;
+    if (strcmp(name, "float") == 0)   return WIRE_FLOAT;
+    if (strcmp(name, "fixed16") == 0) return WIRE_FIXED16;
+    return -1;
+}
+
+static size_t resource_bytes(void) {
+    switch (wire_quant) {
+        case WIRE_FLOAT:   return sizeof(float);
+        case WIRE_FIXED16: return sizeof(uint16_t);
+        default:           return sizeof(double);
+    }
+}
+
+size_t pack_cell_bytes(void) {
+    return 1 + resource_bytes();
+}
+
+/* Fração de max_resource em 16 bits (WIRE_FIXED16). */
+static uint16_t fixed16_of(const Cell *cell) {
+    double max  = cell->max_resource;
+    double frac = (max > 0.0) ? cell->resource / max : 0.0;
+    if (frac < 0.0) frac = 0.0;
+    if (frac > 1.0) frac = 1.0;
+    return (uint16_t)(frac * 65535.0 + 0.5);
+}
+
+size_t pack_cells(const Cell *base, int stride, int h, int w, void *buf) {
+    unsigned char *out = buf;
+
+    for (int r = 0; r < h; r++) {
+        const Cell *row = base + (size_t)r * stride;
+        for (int c = 0; c < w; c++) {
+            const Cell *cell = &row[c];
+            *out++ = (unsigned char)(cell->type & TAG_TYPE_MASK);
+            /* memcpy: o buffer é compacto, sem alinhamento garantido. */
+            if (wire_quant == WIRE_FLOAT) {
+                float v = (float)cell->resource;
+                memcpy(out, &v, sizeof(v));
+                out += sizeof(v);
+            } else if (wire_quant == WIRE_FIXED16) {
+                uint16_t q = fixed16_of(cell);
+                memcpy(out, &q, sizeof(q));
+                out += sizeof(q);
+            } else {
+                memcpy(out, &cell->resource, sizeof(double));
+                out += sizeof(double);
+            }
+        }
+    }
+    return (size_t)(out - (unsigned char *)buf);
+}
+
+size_t unpack_cells(Cell *base, int stride, int h, int w, const void *buf) {
+    const unsigned char *in = buf;
+
+    for (int r = 0; r < h; r++) {
+        Cell *row = base + (size_t)r * stride;
+        for (int c = 0; c < w; c++) {
+            Cell *cell = &row[c];
+            unsigned char tag = *in++;
+            cell->type         = (CellType)(tag & TAG_TYPE_MASK);
+            cell->max_resource = grid_max_resource(cell->type);
+            if (wire_quant == WIRE_FLOAT) {
+                float v;
+                memcpy(&v, in, sizeof(v));
+                in += sizeof(v);
+                cell->resource = v;
+            } else if (wire_quant == WIRE_FIXED16) {
+                uint16_t q;
+                memcpy(&q, in, sizeof(q));
+                in += sizeof(q);
+                cell->resource = (double)q / 65535.0 * cell->max_resource;
+            } else {
+                memcpy(&cell->resource, in, sizeof(double));
+                in += sizeof(double);
+            }
+        }
+    }
+    return (size_t)(in - (const unsigned char *)buf);
+}
+
+void pack_copy_cells(Cell *dst, int dstride, const Cell *src, int sstride,
+                     int h, int w) {
+    for (int r = 0; r < h; r++) {
+        Cell       *out = dst + (size_t)r * dstride;
+        const Cell *in  = src + (size_t)r * sstride;
+        if (wire_quant == WIRE_DOUBLE) {
+            memcpy(out, in, sizeof(Cell) * (size_t)w);
+            continue;
+        }
+        for (int c = 0; c < w; c++) {
+            CellType type = (CellType)(in[c].type & TAG_TYPE_MASK);
+            double   max  = grid_max_resource(type);
+            double   res  = (wire_quant == WIRE_FLOAT)
+                          ? (double)(float)in[c].resource
+                          : (double)fixed16_of(&in[c]) / 65535.0 * max;
+            out[c].type         = type;
+            out[c].max_resource = max;
+            out[c].resource     = res;
+        }
+    }
+}
+
+void pack_bytes_add(WirePhase ph, uint64_t bytes) {
+    wire_bytes[ph] += bytes;
+}
+
+void pack_bytes_reset(void) {
+    memset(wire_bytes, 0, sizeof(wire_bytes));
+}
+
+void pack_bytes_get(uint64_t out[WIRE_PHASE_COUNT]) {
+    memcpy(out, wire_bytes, sizeof(wire_bytes));
+}
+
+#ifdef USE_MPI
+
+#include <mpi.h>
+#include <stddef.h>
+
+static MPI_Datatype cell_type  = MPI_DATATYPE_NULL;
+static MPI_Datatype agent_type = MPI_DATATYPE_NULL;
+
+void pack_types_init(void) {
+    if (cell_type != MPI_DATATYPE_NULL) return;
+
+    /* Célula: tag (1 byte) + recurso logo em seguida, sem padding. */
+    MPI_Datatype res_t = (wire_quant == WIRE_FLOAT)   ? MPI_FLOAT
+                       : (wire_quant == WIRE_FIXED16) ? MPI_UINT16_T
+                       :                                MPI_DOUBLE;
+    int          cell_blocks[2] = {1, 1};
+    MPI_Aint     cell_offs[2]   = {0, 1};
+    MPI_Datatype cell_fields[2] = {MPI_UINT8_T, res_t};
+    MPI_Datatype tmp;
+    MPI_Type_create_struct(2, cell_blocks, cell_offs, cell_fields, &tmp);
+    MPI_Type_create_resized(tmp, 0, (MPI_Aint)pack_cell_bytes(), &cell_type);
+    MPI_Type_free(&tmp);
+    MPI_Type_commit(&cell_type);
+
+    int          ag_blocks[3] = {1, 1, 2};
+    MPI_Aint     ag_offs[3]   = {offsetof(WireAgent, id),
+                                 offsetof(WireAgent, energy),
+                                 offsetof(WireAgent, x)};
+    MPI_Datatype ag_fields[3] = {MPI_UINT64_T, MPI_FLOAT, MPI_UINT16_T};
+    MPI_Type_create_struct(3, ag_blocks, ag_offs, ag_fields, &tmp);
+    MPI_Type_create_resized(tmp, 0, (MPI_Aint)sizeof(WireAgent), &agent_type);
+    MPI_Type_free(&tmp);
+    MPI_Type_commit(&agent_type);
+}
+
+void pack_types_free(void) {
+    if (cell_type != MPI_DATATYPE_NULL)
+        MPI_Type_free(&cell_type);
+    if (agent_type != MPI_DATATYPE_NULL)
+        MPI_Type_free(&agent_type);
+}
+
+MPI_Datatype pack_cell_type(void) {
+    return cell_type;
+}
+
+MPI_Datatype pack_agent_type(void) {
+    return agent_type;
+}
+
+#endif /* USE_MPI */
@@ -7,6 +7,18 @@
 #include <mpi.h>
 #endif
 
+/* size = a * b com a <= b e |a - b| mínimo. */
+static void factor_ranks(int size, int *a, int *b) {
+    *a = 1;
+    *b = size;
+    for (int i = 1; i * i <= size; i++) {
+        if (size % i == 0 && abs(i - size / i) < abs(*a - *b)) {
+            *a = i;
+            *b = size / i;
+        }
+    }
+}
+
 #ifdef USE_MPI
 void partition_init(Partition *p, int global_w, int global_h,
                     MPI_Comm comm) {
@@ -20,17 +32,8 @@ void partition_init(Partition *p, int global_w, int global_h,
     p->rank = 0;
 #endif
 
-    int best_px = 1, best_py = p->size;
-    for (int i = 1; i * i <= p->size; i++) {
-        if (p->size % i == 0) {
-            int a = i;
-            int b = p->size / i;
-            if (abs(a - b) < abs(best_px - best_py)) {
-                best_px = a;
-                best_py = b;
-            }
-        }
-    }
+    int best_px, best_py;
+    factor_ranks(p->size, &best_px, &best_py);
 
     /*
      * px = colunas, py = linhas na grade de processos.
@@ -110,18 +113,61 @@ void partition_init(Partition *p, int global_w, int global_h,
 #endif
 }
 
-void partition_subgrid_dims(const Partition *p, int global_w, int global_h,
-                            int *local_w, int *local_h,
-                            int *offset_x, int *offset_y) {
+void partition_weak_dims(int size, int local_w, int local_h,
+                         int *global_w, int *global_h) {
+    int a, b;
+    factor_ranks(size, &a, &b);
+
+    /* partition_init põe o fator maior (b) nas colunas quando
+     * global_w >= global_h. Se b colunas de local_w não dão a grade mais
+     * larga, a orientação transposta é a consistente (b * local_w <
+     * a * local_h implica a * local_w < b * local_h). */
+    if ((long)b * local_w >= (long)a * local_h) {
+        *global_w = b * local_w;
+        *global_h = a * local_h;
+    } else {
+        *global_w = a * local_w;
+        *global_h = b * local_h;
+    }
+}
+
+static void block_dims(const Partition *p, int row, int col,
+                       int global_w, int global_h,
+                       int *local_w, int *local_h,
+                       int *offset_x, int *offset_y) {
     int base_w = global_w / p->px;
     int rem_w  = global_w % p->px;
     int base_h = global_h / p->py;
     int rem_h  = global_h % p->py;
 
-    *local_w  = (p->my_col == p->px - 1) ? base_w + rem_w : base_w;
-    *local_h  = (p->my_row == p->py - 1) ? base_h + rem_h : base_h;
-    *offset_x = p->my_col * base_w;
-    *offset_y = p->my_row * base_h;
+    *local_w  = (col == p->px - 1) ? base_w + rem_w : base_w;
+    *local_h  = (row == p->py - 1) ? base_h + rem_h : base_h;
+    *offset_x = col * base_w;
+    *offset_y = row * base_h;
+}
+
+void partition_subgrid_dims(const Partition *p, int global_w, int global_h,
+                            int *local_w, int *local_h,
+                            int *offset_x, int *offset_y) {
+    block_dims(p, p->my_row, p->my_col, global_w, global_h,
+               local_w, local_h, offset_x, offset_y);
+}
+
+void partition_rank_dims(const Partition *p, int rank,
+                         int global_w, int global_h,
+                         int *local_w, int *local_h,
+                         int *offset_x, int *offset_y) {
+    int row = 0, col = 0;
+#ifdef USE_MPI
+    int coords[2];
+    MPI_Cart_coords(p->cart_comm, rank, 2, coords);
+    row = coords[0];
+    col = coords[1];
+#else
+    (void)rank;
+#endif
+    block_dims(p, row, col, global_w, global_h,
+               local_w, local_h, offset_x, offset_y);
 }
 
 int partition_rank_for_global(const Partition *p, int gx, int gy,
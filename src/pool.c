@@ -0,0 +1,116 @@
+#include "pool.h"
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_MIN_CAPACITY 64
+
+static int words_for(int capacity) {
+    return (capacity + 63) / 64;
+}
+
+void pool_init(AgentPool *pool, int capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool_reserve(pool, capacity);
+}
+
+void pool_destroy(AgentPool *pool) {
+    if (!pool) return;
+    free(pool->id);
+    free(pool->x);
+    free(pool->y);
+    free(pool->energy);
+    free(pool->alive);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void pool_reserve(AgentPool *pool, int capacity) {
+    if (capacity <= pool->capacity) return;
+
+    int new_cap = pool->capacity ? pool->capacity : POOL_MIN_CAPACITY;
+    while (new_cap < capacity)
+        new_cap *= 2;
+
+    int old_words = words_for(pool->capacity);
+    int new_words = words_for(new_cap);
+
+    pool->id     = sim_realloc(pool->id,     sizeof(uint64_t) * (size_t)new_cap);
+    pool->x      = sim_realloc(pool->x,      sizeof(uint16_t) * (size_t)new_cap);
+    pool->y      = sim_realloc(pool->y,      sizeof(uint16_t) * (size_t)new_cap);
+    pool->energy = sim_realloc(pool->energy, sizeof(float)    * (size_t)new_cap);
+    pool->alive  = sim_realloc(pool->alive,  sizeof(uint64_t) * (size_t)new_words);
+
+    /* Slots além de count sempre têm bit 0. */
+    memset(pool->alive + old_words, 0,
+           sizeof(uint64_t) * (size_t)(new_words - old_words));
+    pool->capacity = new_cap;
+}
+
+int pool_push(AgentPool *pool, uint64_t id, int x, int y, float energy) {
+    if (pool->count >= pool->capacity)
+        pool_reserve(pool, pool->count + 1);
+
+    int i = pool->count++;
+    pool->id[i]     = id;
+    pool->x[i]      = (uint16_t)x;
+    pool->y[i]      = (uint16_t)y;
+    pool->energy[i] = energy;
+    pool->alive[i >> 6] |= 1ULL << (i & 63);
+    return i;
+}
+
+void pool_revive_range(AgentPool *pool, int lo, int hi) {
+    while (lo < hi) {
+        int w    = lo >> 6;
+        int bit  = lo & 63;
+        int span = 64 - bit;
+        if (span > hi - lo) span = hi - lo;
+        uint64_t mask = (span == 64) ? ~0ULL : ((1ULL << span) - 1) << bit;
+        pool->alive[w] |= mask;
+        lo += span;
+    }
+}
+
+int pool_live(const AgentPool *pool) {
+    int live = 0;
+    int nwords = words_for(pool->count);
+    for (int w = 0; w < nwords; w++)
+        live += __builtin_popcountll(pool->alive[w]);
+    return live;
+}
+
+void pool_compact(AgentPool *pool) {
+    int n = pool->count;
+    int write = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (!pool_alive(pool, i)) continue;
+        if (write != i) {
+            pool->id[write]     = pool->id[i];
+            pool->x[write]      = pool->x[i];
+            pool->y[write]      = pool->y[i];
+            pool->energy[write] = pool->energy[i];
+        }
+        write++;
+    }
+
+    /* Reconstrói o bitmask: slots [0, write) vivos, demais zerados. */
+    int nwords = words_for(n);
+    for (int w = 0; w < nwords; w++) {
+        int lo = w * 64;
+        if (lo + 64 <= write)
+            pool->alive[w] = ~0ULL;
+        else if (lo >= write)
+            pool->alive[w] = 0;
+        else
+            pool->alive[w] = (1ULL << (write - lo)) - 1;
+    }
+    pool->count = write;
+}
+
+void pool_maybe_compact(AgentPool *pool) {
+    int dead = pool->count - pool_live(pool);
+    if (dead > 0 && dead * 4 >= pool->count)
+        pool_compact(pool);
+}
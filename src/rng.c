@@ -33,3 +33,13 @@ uint64_t rng_cell_seed(uint64_t base_seed, int gx, int gy) {
     h ^= h << 17;
     return h ? h : 1;
 }
+
+uint64_t rng_agent_seed(uint64_t base_seed, uint64_t id, int cycle) {
+    /* Finalizador do splitmix64 sobre (seed, id, ciclo). */
+    uint64_t h = base_seed ^ (id * 0x9E3779B97F4A7C15ULL)
+                           ^ ((uint64_t)cycle * 0xC2B2AE3D27D4EB4FULL);
+    h ^= h >> 30;  h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;  h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h ? h : 1;
+}
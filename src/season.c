@@ -1,40 +1,113 @@
 #include "season.h"
+#include "config.h"
 
-Season season_for_cycle(int cycle, int season_length) {
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const names[SEASON_COUNT] = {
+    "dry", "wet", "rising", "falling"
+};
+
+/* Calendário corrente: padrão seca/chuva alternando. */
+static Season schedule_kind[SEASON_MAX_ENTRIES] = { DRY, WET };
+static int    schedule_end[SEASON_MAX_ENTRIES]  = {
+    DEFAULT_SEASON_LENGTH, 2 * DEFAULT_SEASON_LENGTH
+};
+static int    schedule_len = 2;
+
+int season_schedule_set(const char *spec, int default_length) {
+    Season kind[SEASON_MAX_ENTRIES];
+    int    end[SEASON_MAX_ENTRIES];
+    int    n = 0, total = 0;
+    char   buf[256];
+
+    if (default_length <= 0 || strlen(spec) >= sizeof(buf))
+        return -1;
+    strcpy(buf, spec);
+
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        if (n == SEASON_MAX_ENTRIES) return -1;
+        int   len   = default_length;
+        char *colon = strchr(tok, ':');
+        if (colon) {
+            *colon = '\0';
+            len = atoi(colon + 1);
+        }
+        int s = season_parse(tok);
+        if (s < 0 || len <= 0) return -1;
+        total  += len;
+        kind[n] = (Season)s;
+        end[n]  = total;
+        n++;
+    }
+    if (n == 0) return -1;
+
+    memcpy(schedule_kind, kind, sizeof(Season) * (size_t)n);
+    memcpy(schedule_end, end, sizeof(int) * (size_t)n);
+    schedule_len = n;
+    return 0;
+}
+
+Season season_for_cycle(int cycle) {
     /*
-     * Estações alternam a cada season_length ciclos.
-     * Divisão inteira dá o índice da época: par = DRY, ímpar = WET.
+     * O calendário se repete a cada período (soma das durações); a
+     * estação é a primeira entrada cujo fim passa da posição no período.
      */
-    return ((cycle / season_length) % 2 == 0) ? DRY : WET;
+    int t = cycle % schedule_end[schedule_len - 1];
+    int i = 0;
+    while (t >= schedule_end[i])
+        i++;
+    return schedule_kind[i];
+}
+
+const char *season_name(Season s) {
+    return names[s];
+}
+
+int season_parse(const char *name) {
+    for (int s = 0; s < SEASON_COUNT; s++)
+        if (strcmp(name, names[s]) == 0)
+            return s;
+    return -1;
 }
 
 int season_accessibility(CellType type, Season s) {
-    switch (type) {
-        case ALDEIA:      return 1;         /* aldeia — sempre acessível */
-        case PESCA:       return s == DRY;  /* pesca — só na seca */
-        case COLETA:      return 1;         /* coleta — sempre acessível */
-        case ROCADO:      return s == WET;  /* roçado — só na chuva */
-        case INTERDITADA: return 0;         /* interditada — nunca */
-    }
-    return 0;
+    /*
+     * Acessibilidade (seca / chuva / enchente / vazante):
+     *   ALDEIA      sim / sim / sim / sim
+     *   PESCA       sim / não / não / sim  (peixe concentrado na água baixa)
+     *   COLETA      sim / sim / sim / sim
+     *   ROCADO      não / sim / sim / não
+     *   INTERDITADA não / não / não / não
+     */
+    static const unsigned char access[CELL_TYPES][SEASON_COUNT] = {
+        /* DRY WET RIS FAL */
+        { 1,  1,  1,  1 },   /* ALDEIA */
+        { 1,  0,  0,  1 },   /* PESCA  */
+        { 1,  1,  1,  1 },   /* COLETA */
+        { 0,  1,  1,  0 },   /* ROCADO */
+        { 0,  0,  0,  0 },   /* INTERDITADA */
+    };
+    return access[type][s];
 }
 
 double season_regen_rate(CellType type, Season s) {
     /*
-     * Taxas de regeneração (seca / chuva):
-     *   ALDEIA      0.0 / 0.0   (sem regeneração natural)
-     *   PESCA       0.03 / 0.01  (peixes prosperam na seca)
-     *   COLETA      0.01 / 0.03  (coleta melhora na chuva)
-     *   ROCADO      0.02 / 0.04  (roçado beneficia da chuva)
-     *   INTERDITADA 0.0 / 0.0   (sem regeneração)
+     * Taxas de regeneração (seca / chuva / enchente / vazante):
+     *   ALDEIA      0.0 / 0.0 / 0.0 / 0.0     (sem regeneração natural)
+     *   PESCA       0.03 / 0.01 / 0.015 / 0.025  (peixes prosperam na seca)
+     *   COLETA      0.01 / 0.03 / 0.025 / 0.015  (coleta melhora na chuva)
+     *   ROCADO      0.02 / 0.04 / 0.035 / 0.025  (roçado beneficia da chuva)
+     *   INTERDITADA 0.0 / 0.0 / 0.0 / 0.0     (sem regeneração)
+     * As estações de transição ficam entre seca e chuva.
      */
-    static const double rates[5][2] = {
-        /* DRY    WET */
-        { 0.00,  0.00 },   /* ALDEIA */
-        { 0.03,  0.01 },   /* PESCA  (was 0.3, 0.1) */
-        { 0.01,  0.03 },   /* COLETA (was 0.1, 0.3) */
-        { 0.02,  0.04 },   /* ROCADO (was 0.2, 0.4) */
-        { 0.00,  0.00 },   /* INTERDITADA */
+    static const double rates[CELL_TYPES][SEASON_COUNT] = {
+        /* DRY    WET    RISING  FALLING */
+        { 0.00,  0.00,  0.000,  0.000 },   /* ALDEIA */
+        { 0.03,  0.01,  0.015,  0.025 },   /* PESCA  (was 0.3, 0.1) */
+        { 0.01,  0.03,  0.025,  0.015 },   /* COLETA (was 0.1, 0.3) */
+        { 0.02,  0.04,  0.035,  0.025 },   /* ROCADO (was 0.2, 0.4) */
+        { 0.00,  0.00,  0.000,  0.000 },   /* INTERDITADA */
     };
     return rates[type][s];
 }
@@ -0,0 +1,205 @@
+#include "taskgraph.h"
+#include "agent.h"
+#include "grid.h"
+#include "pool.h"
+#include "rng.h"
+#include "trace.h"
+#include "workload.h"
+
+#include <string.h>
+
+/* Geometria dos tiles sobre o array com halo. */
+typedef struct {
+    int size;       /* lado do tile em células */
+    int ntx, nty;   /* tiles por linha / coluna */
+} Tiling;
+
+static int tile_of_cell(const Tiling *tg, int r, int c) {
+    return (r / tg->size) * tg->ntx + c / tg->size;
+}
+
+/* Até 9 tiles (o próprio e os vizinhos existentes); retorna quantos. */
+static int tile_neighbors(const Tiling *tg, int t, int out[9]) {
+    int ty = t / tg->ntx, tx = t % tg->ntx, k = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int y = ty + dy, x = tx + dx;
+            if (y < 0 || y >= tg->nty || x < 0 || x >= tg->ntx) continue;
+            out[k++] = y * tg->ntx + x;
+        }
+    }
+    return k;
+}
+
+/* Mesmos 9 tiles, repetindo o próprio no lugar dos inexistentes
+ * (lista fixa para as cláusulas depend). */
+static void tile_dep_list(const Tiling *tg, int t, int out[9]) {
+    int nb[9];
+    int k = tile_neighbors(tg, t, nb);
+    for (int j = 0; j < 9; j++)
+        out[j] = (j < k) ? nb[j] : t;
+}
+
+uint64_t *taskgraph_step(AgentPool *pool, SubGrid *sg, Season season,
+                         const SimConfig *cfg, int cycle, Arena *arena) {
+    Tiling tg;
+    tg.size = cfg->tile_size;
+    tg.ntx  = (sg->halo_w + tg.size - 1) / tg.size;
+    tg.nty  = (sg->halo_h + tg.size - 1) / tg.size;
+    const int ntiles = tg.ntx * tg.nty;
+    const int ncells = sg->halo_w * sg->halo_h;
+    const int n      = pool->count;
+
+    /* Agentes vivos agrupados pelo tile da posição atual. */
+    int *tstart = arena_calloc(arena, (size_t)ntiles + 1, sizeof(int));
+    int *tile_of = arena_alloc(arena, sizeof(int) * (size_t)(n > 0 ? n : 1));
+    for (int i = 0; i < n; i++) {
+        tile_of[i] = -1;
+        if (!pool_alive(pool, i)) continue;
+        tile_of[i] = tile_of_cell(&tg, pool->y[i], pool->x[i]);
+        tstart[tile_of[i] + 1]++;
+    }
+    for (int t = 0; t < ntiles; t++)
+        tstart[t + 1] += tstart[t];
+    int *tlist = arena_alloc(arena, sizeof(int) *
+                             (size_t)(tstart[ntiles] > 0 ? tstart[ntiles] : 1));
+    {
+        int *fill = arena_alloc(arena, sizeof(int) * (size_t)ntiles);
+        memcpy(fill, tstart, sizeof(int) * (size_t)ntiles);
+        for (int i = 0; i < n; i++)
+            if (tile_of[i] >= 0) tlist[fill[tile_of[i]]++] = i;
+    }
+
+    /* Segmento de consumidores de cada tile: cabe todo agente dos 9 tiles. */
+    int *seg_off = arena_alloc(arena, sizeof(int) * (size_t)(ntiles + 1));
+    seg_off[0] = 0;
+    for (int t = 0; t < ntiles; t++) {
+        int nb[9], k = tile_neighbors(&tg, t, nb), cnt = 0;
+        for (int j = 0; j < k; j++)
+            cnt += tstart[nb[j] + 1] - tstart[nb[j]];
+        seg_off[t + 1] = seg_off[t] + cnt;
+    }
+    int *order  = arena_alloc(arena, sizeof(int) *
+                              (size_t)(seg_off[ntiles] > 0 ? seg_off[ntiles] : 1));
+    int *dest   = arena_alloc(arena, sizeof(int) * (size_t)(n > 0 ? n : 1));
+    uint64_t *kid = arena_calloc(arena, (size_t)(n > 0 ? n : 1),
+                                 sizeof(uint64_t));
+    int *cnt    = arena_alloc(arena, sizeof(int) * (size_t)ncells);
+    int *pos    = arena_alloc(arena, sizeof(int) * (size_t)ncells);
+
+    /* Sentinelas de dependência: células e agentes de cada tile. */
+    char *cdep = arena_calloc(arena, (size_t)ntiles, 1);
+    char *adep = arena_calloc(arena, (size_t)ntiles, 1);
+    (void)cdep;  /* só aparecem em cláusulas depend (GCC avisa unused) */
+    (void)adep;
+
+    const int    max_workload = cfg->max_workload;
+    const uint64_t seed       = cfg->seed;
+    const double gain         = cfg->energy_gain;
+    const double loss         = cfg->energy_loss;
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        for (int t = 0; t < ntiles; t++) {
+            #pragma omp task firstprivate(t) \
+                depend(in: cdep[t]) depend(in: adep[t])
+            TRACE_SCOPE(TR_WORKLOAD) {
+                for (int k = tstart[t]; k < tstart[t + 1]; k++) {
+                    int i = tlist[k];
+                    if (subgrid_interior(sg, pool->x[i], pool->y[i]))
+                        workload_compute(sg->cells[CELL_AT(sg, pool->y[i],
+                                                   pool->x[i])].resource,
+                                         max_workload);
+                }
+            }
+        }
+
+        for (int t = 0; t < ntiles; t++) {
+            int d[9];
+            tile_dep_list(&tg, t, d);
+            #pragma omp task firstprivate(t) depend(inout: adep[t]) \
+                depend(in: cdep[d[0]], cdep[d[1]], cdep[d[2]], cdep[d[3]], \
+                           cdep[d[4]], cdep[d[5]], cdep[d[6]], cdep[d[7]], \
+                           cdep[d[8]])
+            TRACE_SCOPE(TR_DECIDE) {
+                for (int k = tstart[t]; k < tstart[t + 1]; k++) {
+                    int i = tlist[k];
+                    RngState rng = rng_seed(rng_agent_seed(seed, pool->id[i],
+                                                           cycle));
+                    dest[i] = agent_decide(pool, i, sg, &rng);
+                }
+            }
+        }
+
+        for (int t = 0; t < ntiles; t++) {
+            int d[9];
+            tile_dep_list(&tg, t, d);
+            #pragma omp task firstprivate(t) depend(inout: cdep[t]) \
+                depend(in: adep[d[0]], adep[d[1]], adep[d[2]], adep[d[3]], \
+                           adep[d[4]], adep[d[5]], adep[d[6]], adep[d[7]], \
+                           adep[d[8]])
+            TRACE_SCOPE(TR_DECIDE) {
+                int r0 = (t / tg.ntx) * tg.size, c0 = (t % tg.ntx) * tg.size;
+                int r1 = r0 + tg.size, c1 = c0 + tg.size;
+                if (r1 > sg->halo_h) r1 = sg->halo_h;
+                if (c1 > sg->halo_w) c1 = sg->halo_w;
+
+                int nb[9], nn = tile_neighbors(&tg, t, nb);
+                for (int r = r0; r < r1; r++)
+                    for (int c = c0; c < c1; c++)
+                        cnt[CELL_AT(sg, r, c)] = 0;
+
+                /* Counting sort local, por agent_bucket, dos agentes dos 9 tiles. */
+                for (int j = 0; j < nn; j++)
+                    for (int k = tstart[nb[j]]; k < tstart[nb[j] + 1]; k++) {
+                        int c = agent_bucket(dest[tlist[k]]);
+                        if (c >= 0 && tile_of_cell(&tg, c / sg->halo_w,
+                                                   c % sg->halo_w) == t)
+                            cnt[c]++;
+                    }
+                int *seg = &order[seg_off[t]], off = 0;
+                for (int r = r0; r < r1; r++)
+                    for (int c = c0; c < c1; c++) {
+                        int idx = CELL_AT(sg, r, c);
+                        pos[idx] = off;
+                        off += cnt[idx];
+                    }
+                for (int j = 0; j < nn; j++)
+                    for (int k = tstart[nb[j]]; k < tstart[nb[j] + 1]; k++) {
+                        int i = tlist[k], c = agent_bucket(dest[i]);
+                        if (c >= 0 && tile_of_cell(&tg, c / sg->halo_w,
+                                                   c % sg->halo_w) == t)
+                            seg[pos[c]++] = i;
+                    }
+
+                /* pos[idx] agora aponta para o fim do bucket da célula. */
+                for (int r = r0; r < r1; r++)
+                    for (int c = c0; c < c1; c++) {
+                        int idx = CELL_AT(sg, r, c);
+                        if (cnt[idx] == 0) continue;
+                        agents_consume_cell(pool, &sg->cells[idx],
+                                            subgrid_accessible(sg, idx),
+                                            &seg[pos[idx] - cnt[idx]],
+                                            cnt[idx], dest, gain, loss, kid,
+                                            agent_birth_id(sg, idx, cycle));
+                    }
+            }
+        }
+
+        for (int t = 0; t < ntiles; t++) {
+            #pragma omp task firstprivate(t) depend(inout: cdep[t])
+            TRACE_SCOPE(TR_GRID) {
+                int r0 = (t / tg.ntx) * tg.size, c0 = (t % tg.ntx) * tg.size;
+                int r1 = r0 + tg.size - 1,       c1 = c0 + tg.size - 1;
+                if (r0 < sg->box_r0) r0 = sg->box_r0;
+                if (r1 > sg->box_r1) r1 = sg->box_r1;
+                if (c0 < sg->box_c0) c0 = sg->box_c0;
+                if (c1 > sg->box_c1) c1 = sg->box_c1;
+                for (int r = r0; r <= r1 && c0 <= c1; r++)
+                    subgrid_update_span(sg, season, r, c0, c1);
+            }
+        }
+    }
+    return kid;
+}
@@ -0,0 +1,242 @@
+#include "trace.h"
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Evento no anel e no fio (o rank vem do remetente). */
+typedef struct {
+    double  t0, t1;       /* segundos desde a origem do rank */
+    int32_t phase;
+    int32_t tid;
+    int32_t cycle;
+    int32_t pad;
+} TraceEvent;
+
+typedef struct {
+    TraceEvent ev[TRACE_RING_EVENTS];
+    uint64_t   head;      /* eventos já gravados        */
+    uint64_t   flushed;   /* eventos já enviados/perdidos */
+} TraceRing;
+
+int trace_enabled = 0;
+
+static TraceRing **rings;
+static int         nrings;
+static int         team;       /* omp_get_max_threads() na partida */
+static long long   lost;
+static double      base;
+static int         cur_cycle;
+
+double trace_clock(void) {
+#if defined(_OPENMP)
+    return omp_get_wtime() - base;
+#elif defined(USE_MPI)
+    return MPI_Wtime() - base;
+#else
+    return 0.0;
+#endif
+}
+
+void trace_set_cycle(int cycle) {
+    cur_cycle = cycle;
+}
+
+/*
+ * Anel da thread chamadora: o número da thread na equipe do primeiro
+ * nível ativo, ou team + número na equipe aninhada (--comm-thread). A
+ * região inativa em volta do laço de ciclos não conta como nível. Só uma
+ * equipe aninhada existe por vez, então cada anel tem um único escritor
+ * mesmo que o runtime troque as threads do sistema entre regiões.
+ */
+static int ring_of_thread(void) {
+#ifdef _OPENMP
+    int tid = omp_get_thread_num();
+    return omp_get_active_level() <= 1 ? tid : team + tid;
+#else
+    return 0;
+#endif
+}
+
+void trace_record(TracePhase ph, double t0) {
+    int r = ring_of_thread();
+    if (r >= nrings) {
+        /* Equipe maior que a prevista: o evento é descartado. */
+        __atomic_fetch_add(&lost, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    TraceRing  *ring = rings[r];
+    TraceEvent *e    = &ring->ev[ring->head % TRACE_RING_EVENTS];
+    e->t0    = t0;
+    e->t1    = trace_clock();
+    e->phase = (int32_t)ph;
+    e->tid   = r;
+    e->cycle = cur_cycle;
+    ring->head++;
+}
+
+#ifdef USE_MPI
+
+static const char *const phase_names[TR_PHASES] = {
+    "cycle", "season", "halo", "workload", "lpt_plan", "decide",
+    "reproduce", "migrate", "grid", "metrics", "reduce", "output",
+    "tasks", "autotune", "mpi_wait"
+};
+
+static FILE       *out;
+static int         first_event = 1;
+static TraceEvent *stage;        /* eventos locais a enviar  */
+static size_t      stage_cap;
+static TraceEvent *gathered;     /* rank 0: todos os ranks   */
+static size_t      gathered_cap;
+static int        *counts;       /* rank 0: bytes e deslocamentos por rank */
+
+static void *grow(void *p, size_t *cap, size_t need) {
+    if (need <= *cap) return p;
+    size_t n = *cap ? *cap : 1024;
+    while (n < need) n *= 2;
+    *cap = n;
+    return sim_realloc(p, n * sizeof(TraceEvent));
+}
+
+int trace_init(const char *path, MPI_Comm comm) {
+    int rank, size, ok = 1;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    if (rank == 0) {
+        out = fopen(path, "w");
+        ok  = out != NULL;
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, comm);
+    if (!ok) return -1;
+
+    team = 1;
+#ifdef _OPENMP
+    team = omp_get_max_threads();
+#endif
+    /* Uma equipe de primeiro nível e uma aninhada. */
+    nrings = 2 * team;
+    if (nrings > TRACE_MAX_THREADS) nrings = TRACE_MAX_THREADS;
+    rings  = sim_calloc((size_t)nrings, sizeof(*rings));
+    for (int r = 0; r < nrings; r++)
+        rings[r] = sim_calloc(1, sizeof(TraceRing));
+    lost = 0;
+
+    if (rank == 0) {
+        counts = sim_malloc(sizeof(int) * 2 * (size_t)size);
+        fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for (int r = 0; r < size; r++) {
+            fprintf(out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                    "\"args\":{\"name\":\"rank %d\"}}", r ? ",\n" : "", r, r);
+        }
+        first_event = 0;
+    }
+
+    /* Origem comum: todos os ranks saem da barreira juntos. */
+    MPI_Barrier(comm);
+    base = 0.0;
+    base = trace_clock();
+    trace_enabled = 1;
+    return 0;
+}
+
+void trace_flush(MPI_Comm comm) {
+    if (!trace_enabled) return;
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    /* Eventos pendentes de cada anel; o excesso sobre a capacidade
+     * foi sobrescrito. */
+    size_t n = 0;
+    for (int r = 0; r < nrings; r++) {
+        TraceRing *ring = rings[r];
+        if (ring->head - ring->flushed > TRACE_RING_EVENTS) {
+            lost += (long long)(ring->head - ring->flushed - TRACE_RING_EVENTS);
+            ring->flushed = ring->head - TRACE_RING_EVENTS;
+        }
+        n += (size_t)(ring->head - ring->flushed);
+    }
+    stage = grow(stage, &stage_cap, n);
+    n = 0;
+    for (int r = 0; r < nrings; r++) {
+        TraceRing *ring = rings[r];
+        for (uint64_t k = ring->flushed; k < ring->head; k++)
+            stage[n++] = ring->ev[k % TRACE_RING_EVENTS];
+        ring->flushed = ring->head;
+    }
+
+    int  bytes  = (int)(n * sizeof(TraceEvent));
+    int *displs = counts ? counts + size : NULL;
+    MPI_Gather(&bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+
+    size_t total = 0;
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            displs[r] = (int)total;
+            total    += (size_t)counts[r];
+        }
+        gathered = grow(gathered, &gathered_cap,
+                        total / sizeof(TraceEvent) + 1);
+    }
+    MPI_Gatherv(stage, bytes, MPI_BYTE,
+                gathered, counts, displs, MPI_BYTE, 0, comm);
+
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            const TraceEvent *ev = gathered + displs[r] / (int)sizeof(TraceEvent);
+            int m = counts[r] / (int)sizeof(TraceEvent);
+            for (int k = 0; k < m; k++) {
+                fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,"
+                        "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"args\":{\"cycle\":%d}}",
+                        first_event ? "" : ",\n",
+                        phase_names[ev[k].phase], r, ev[k].tid,
+                        ev[k].t0 * 1e6, (ev[k].t1 - ev[k].t0) * 1e6,
+                        ev[k].cycle);
+                first_event = 0;
+            }
+        }
+        fflush(out);
+    }
+}
+
+long long trace_finalize(MPI_Comm comm) {
+    if (!trace_enabled) return 0;
+
+    trace_flush(comm);
+    trace_enabled = 0;
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    long long total_lost = 0;
+    MPI_Reduce(&lost, &total_lost, 1, MPI_LONG_LONG, MPI_SUM, 0, comm);
+
+    if (rank == 0) {
+        fprintf(out, "\n]}\n");
+        fclose(out);
+        out = NULL;
+    }
+    for (int r = 0; r < nrings; r++)
+        free(rings[r]);
+    free(rings);
+    free(stage);
+    free(gathered);
+    free(counts);
+    rings  = NULL;
+    counts = NULL;
+    stage = gathered = NULL;
+    nrings = 0;
+    stage_cap = gathered_cap = 0;
+    return total_lost;
+}
+
+#endif /* USE_MPI */
@@ -1,4 +1,10 @@
 #include "tui.h"
+#include "commmat.h"
+#include "grid.h"
+#include "pack.h"
+#include "partition.h"
+#include "pool.h"
+#include "season.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -151,8 +157,11 @@ int tui_poll_input(TuiControl *ctrl) {
     return 0;
 }
 
-static const char *season_name(Season s) {
-    return s == DRY ? "DRY" : "WET";
+static const char *season_label(Season s) {
+    static const char *const labels[SEASON_COUNT] = {
+        "DRY", "WET", "RISING", "FALLING"
+    };
+    return labels[s];
 }
 
 static const char *cell_bg256(CellType t, double resource, double max_resource) {
@@ -251,7 +260,7 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
                 Agent *all_agents, int total_agents,
                 int cycle, int total_cycles,
                 Season season, SimMetrics *metrics,
-                CyclePerf *perf, TuiControl *ctrl)
+                CyclePerf *perf, TuiControl *ctrl, Arena *arena)
 {
     /* Compute downsampling step if grid is too large */
     int step_x = 1, step_y = 1;
@@ -265,15 +274,13 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
     int grid_tcols = display_w * 2;
 
     /* Mapa de presença de agentes para lookup O(1) durante a renderização. */
-    int *agent_map = calloc((size_t)global_w * (size_t)global_h, sizeof(int));
-    if (agent_map) {
-        for (int i = 0; i < total_agents; i++) {
-            if (!all_agents[i].alive) continue;
-            int gx = all_agents[i].gx;
-            int gy = all_agents[i].gy;
-            if (gx >= 0 && gx < global_w && gy >= 0 && gy < global_h)
-                agent_map[gy * global_w + gx] = 1;
-        }
+    unsigned char *agent_map = arena_calloc(arena,
+                                            (size_t)global_w * (size_t)global_h, 1);
+    for (int i = 0; i < total_agents; i++) {
+        int gx = all_agents[i].gx;
+        int gy = all_agents[i].gy;
+        if (gx >= 0 && gx < global_w && gy >= 0 && gy < global_h)
+            agent_map[gy * global_w + gx] = 1;
     }
 
     #define MAX_RPANEL_LINES 28
@@ -297,6 +304,7 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
         double ht_ms = perf->halo_time     * 1000.0;
         double wl_ms = perf->workload_time * 1000.0;
         double ag_ms = perf->agent_time    * 1000.0;
+        double rp_ms = perf->reproduce_time * 1000.0;
         double gr_ms = perf->grid_time     * 1000.0;
         double mt_ms = perf->migrate_time  * 1000.0;
         double me_ms = perf->metrics_time  * 1000.0;
@@ -314,6 +322,7 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Halo:    ", ht_ms);
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Workload:", wl_ms);
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Agent:   ", ag_ms);
+        PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Reprod.: ", rp_ms);
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Grid:    ", gr_ms);
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Migrate: ", mt_ms);
         PHASE_LINE("\xe2\x94\x9c\xe2\x94\x80 Metrics: ", me_ms);
@@ -356,7 +365,7 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
 
         int alive = metrics ? metrics->alive_agents : total_agents;
         snprintf(tmp, sizeof(tmp), " Season: %-3s  Agents: %d",
-                 season_name(season), alive);
+                 season_label(season), alive);
         format_box_line(rpanel[rcount++], 256, tmp, inner_w);
 
         if (metrics) {
@@ -409,7 +418,7 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
         char grid_top[256];
         char grid_title[64];
         snprintf(grid_title, sizeof(grid_title), "Grid [Cycle %d/%d %s]",
-                 cycle, total_cycles, season_name(season));
+                 cycle, total_cycles, season_label(season));
         format_box_top(grid_top, sizeof(grid_top), grid_title, grid_tcols);
         fprintf(out, "%s", grid_top);
         if (rcount > 0)
@@ -427,11 +436,9 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
             int gx = dx * step_x;
             Cell *c = &full_grid[gy * global_w + gx];
 
-            int has_agent = 0;
-            if (agent_map)
-                has_agent = agent_map[gy * global_w + gx];
+            int has_agent = agent_map[gy * global_w + gx];
 
-            if (!c->accessible) {
+            if (!season_accessibility(c->type, season)) {
                 fprintf(out, BG_INACCESSIBLE "\033[38;5;242m" MIDDLE_DOT MIDDLE_DOT ANSI_RESET);
             } else if (has_agent) {
                 const char *bg = cell_bg256(c->type, c->resource, c->max_resource);
@@ -491,126 +498,146 @@ void tui_render(Cell *full_grid, int global_w, int global_h,
     } else {
         fflush(out);
     }
-
-    free(agent_map);
 }
 
 #ifdef USE_MPI
 
 void tui_gather_grid(SubGrid *sg, Partition *p,
                      Cell *full_grid, int global_w, int global_h,
-                     MPI_Comm comm)
+                     MPI_Comm comm, Arena *arena)
 {
     int rank, size;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &size);
 
     /*
-     * Each rank packs its interior cells (no halos) into a contiguous
-     * send buffer.  Interior cells are at rows [1..local_h], cols [1..local_w]
-     * in the halo-padded array.
+     * Each rank packs its interior cells (no halos) into the compact
+     * wire format.  Interior cells are at rows [1..local_h],
+     * cols [1..local_w] in the halo-padded array.
      */
     int owned = sg->local_w * sg->local_h;
-    Cell *send_buf = malloc(sizeof(Cell) * (size_t)owned);
-    for (int r = 0; r < sg->local_h; r++) {
-        for (int c = 0; c < sg->local_w; c++) {
-            send_buf[r * sg->local_w + c] =
-                sg->cells[CELL_AT(sg, r + 1, c + 1)];
-        }
+    const size_t cell_bytes = pack_cell_bytes();
+    void *send_buf = arena_alloc(arena, cell_bytes * (size_t)owned);
+    size_t bytes = pack_cells(&sg->cells[CELL_AT(sg, sg->halo, sg->halo)], sg->halo_w,
+                              sg->local_h, sg->local_w, send_buf);
+    if (rank != 0) {
+        pack_bytes_add(WIRE_PHASE_GATHER, bytes);
+        commmat_send(WIRE_PHASE_GATHER, 0, bytes);
     }
 
     /*
-     * Rank 0 receives all chunks.  We use MPI_Gather with a byte-level
-     * count since Cell may have padding and we want exact copies.
-     *
-     * All subgrids have the same dimensions (assuming evenly divisible
-     * grid), so MPI_Gather with uniform counts works.
+     * Rank 0 receives every chunk.  Subgrid sizes differ when the grid
+     * does not divide evenly, so counts/displacements come from each
+     * rank's block in the Cartesian decomposition.
      */
-    int cell_bytes = (int)sizeof(Cell);
-    Cell *recv_buf = NULL;
+    int  *counts   = NULL;
+    int  *displs   = NULL;
+    void *recv_buf = NULL;
     if (rank == 0) {
-        recv_buf = malloc(sizeof(Cell) * (size_t)global_w * (size_t)global_h);
+        counts = arena_alloc(arena, sizeof(int) * (size_t)size);
+        displs = arena_alloc(arena, sizeof(int) * (size_t)size);
+        int total = 0;
+        for (int r = 0; r < size; r++) {
+            int lw, lh, ox, oy;
+            partition_rank_dims(p, r, global_w, global_h, &lw, &lh, &ox, &oy);
+            counts[r] = lw * lh;
+            displs[r] = total;
+            total    += counts[r];
+        }
+        recv_buf = arena_alloc(arena, cell_bytes * (size_t)total);
     }
 
-    MPI_Gather(send_buf, owned * cell_bytes, MPI_BYTE,
-               recv_buf, owned * cell_bytes, MPI_BYTE,
-               0, comm);
+    MPI_Gatherv(send_buf, owned, pack_cell_type(),
+                recv_buf, counts, displs, pack_cell_type(),
+                0, comm);
 
-    /*
-     * On rank 0: reorder from rank-order to spatial (row-major) layout.
-     * Rank r owns the block at grid position (r % px, r / px) in the
-     * partition's Cartesian decomposition.
-     */
+    /* On rank 0: unpack each chunk straight into its spatial block. */
     if (rank == 0) {
-        int local_w = sg->local_w;
-        int local_h = sg->local_h;
-
         for (int r = 0; r < size; r++) {
-            int col_in_grid = r % p->px;
-            int row_in_grid = r / p->px;
-            int origin_x = col_in_grid * local_w;
-            int origin_y = row_in_grid * local_h;
-
-            Cell *chunk = &recv_buf[r * owned];
-
-            for (int lr = 0; lr < local_h; lr++) {
-                for (int lc = 0; lc < local_w; lc++) {
-                    int gy = origin_y + lr;
-                    int gx = origin_x + lc;
-                    if (gy < global_h && gx < global_w) {
-                        full_grid[gy * global_w + gx] =
-                            chunk[lr * local_w + lc];
-                    }
-                }
-            }
+            int lw, lh, ox, oy;
+            partition_rank_dims(p, r, global_w, global_h, &lw, &lh, &ox, &oy);
+            unpack_cells(&full_grid[(size_t)oy * global_w + ox], global_w,
+                         lh, lw,
+                         (char *)recv_buf + cell_bytes * (size_t)displs[r]);
         }
-        free(recv_buf);
     }
-
-    free(send_buf);
 }
 
-void tui_gather_agents(Agent *local_agents, int local_count,
+void tui_gather_agents(const AgentPool *pool, const SubGrid *sg,
+                       const Partition *p, int global_w, int global_h,
                        Agent **all_agents, int *total_count,
-                       MPI_Comm comm)
+                       MPI_Comm comm, Arena *arena)
 {
     int rank, size;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &size);
 
+    /* Agentes vivos do interior no fio, relativos à origem do interior
+     * (fantasmas do halo profundo ficam com o dono). */
+    int live = pool_live(pool);
+    WireAgent *local_agents = arena_alloc(arena, sizeof(WireAgent) *
+                                          (size_t)(live > 0 ? live : 1));
+    int local_count = 0;
+    for (int i = 0; i < pool->count; i++) {
+        if (!pool_alive(pool, i)) continue;
+        if (!subgrid_interior(sg, pool->x[i], pool->y[i])) continue;
+        WireAgent *a = &local_agents[local_count++];
+        a->id     = pool->id[i];
+        a->energy = pool->energy[i];
+        a->x      = (uint16_t)(pool->x[i] - sg->halo);
+        a->y      = (uint16_t)(pool->y[i] - sg->halo);
+    }
+    if (rank != 0) {
+        pack_bytes_add(WIRE_PHASE_GATHER, sizeof(int) +
+                       sizeof(WireAgent) * (uint64_t)local_count);
+        commmat_send(WIRE_PHASE_GATHER, 0, sizeof(int));
+        if (local_count > 0)
+            commmat_send(WIRE_PHASE_GATHER, 0,
+                         sizeof(WireAgent) * (uint64_t)local_count);
+    }
+
     int *counts = NULL;
     if (rank == 0) {
-        counts = malloc(sizeof(int) * (size_t)size);
+        counts = arena_alloc(arena, sizeof(int) * (size_t)size);
     }
     MPI_Gather(&local_count, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
 
     int *displs = NULL;
+    WireAgent *recv_buf = NULL;
     int total = 0;
-    int agent_bytes = (int)sizeof(Agent);
 
     if (rank == 0) {
-        displs = malloc(sizeof(int) * (size_t)size);
+        displs = arena_alloc(arena, sizeof(int) * (size_t)size);
         for (int i = 0; i < size; i++) {
             displs[i] = total;
             total += counts[i];
         }
-        *total_count = total;
-        *all_agents = malloc(sizeof(Agent) * (size_t)(total > 0 ? total : 1));
-
-        for (int i = 0; i < size; i++) {
-            counts[i] *= agent_bytes;
-            displs[i] *= agent_bytes;
-        }
+        recv_buf = arena_alloc(arena, sizeof(WireAgent) *
+                               (size_t)(total > 0 ? total : 1));
     }
 
-    MPI_Gatherv(local_agents, local_count * agent_bytes, MPI_BYTE,
-                rank == 0 ? *all_agents : NULL,
-                counts, displs, MPI_BYTE,
+    MPI_Gatherv(local_agents, local_count, pack_agent_type(),
+                recv_buf, counts, displs, pack_agent_type(),
                 0, comm);
 
     if (rank == 0) {
-        free(counts);
-        free(displs);
+        /* Converte para coordenadas globais com a origem de cada rank. */
+        Agent *out = arena_alloc(arena, sizeof(Agent) *
+                                 (size_t)(total > 0 ? total : 1));
+        for (int r = 0; r < size; r++) {
+            int lw, lh, ox, oy;
+            partition_rank_dims(p, r, global_w, global_h, &lw, &lh, &ox, &oy);
+            for (int j = displs[r]; j < displs[r] + counts[r]; j++) {
+                out[j].id     = recv_buf[j].id;
+                out[j].gx     = ox + recv_buf[j].x;
+                out[j].gy     = oy + recv_buf[j].y;
+                out[j].energy = recv_buf[j].energy;
+            }
+        }
+        *all_agents  = out;
+        *total_count = total;
+    } else {
+        *all_agents = NULL;
     }
 }
 
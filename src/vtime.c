@@ -0,0 +1,93 @@
+#include "vtime.h"
+#include "arena.h"
+#include "workload.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include <time.h>
+#endif
+
+int vtime_enabled = 0;
+
+typedef struct {
+    double sum;         /* iterações cobradas pela thread */
+    int    max;         /* maior cobrança isolada */
+    char   pad[64];
+} VtThread;
+
+static VtThread *slots;
+static int       nslots;
+static double    ns_iter;
+static int       model_threads;
+
+static double wtime(void) {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+double vtime_calibrate(void) {
+    const int iters = 1 << 24;
+    double best = 0.0;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = wtime();
+        workload_run(iters);
+        double t = wtime() - t0;
+        if (rep == 0 || t < best)
+            best = t;
+    }
+    return best * 1e9 / iters;
+}
+
+void vtime_init(double ns_per_iter, int threads) {
+    nslots = 1;
+#ifdef _OPENMP
+    nslots = omp_get_max_threads();
+#endif
+    slots         = sim_calloc((size_t)nslots, sizeof(VtThread));
+    ns_iter       = ns_per_iter;
+    model_threads = threads > 0 ? threads : 1;
+    vtime_enabled = 1;
+}
+
+void vtime_charge(int iters) {
+    int tid = 0;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+#endif
+    if (tid >= nslots) return;
+    VtThread *s = &slots[tid];
+    s->sum += iters;
+    if (iters > s->max)
+        s->max = iters;
+}
+
+double vtime_take(double *iters) {
+    double w = 0.0;
+    int    m = 0;
+    for (int t = 0; t < nslots; t++) {
+        w += slots[t].sum;
+        if (slots[t].max > m)
+            m = slots[t].max;
+        slots[t].sum = 0.0;
+        slots[t].max = 0;
+    }
+    *iters = w;
+    double span = w / model_threads;
+    return (span > m ? span : m) * ns_iter * 1e-9;
+}
+
+void vtime_shutdown(void) {
+    vtime_enabled = 0;
+    free(slots);
+    slots  = NULL;
+    nslots = 0;
+}
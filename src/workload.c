@@ -1,6 +1,73 @@
 #include "workload.h"
+#include "arena.h"
+#include "rng.h"
+#include "vtime.h"
 
-double workload_compute(double resource, int max_iters) {
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include <time.h>
+#endif
+
+static const char *const profile_names[WL_PROFILE_COUNT] = {
+    "compute", "memory", "chase", "stochastic"
+};
+
+/* 8 MB por thread: maior que a L2 e que a fatia de LLC de um núcleo. */
+#define WL_TABLE_WORDS (1u << 20)
+#define WL_CHASE_SLOTS (1u << 21)
+
+/* Teto do sorteio do stochastic, em múltiplos do custo nominal. */
+#define WL_STOCHASTIC_CAP 16.0
+
+typedef struct {
+    RngState  rng;
+    uint64_t *table;     /* memory */
+    uint32_t *next;      /* chase: ciclo único (Sattolo) */
+    uint32_t  pos;
+    char      pad[64];
+} WlThread;
+
+static WorkloadProfile profile = WL_COMPUTE;
+static double          scale   = 1.0;
+static WlThread       *threads;
+static int             nthreads;
+
+int workload_parse_profile(const char *name) {
+    for (int p = 0; p < WL_PROFILE_COUNT; p++)
+        if (strcmp(name, profile_names[p]) == 0) return p;
+    return -1;
+}
+
+const char *workload_profile_name(WorkloadProfile p) {
+    return profile_names[p];
+}
+
+static int thread_id(void) {
+#ifdef _OPENMP
+    int tid = omp_get_thread_num();
+    return tid < nthreads ? tid : 0;
+#else
+    return 0;
+#endif
+}
+
+static double wtime(void) {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+static double kernel_compute(long steps) {
     /*
      * Busy-loop sintético cuja contagem de iterações escala com o nível
      * de recurso da célula. Isso cria custo heterogêneo por célula, que
@@ -9,10 +76,136 @@ double workload_compute(double resource, int max_iters) {
      * O qualificador volatile em `result` impede o compilador de
      * eliminar o loop como código morto.
      */
-    int iters = (int)(resource * max_iters);
     volatile double result = 0.0;
-    for (int i = 0; i < iters; i++) {
+    for (long i = 0; i < steps; i++) {
         result += i * 0.0001;
     }
     return result;
 }
+
+static double kernel_memory(WlThread *t, long steps) {
+    uint64_t sum = 0;
+    for (long i = 0; i < steps; i++)
+        sum += t->table[rng_next(&t->rng) & (WL_TABLE_WORDS - 1)];
+    volatile double result = (double)sum;
+    return result;
+}
+
+static double kernel_chase(WlThread *t, long steps) {
+    uint32_t p = t->pos;
+    for (long i = 0; i < steps; i++)
+        p = t->next[p];
+    t->pos = p;
+    volatile double result = p;
+    return result;
+}
+
+static double run_steps(long steps) {
+    switch (profile) {
+    case WL_MEMORY: return kernel_memory(&threads[thread_id()], steps);
+    case WL_CHASE:  return kernel_chase(&threads[thread_id()], steps);
+    default:        return kernel_compute(steps);
+    }
+}
+
+double workload_run(int iters) {
+    return run_steps((long)(iters * scale + 0.5));
+}
+
+/* Melhor de 3 para `steps` passos do kernel corrente, em ns por passo. */
+static double ns_per_step(long steps) {
+    double best = 0.0;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = wtime();
+        run_steps(steps);
+        double t = wtime() - t0;
+        if (rep == 0 || t < best)
+            best = t;
+    }
+    return best * 1e9 / steps;
+}
+
+static void thread_tables(WlThread *t, int tid) {
+    t->rng = rng_seed(0x9e3779b97f4a7c15ULL * (uint64_t)(tid + 1));
+    if (profile == WL_MEMORY) {
+        t->table = sim_malloc(sizeof(uint64_t) * WL_TABLE_WORDS);
+        for (uint32_t i = 0; i < WL_TABLE_WORDS; i++)
+            t->table[i] = rng_next(&t->rng);
+    } else if (profile == WL_CHASE) {
+        /* Sattolo: permutação com um único ciclo, sem atalhos curtos. */
+        t->next = sim_malloc(sizeof(uint32_t) * WL_CHASE_SLOTS);
+        for (uint32_t i = 0; i < WL_CHASE_SLOTS; i++)
+            t->next[i] = i;
+        for (uint32_t i = WL_CHASE_SLOTS - 1; i > 0; i--) {
+            uint32_t j   = (uint32_t)(rng_next(&t->rng) % i);
+            uint32_t tmp = t->next[i];
+            t->next[i]   = t->next[j];
+            t->next[j]   = tmp;
+        }
+    }
+}
+
+void workload_set_profile(WorkloadProfile p) {
+    workload_shutdown();
+    profile = p;
+    if (p == WL_COMPUTE)
+        return;
+
+    nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    threads = sim_calloc((size_t)nthreads, sizeof(WlThread));
+    #pragma omp parallel
+    {
+        int tid = thread_id();
+        if (!threads[tid].rng)
+            thread_tables(&threads[tid], tid);
+    }
+    /* Equipe menor que omp_get_max_threads(): o resto na master. */
+    for (int t = 0; t < nthreads; t++)
+        if (!threads[t].rng)
+            thread_tables(&threads[t], t);
+
+    /* Passos por iteração nominal: o kernel do perfil ao custo do laço
+     * compute (o stochastic já usa o próprio laço). */
+    if (p == WL_MEMORY || p == WL_CHASE) {
+        WorkloadProfile self = profile;
+        profile = WL_COMPUTE;
+        double ref = ns_per_step(1L << 22);
+        profile = self;
+        scale = ref / ns_per_step(1L << 20);
+    }
+}
+
+double workload_profile_scale(void) {
+    return scale;
+}
+
+double workload_compute(double resource, int max_iters) {
+    int iters = (int)(resource * max_iters);
+    if (profile == WL_STOCHASTIC && iters > 0) {
+        WlThread *t = &threads[thread_id()];
+        double    x = -log(1.0 - rng_double(&t->rng));
+        if (x > WL_STOCHASTIC_CAP) x = WL_STOCHASTIC_CAP;
+        iters = (int)(iters * x);
+    }
+    if (vtime_enabled) {
+        /* --model: só cobra as iterações (vtime.h). */
+        vtime_charge(iters);
+        return 0.0;
+    }
+    return workload_run(iters);
+}
+
+void workload_shutdown(void) {
+    for (int t = 0; t < nthreads; t++) {
+        free(threads[t].table);
+        free(threads[t].next);
+    }
+    free(threads);
+    threads  = NULL;
+    nthreads = 0;
+    scale    = 1.0;
+    profile  = WL_COMPUTE;
+}
@@ -0,0 +1,298 @@
+/*
+ * Agentes (agent.c): reprodução paralela, ids de filhos e invariância
+ * do passo de decisão à ordem do pool e ao número de threads.
+ */
+#include "test_harness.h"
+#include "agent.h"
+#include "arena.h"
+#include "autotune.h"
+#include "grid.h"
+#include "partition.h"
+#include "pool.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* n agentes; energia alternando acima/abaixo do limiar 10, com alguns
+ * mortos e alguns sem consumo (kid 0). */
+static void setup_parents(AgentPool *pool, uint64_t *kid, int n) {
+    pool_init(pool, 4);
+    for (int i = 0; i < n; i++) {
+        pool_push(pool, (uint64_t)i, i % 50, i / 50, (i % 3) ? 20.0f : 5.0f);
+        kid[i] = (i % 7 == 0) ? 0 : 1000 + (uint64_t)i;
+    }
+    for (int i = 0; i < n; i += 11)
+        pool_kill(pool, i);
+}
+
+/* Filhos esperados em ordem de slot, pela versão serial de referência. */
+static int expected_children(const AgentPool *pool, const uint64_t *kid,
+                             int n, uint64_t *out) {
+    int m = 0;
+    for (int i = 0; i < n; i++)
+        if (kid[i] && pool_alive(pool, i) && pool->energy[i] > 10.0f)
+            out[m++] = kid[i];
+    return m;
+}
+
+TEST(reproduce_matches_serial_order) {
+    enum { N = 1000 };
+    static uint64_t kid[N], want[N];
+    int threads[] = { 1, 2, 3, 5 };
+    for (int t = 0; t < 4; t++) {
+#ifdef _OPENMP
+        omp_set_num_threads(threads[t]);
+#endif
+        AgentPool pool;
+        Arena arena;
+        arena_init(&arena, 1 << 12);
+        setup_parents(&pool, kid, N);
+        int m = expected_children(&pool, kid, N, want);
+        int live = pool_live(&pool);
+
+        agents_reproduce(&pool, kid, 10.0, 4.0, &arena);
+
+        ASSERT_EQ(pool.count, N + m);
+        ASSERT_EQ(pool_live(&pool), live + m);
+        for (int j = 0; j < m; j++) {
+            int c = N + j;
+            ASSERT_EQ(pool.id[c], want[j]);
+            ASSERT_NEAR(pool.energy[c], 4.0, 0.0);
+            ASSERT_EQ(pool.x[c], pool.x[want[j] - 1000]);
+            ASSERT_EQ(pool.y[c], pool.y[want[j] - 1000]);
+        }
+        ASSERT_NEAR(pool.energy[1], 16.0, 0.0);     /* pai pagou cost */
+        ASSERT_NEAR(pool.energy[7], 20.0, 0.0);     /* kid 0: sem filho */
+        pool_destroy(&pool);
+        arena_destroy(&arena);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+}
+
+TEST(reproduce_nothing_to_do) {
+    AgentPool pool;
+    Arena arena;
+    uint64_t kid[8] = { 0 };
+    arena_init(&arena, 1 << 10);
+    pool_init(&pool, 8);
+    for (int i = 0; i < 8; i++)
+        pool_push(&pool, (uint64_t)i, 1, 1, 50.0f);
+    agents_reproduce(&pool, kid, 10.0, 4.0, &arena);
+    ASSERT_EQ(pool.count, 8);
+    ASSERT_EQ(pool_live(&pool), 8);
+    pool_destroy(&pool);
+    arena_destroy(&arena);
+}
+
+TEST(ids_init_limits) {
+    ASSERT_EQ(agent_ids_init(1000, 512, 512), 0);
+    ASSERT_EQ(agent_ids_init(1, 1, 1), 0);
+    /* 2^20 ciclos + 2^32 células deixam 11 bits para k: recusa. */
+    ASSERT_EQ(agent_ids_init(1 << 20, 1 << 16, 1 << 16), -1);
+    /* Exatamente AGENT_ID_MIN_RANK_BITS (31) sobrando: aceita; um ciclo
+     * a mais pede o 17º bit de ciclo e recusa. */
+    ASSERT_EQ(agent_ids_init(1 << 16, 1 << 8, 1 << 8), 0);
+    ASSERT_EQ(agent_ids_init((1 << 16) + 1, 1 << 8, 1 << 8), -1);
+}
+
+TEST(child_ids_are_unique_and_disjoint) {
+    enum { C = 5, W = 7, H = 3, K = 4 };
+    static uint64_t ids[C * W * H * K];
+    int n = 0;
+    ASSERT_EQ(agent_ids_init(C, W, H), 0);
+    for (int c = 0; c < C; c++)
+        for (int gy = 0; gy < H; gy++)
+            for (int gx = 0; gx < W; gx++)
+                for (int k = 0; k < K; k++) {
+                    uint64_t id = agent_child_id(c, gx, gy, k);
+                    ASSERT_TRUE(id >> 63);          /* nunca um id inicial */
+                    ids[n++] = id;
+                }
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++)
+            ASSERT_NEQ(ids[i], ids[j]);
+
+    /* Extremos dos campos não invadem o campo vizinho. */
+    ASSERT_EQ(agent_ids_init(1000, 300, 200), 0);
+    uint64_t kmax = agent_child_id(0, 0, 0,
+                                   (int)((1ULL << AGENT_ID_MIN_RANK_BITS) - 1));
+    ASSERT_TRUE(kmax < agent_child_id(0, 1, 0, 0));
+    ASSERT_TRUE(agent_child_id(0, 299, 199, 0) < agent_child_id(1, 0, 0, 0));
+    ASSERT_TRUE(agent_child_id(999, 299, 199, 0) > agent_child_id(998, 299, 199, 0));
+}
+
+TEST(birth_id_uses_global_cell) {
+    Partition p;
+    SubGrid sg;
+    partition_init(&p, 20, 10, 0);
+    subgrid_create(&sg, &p, 20, 10, 2);
+    ASSERT_EQ(agent_ids_init(50, 20, 10), 0);
+    /* Interior começa em (halo, halo) = célula global (0, 0). */
+    ASSERT_EQ(agent_birth_id(&sg, CELL_AT(&sg, 2, 2), 3),
+              agent_child_id(3, 0, 0, 0));
+    ASSERT_EQ(agent_birth_id(&sg, CELL_AT(&sg, 5, 9), 3),
+              agent_child_id(3, 7, 3, 0));
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+}
+
+/* Estado final de um agente, para comparar execuções por id. */
+typedef struct { uint64_t id, kid; int x, y, alive; float energy; } Snap;
+
+static int snap_cmp(const void *a, const void *b) {
+    uint64_t x = ((const Snap *)a)->id, y = ((const Snap *)b)->id;
+    return (x > y) - (x < y);
+}
+
+/* Um passo de decisão numa grade 24 × 18 com `threads` threads e o pool
+ * em ordem reversa se `reverse`; devolve os agentes ordenados por id e
+ * a soma dos recursos do interior. */
+static int decide_snapshot(int threads, int reverse, Snap *out,
+                           double *resource) {
+    Partition p;
+    SubGrid sg;
+    AgentPool init, pool;
+    Arena arena;
+    partition_init(&p, 24, 18, 0);
+    subgrid_create(&sg, &p, 24, 18, 1);
+    subgrid_init(&sg, &p, 42);
+    arena_init(&arena, 1 << 16);
+    agent_ids_init(10, 24, 18);
+
+    pool_init(&init, 64);
+    agents_init(&init, 400, &sg, &p, 24, 18, 10.0, 42);
+    pool_init(&pool, init.count);
+    for (int j = 0; j < init.count; j++) {
+        int i = reverse ? init.count - 1 - j : j;
+        pool_push(&pool, init.id[i], init.x[i], init.y[i], init.energy[i]);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#else
+    (void)threads;
+#endif
+    uint64_t *kid = agents_decide_all(&pool, &sg, 42, 3, 1.5, 1.0, &arena);
+
+    int n = pool.count;
+    for (int i = 0; i < n; i++)
+        out[i] = (Snap){ pool.id[i], kid[i], pool.x[i], pool.y[i],
+                         pool_alive(&pool, i), pool.energy[i] };
+    qsort(out, (size_t)n, sizeof(Snap), snap_cmp);
+
+    *resource = 0.0;
+    for (int r = 1; r <= sg.local_h; r++)
+        for (int c = 1; c <= sg.local_w; c++)
+            *resource += sg.cells[CELL_AT(&sg, r, c)].resource;
+
+    pool_destroy(&init);
+    pool_destroy(&pool);
+    arena_destroy(&arena);
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+    return n;
+}
+
+TEST(decide_independent_of_order_and_threads) {
+    static Snap ref[400], got[400];
+    double ref_res, got_res;
+    int n = decide_snapshot(1, 0, ref, &ref_res);
+    ASSERT_EQ(n, 400);
+    int consumed = 0;
+    for (int i = 0; i < n; i++)
+        consumed += ref[i].kid != 0;
+    ASSERT_TRUE(consumed > 0);
+
+    int threads[] = { 2, 3, 4 };
+    for (int t = 0; t < 3; t++)
+        for (int rev = 0; rev < 2; rev++) {
+            ASSERT_EQ(decide_snapshot(threads[t], rev, got, &got_res), n);
+            ASSERT_TRUE(got_res == ref_res);
+            for (int i = 0; i < n; i++) {
+                ASSERT_EQ(got[i].id, ref[i].id);
+                ASSERT_EQ(got[i].kid, ref[i].kid);
+                ASSERT_EQ(got[i].x, ref[i].x);
+                ASSERT_EQ(got[i].y, ref[i].y);
+                ASSERT_EQ(got[i].alive, ref[i].alive);
+                ASSERT_TRUE(got[i].energy == ref[i].energy);
+            }
+        }
+
+    /* Decisões em blocos numa parte da equipe (tune_block). */
+    TuneSetting decide = tune_get(TUNE_DECIDE);
+    tune_set(TUNE_DECIDE, (TuneSetting){ 1, 0, 2 });
+    ASSERT_EQ(decide_snapshot(4, 1, got, &got_res), n);
+    tune_set(TUNE_DECIDE, decide);
+    ASSERT_TRUE(got_res == ref_res);
+    for (int i = 0; i < n; i++) {
+        ASSERT_EQ(got[i].kid, ref[i].kid);
+        ASSERT_TRUE(got[i].energy == ref[i].energy);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+}
+
+/* Agentes no halo que entram no interior cruzam de bloco: não consomem,
+ * mas recebem o id de filho da célula de origem e se reproduzem. */
+TEST(crossers_keep_a_child_id) {
+    Partition p;
+    SubGrid sg;
+    AgentPool pool;
+    Arena arena;
+    partition_init(&p, 24, 18, 0);
+    subgrid_create(&sg, &p, 24, 18, 2);
+    subgrid_init(&sg, &p, 42);
+    arena_init(&arena, 1 << 16);
+    ASSERT_EQ(agent_ids_init(10, 24, 18), 0);
+
+    /* Primeira célula acessível da coluna de borda do interior; a única
+     * com recurso entre os vizinhos da célula de halo à esquerda dela. */
+    int r = sg.halo + 1;
+    while (!subgrid_accessible(&sg, CELL_AT(&sg, r, sg.halo)))
+        r++;
+    ASSERT_TRUE(r < sg.halo + sg.local_h - 1);
+    for (int y = r - 1; y <= r + 1; y++)
+        for (int x = sg.halo - 2; x <= sg.halo; x++)
+            sg.cells[CELL_AT(&sg, y, x)].resource = 0.0;
+    const int to   = CELL_AT(&sg, r, sg.halo);
+    const int from = CELL_AT(&sg, r, sg.halo - 1);
+    sg.cells[to].resource = 5.0;
+
+    pool_init(&pool, 4);
+    pool_push(&pool, 7, sg.halo - 1, r, 3.0f);
+    pool_push(&pool, 3, sg.halo - 1, r, 3.0f);
+    uint64_t *kid = agents_decide_all(&pool, &sg, 42, 4, 1.5, 1.0, &arena);
+
+    ASSERT_EQ(pool.x[0], sg.halo);
+    ASSERT_EQ(pool.x[1], sg.halo);
+    ASSERT_TRUE(sg.cells[to].resource == 5.0);     /* ninguém consumiu */
+    ASSERT_TRUE(pool.energy[0] == 3.0f && pool.energy[1] == 3.0f);
+    ASSERT_EQ(kid[1], agent_birth_id(&sg, from, 4));      /* id 3: k = 0 */
+    ASSERT_EQ(kid[0], agent_birth_id(&sg, from, 4) + 1);  /* id 7: k = 1 */
+
+    agents_reproduce(&pool, kid, 2.0, 1.0, &arena);
+    ASSERT_EQ(pool.count, 4);
+    ASSERT_EQ(pool.id[2], kid[0]);
+    ASSERT_EQ(pool.id[3], kid[1]);
+
+    pool_destroy(&pool);
+    arena_destroy(&arena);
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+}
+
+int suite_agent(void) {
+    printf("agent\n");
+    RUN_TEST(reproduce_matches_serial_order);
+    RUN_TEST(reproduce_nothing_to_do);
+    RUN_TEST(ids_init_limits);
+    RUN_TEST(child_ids_are_unique_and_disjoint);
+    RUN_TEST(birth_id_uses_global_cell);
+    RUN_TEST(decide_independent_of_order_and_threads);
+    RUN_TEST(crossers_keep_a_child_id);
+    SUITE_SUMMARY("agent");
+}
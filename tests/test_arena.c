@@ -0,0 +1,86 @@
+/*
+ * Arena de quadro (arena.c): alinhamento, reset, overflow e high-water.
+ */
+#include "test_harness.h"
+#include "arena.h"
+
+#include <string.h>
+
+TEST(alloc_is_aligned_and_bumps) {
+    Arena a;
+    arena_init(&a, 1000);
+    ASSERT_EQ(a.size, 1024);            /* arredondado a 64 */
+    char *p = arena_alloc(&a, 1);
+    char *q = arena_alloc(&a, 100);
+    ASSERT_EQ((uintptr_t)p % 64, 0);
+    ASSERT_EQ((uintptr_t)q % 64, 0);
+    ASSERT_EQ(q - p, 64);
+    ASSERT_EQ(a.used, 64 + 128);
+    ASSERT_EQ(a.cycle_bytes, 64 + 128);
+    arena_destroy(&a);
+}
+
+TEST(reset_reuses_main_block) {
+    Arena a;
+    arena_init(&a, 4096);
+    char *base = a.base;
+    for (int cycle = 0; cycle < 5; cycle++) {
+        uint64_t before = sim_alloc_count();
+        char *p = arena_alloc(&a, 1000);
+        ASSERT_TRUE(p == base);
+        arena_alloc(&a, 2000);
+        ASSERT_EQ(sim_alloc_count(), before);   /* nenhum malloc */
+        arena_reset(&a);
+        ASSERT_EQ(a.used, 0);
+        ASSERT_TRUE(a.base == base);
+    }
+    ASSERT_EQ(a.high_water, 1024 + 2048);
+    arena_destroy(&a);
+}
+
+TEST(overflow_then_high_water_resize) {
+    Arena a;
+    arena_init(&a, 256);
+    arena_alloc(&a, 200);                       /* 256: enche o bloco */
+    char *big = arena_alloc(&a, 1000);          /* overflow */
+    ASSERT_EQ(a.n_overflow, 1);
+    ASSERT_EQ((uintptr_t)big % 64, 0);
+    big[999] = 1;                               /* memória utilizável */
+    ASSERT_EQ(a.cycle_bytes, 256 + 1024);
+
+    arena_reset(&a);
+    ASSERT_EQ(a.n_overflow, 0);
+    ASSERT_EQ(a.high_water, 1280);
+    ASSERT_EQ(a.size, 1600);                    /* 1280 * 1.25, alinhado */
+    ASSERT_EQ(a.size % 64, 0);
+
+    /* O mesmo ciclo agora cabe sem overflow nem malloc. */
+    uint64_t before = sim_alloc_count();
+    arena_alloc(&a, 200);
+    arena_alloc(&a, 1000);
+    ASSERT_EQ(a.n_overflow, 0);
+    ASSERT_EQ(sim_alloc_count(), before);
+    arena_reset(&a);
+    ASSERT_EQ(a.size, 1600);                    /* sem overflow: fica */
+    arena_destroy(&a);
+}
+
+TEST(calloc_zeroes_reused_memory) {
+    Arena a;
+    arena_init(&a, 1024);
+    memset(arena_alloc(&a, 512), 0xff, 512);
+    arena_reset(&a);
+    unsigned char *z = arena_calloc(&a, 128, 4);
+    for (int i = 0; i < 512; i++)
+        ASSERT_EQ(z[i], 0);
+    arena_destroy(&a);
+}
+
+int suite_arena(void) {
+    printf("arena\n");
+    RUN_TEST(alloc_is_aligned_and_bumps);
+    RUN_TEST(reset_reuses_main_block);
+    RUN_TEST(overflow_then_high_water_resize);
+    RUN_TEST(calloc_zeroes_reused_memory);
+    SUITE_SUMMARY("arena");
+}
@@ -0,0 +1,150 @@
+/*
+ * Escalonamentos por fase (autotune.c): formato e arquivo --tune-file.
+ */
+#include "test_harness.h"
+#include "autotune.h"
+
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int same(TuneSetting a, TuneSetting b) {
+    return a.kind == b.kind && a.chunk == b.chunk && a.threads == b.threads;
+}
+
+static void write_file(const char *path, const char *text) {
+    FILE *f = fopen(path, "w");
+    fputs(text, f);
+    fclose(f);
+}
+
+TEST(format_settings) {
+    char buf[48];
+    ASSERT_TRUE(strcmp(tune_format((TuneSetting){ 3, 8, 0 }, buf, sizeof(buf)),
+                       "guided,8") == 0);
+    ASSERT_TRUE(strcmp(tune_format((TuneSetting){ 1, 0, 2 }, buf, sizeof(buf)),
+                       "static,0,2") == 0);
+}
+
+TEST(save_then_load_round_trip) {
+    const char *path = "build/test_tune.txt";
+    TuneSetting saved[TUNE_PHASES];
+    for (int p = 0; p < TUNE_PHASES; p++)
+        saved[p] = tune_get((TunePhase)p);
+
+    tune_set(TUNE_WORKLOAD, (TuneSetting){ 2, 32, 0 });
+    tune_set(TUNE_DECIDE,   (TuneSetting){ 1, 0, 0 });
+    tune_set(TUNE_GRID,     (TuneSetting){ 1, 0, 3 });
+    ASSERT_EQ(tune_save(path, "teste"), 0);
+    for (int p = 0; p < TUNE_PHASES; p++)
+        tune_set((TunePhase)p, saved[p]);
+
+    ASSERT_EQ(tune_load(path), 0);
+    ASSERT_TRUE(same(tune_get(TUNE_WORKLOAD), (TuneSetting){ 2, 32, 0 }));
+    ASSERT_TRUE(same(tune_get(TUNE_DECIDE), (TuneSetting){ 1, 0, 0 }));
+    ASSERT_TRUE(same(tune_get(TUNE_GRID), (TuneSetting){ 1, 0, 3 }));
+    ASSERT_EQ(tune_threads(TUNE_GRID), 3);
+
+    for (int p = 0; p < TUNE_PHASES; p++)
+        tune_set((TunePhase)p, saved[p]);
+    remove(path);
+}
+
+TEST(partial_file_keeps_other_phases) {
+    const char *path = "build/test_tune.txt";
+    TuneSetting grid = tune_get(TUNE_GRID);
+    TuneSetting work = tune_get(TUNE_WORKLOAD);
+    TuneSetting decide = tune_get(TUNE_DECIDE);
+    write_file(path, "# só a decisão\n\ndecide=dynamic,4\n");
+    ASSERT_EQ(tune_load(path), 0);
+    ASSERT_TRUE(same(tune_get(TUNE_DECIDE), (TuneSetting){ 2, 4, 0 }));
+    ASSERT_TRUE(same(tune_get(TUNE_GRID), grid));
+    ASSERT_TRUE(same(tune_get(TUNE_WORKLOAD), work));
+    tune_set(TUNE_DECIDE, decide);
+    remove(path);
+}
+
+TEST(invalid_file_changes_nothing) {
+    const char *path = "build/test_tune.txt";
+    const char *bad[] = {
+        "workload=static,1\ngrid=fast,2\n",        /* tipo desconhecido */
+        "workload=static,1\nreduce=static,1\n",    /* fase desconhecida */
+        "workload=static,1\ndecide guided\n",      /* sem '=' */
+        "workload=static,-1\n",                    /* chunk negativo */
+        "workload=static\n",                       /* sem chunk */
+    };
+    TuneSetting before[TUNE_PHASES];
+    for (int p = 0; p < TUNE_PHASES; p++)
+        before[p] = tune_get((TunePhase)p);
+    for (int b = 0; b < 5; b++) {
+        write_file(path, bad[b]);
+        ASSERT_EQ(tune_load(path), -1);
+        for (int p = 0; p < TUNE_PHASES; p++)
+            ASSERT_TRUE(same(tune_get((TunePhase)p), before[p]));
+    }
+    remove(path);
+    ASSERT_EQ(tune_load("build/no_such_tune_file.txt"), -1);
+}
+
+/* threads lido do arquivo vale para toda fase: com 2 de 4 threads, as
+ * duas últimas dividem 0..n-1 em blocos contíguos e a master fica de
+ * fora; com a equipe inteira, tune_block devolve 0. */
+TEST(block_ranges_for_every_phase) {
+    const char *path = "build/test_tune.txt";
+    TuneSetting before[TUNE_PHASES];
+    for (int p = 0; p < TUNE_PHASES; p++)
+        before[p] = tune_get((TunePhase)p);
+    write_file(path, "workload=static,0,2\ndecide=static,0,2\n"
+                     "grid=static,0,2\n");
+    ASSERT_EQ(tune_load(path), 0);
+    remove(path);
+
+    int lo, hi;
+    ASSERT_EQ(tune_block(TUNE_DECIDE, 10, &lo, &hi), 0);  /* 1 thread */
+#ifdef _OPENMP
+    for (int p = 0; p < TUNE_PHASES; p++) {
+        int got[4], range[4][2], nt = 0;
+        #pragma omp parallel num_threads(4)
+        {
+            int t = omp_get_thread_num(), l = -1, h = -1;
+            got[t] = tune_block((TunePhase)p, 10, &l, &h);
+            range[t][0] = l;
+            range[t][1] = h;
+            #pragma omp single
+            nt = omp_get_num_threads();
+        }
+        if (nt < 4) continue;  /* runtime negou a equipe */
+        for (int t = 0; t < 4; t++)
+            ASSERT_EQ(got[t], 1);
+        ASSERT_EQ(range[0][0], range[0][1]);
+        ASSERT_EQ(range[1][0], range[1][1]);
+        ASSERT_EQ(range[2][0], 0);
+        ASSERT_EQ(range[2][1], 5);
+        ASSERT_EQ(range[3][0], 5);
+        ASSERT_EQ(range[3][1], 10);
+    }
+
+    tune_set(TUNE_WORKLOAD, (TuneSetting){ 1, 0, 4 });
+    int blocked = 0;
+    #pragma omp parallel num_threads(4) reduction(+:blocked)
+    {
+        int l, h;
+        blocked += tune_block(TUNE_WORKLOAD, 10, &l, &h);
+    }
+    ASSERT_EQ(blocked, 0);
+#endif
+    for (int p = 0; p < TUNE_PHASES; p++)
+        tune_set((TunePhase)p, before[p]);
+}
+
+int suite_autotune(void) {
+    printf("autotune\n");
+    RUN_TEST(format_settings);
+    RUN_TEST(save_then_load_round_trip);
+    RUN_TEST(partial_file_keeps_other_phases);
+    RUN_TEST(invalid_file_changes_nothing);
+    RUN_TEST(block_ranges_for_every_phase);
+    SUITE_SUMMARY("autotune");
+}
@@ -0,0 +1,152 @@
+/*
+ * Resumo do estado (digest.c): soma comutativa de células e agentes.
+ */
+#include "test_harness.h"
+#include "digest.h"
+#include "grid.h"
+#include "partition.h"
+#include "pool.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define GW 40
+#define GH 30
+
+/* Sub-grade da coluna `col` de uma decomposição 1 × px montada à mão
+ * (partition_init sem MPI só conhece um rank). */
+static void make_block(SubGrid *sg, int px, int col, int halo) {
+    Partition p = { .px = px, .py = 1, .my_row = 0, .my_col = col,
+                    .rank = col, .size = px };
+    subgrid_create(sg, &p, GW, GH, halo);
+    subgrid_init(sg, &p, 99);
+}
+
+/* Agentes em posições globais fixas; os que caem no bloco de sg entram
+ * no pool na ordem dada por `perm` (NULL = crescente). */
+static void fill_agents(AgentPool *pool, const SubGrid *sg, const int *perm,
+                        int n) {
+    pool_init(pool, 16);
+    for (int j = 0; j < n; j++) {
+        int i  = perm ? perm[j] : j;
+        int gx = (i * 7) % GW, gy = (i * 11) % GH;
+        if (gx < sg->offset_x || gx >= sg->offset_x + sg->local_w ||
+            gy < sg->offset_y || gy >= sg->offset_y + sg->local_h)
+            continue;
+        pool_push(pool, (uint64_t)i * 3 + 1, gx - sg->offset_x + sg->halo,
+                  gy - sg->offset_y + sg->halo, 1.0f + (float)i / 8);
+    }
+}
+
+static uint64_t digest_of(const SubGrid *sg, const AgentPool *pool) {
+    uint64_t part[DIGEST_WORDS];
+    digest_local(sg, pool, part);
+    return digest_finish(part);
+}
+
+TEST(invariant_to_agent_order_and_threads) {
+    enum { N = 200 };
+    int perm[N];
+    SubGrid sg;
+    AgentPool fwd, rev;
+    for (int j = 0; j < N; j++)
+        perm[j] = N - 1 - j;
+    make_block(&sg, 1, 0, 1);
+    fill_agents(&fwd, &sg, NULL, N);
+    fill_agents(&rev, &sg, perm, N);
+    ASSERT_EQ(fwd.count, N);
+
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    uint64_t ref = digest_of(&sg, &fwd);
+    ASSERT_EQ(digest_of(&sg, &rev), ref);
+#ifdef _OPENMP
+    for (int t = 2; t <= 4; t++) {
+        omp_set_num_threads(t);
+        ASSERT_EQ(digest_of(&sg, &fwd), ref);
+        ASSERT_EQ(digest_of(&sg, &rev), ref);
+    }
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+    pool_destroy(&fwd);
+    pool_destroy(&rev);
+    subgrid_destroy(&sg);
+}
+
+TEST(invariant_to_halo_width) {
+    SubGrid a, b;
+    AgentPool pa, pb;
+    make_block(&a, 1, 0, 1);
+    make_block(&b, 1, 0, 4);
+    fill_agents(&pa, &a, NULL, 100);
+    fill_agents(&pb, &b, NULL, 100);
+    ASSERT_EQ(digest_of(&a, &pa), digest_of(&b, &pb));
+    pool_destroy(&pa);
+    pool_destroy(&pb);
+    subgrid_destroy(&a);
+    subgrid_destroy(&b);
+}
+
+/* As partes somadas de dois blocos dão as do bloco único. */
+TEST(parts_add_across_blocks) {
+    SubGrid whole, left, right;
+    AgentPool pw, pl, pr;
+    uint64_t w[DIGEST_WORDS], l[DIGEST_WORDS], r[DIGEST_WORDS];
+    make_block(&whole, 1, 0, 1);
+    make_block(&left, 2, 0, 1);
+    make_block(&right, 2, 1, 1);
+    fill_agents(&pw, &whole, NULL, 150);
+    fill_agents(&pl, &left, NULL, 150);
+    fill_agents(&pr, &right, NULL, 150);
+    ASSERT_EQ(pl.count + pr.count, pw.count);
+
+    digest_local(&whole, &pw, w);
+    digest_local(&left, &pl, l);
+    digest_local(&right, &pr, r);
+    for (int k = 0; k < DIGEST_WORDS; k++)
+        ASSERT_EQ(l[k] + r[k], w[k]);
+    pool_destroy(&pw);
+    pool_destroy(&pl);
+    pool_destroy(&pr);
+    subgrid_destroy(&whole);
+    subgrid_destroy(&left);
+    subgrid_destroy(&right);
+}
+
+TEST(sensitive_to_state) {
+    SubGrid sg;
+    AgentPool pool;
+    make_block(&sg, 1, 0, 2);
+    fill_agents(&pool, &sg, NULL, 50);
+    uint64_t ref = digest_of(&sg, &pool);
+
+    pool.energy[3] += 0.5f;
+    ASSERT_NEQ(digest_of(&sg, &pool), ref);
+    pool.energy[3] -= 0.5f;
+    ASSERT_EQ(digest_of(&sg, &pool), ref);
+
+    pool_kill(&pool, 7);                        /* mortos ficam de fora */
+    uint64_t killed = digest_of(&sg, &pool);
+    ASSERT_NEQ(killed, ref);
+    pool_compact(&pool);
+    ASSERT_EQ(digest_of(&sg, &pool), killed);
+
+    pool_push(&pool, 12345, 0, 0, 1.0f);        /* no halo: fantasma */
+    ASSERT_EQ(digest_of(&sg, &pool), killed);
+
+    sg.cells[CELL_AT(&sg, 5, 5)].resource += 1e-9;
+    ASSERT_NEQ(digest_of(&sg, &pool), killed);
+    pool_destroy(&pool);
+    subgrid_destroy(&sg);
+}
+
+int suite_digest(void) {
+    printf("digest\n");
+    RUN_TEST(invariant_to_agent_order_and_threads);
+    RUN_TEST(invariant_to_halo_width);
+    RUN_TEST(parts_add_across_blocks);
+    RUN_TEST(sensitive_to_state);
+    SUITE_SUMMARY("digest");
+}
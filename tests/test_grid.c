@@ -0,0 +1,115 @@
+/*
+ * Passada fundida da grade (grid.c): regeneração e somas por linha numa
+ * só leitura, com total independente das threads.
+ */
+#include "test_harness.h"
+#include "arena.h"
+#include "autotune.h"
+#include "grid.h"
+#include "partition.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define GG_W 50
+#define GG_H 35
+
+static void make_grid(Partition *p, SubGrid *sg) {
+    partition_init(p, GG_W, GG_H, 0);
+    subgrid_create(sg, p, GG_W, GG_H, 1);
+    subgrid_init(sg, p, 1234);
+}
+
+/* Soma de referência do interior, serial e célula a célula. */
+static double direct_sum(const SubGrid *sg, double type_total[CELL_TYPES]) {
+    double s = 0.0;
+    for (int k = 0; k < CELL_TYPES; k++)
+        type_total[k] = 0.0;
+    for (int r = sg->halo; r < sg->halo + sg->local_h; r++)
+        for (int c = sg->halo; c < sg->halo + sg->local_w; c++) {
+            const Cell *cell = &sg->cells[CELL_AT(sg, r, c)];
+            s += cell->resource;
+            type_total[cell->type] += cell->resource;
+        }
+    return s;
+}
+
+TEST(fused_sweep_sums_the_updated_grid) {
+    Partition p;
+    SubGrid sg;
+    Arena arena;
+    GridSweep gs;
+    double total, types[CELL_TYPES], want_types[CELL_TYPES];
+    make_grid(&p, &sg);
+    arena_init(&arena, 1 << 14);
+    grid_sweep_alloc(&gs, &sg, &arena);
+
+    subgrid_update(&sg, WET, &gs);
+    grid_sweep_total(&gs, &sg, &total, types);
+    /* Mesma ordem de soma por linha: só a associação entre linhas muda. */
+    ASSERT_NEAR(total, direct_sum(&sg, want_types), 1e-9);
+    for (int k = 0; k < CELL_TYPES; k++)
+        ASSERT_NEAR(types[k], want_types[k], 1e-9);
+
+    /* A soma sem regenerar dá exatamente as mesmas parciais. */
+    GridSweep again;
+    double total2, types2[CELL_TYPES];
+    grid_sweep_alloc(&again, &sg, &arena);
+    #pragma omp parallel
+    subgrid_sum_rows_team(&sg, &again);
+    grid_sweep_total(&again, &sg, &total2, types2);
+    ASSERT_TRUE(total2 == total);
+
+    arena_destroy(&arena);
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+}
+
+/* Resultado bit a bit igual para 1..4 threads, para a passada linha a
+ * linha sem OpenMP e para menos threads ativas que a equipe. */
+TEST(update_independent_of_threads) {
+    Partition p;
+    SubGrid ref, sg;
+    Arena arena;
+    GridSweep gs;
+    double ref_total, total, types[CELL_TYPES];
+    make_grid(&p, &ref);
+    arena_init(&arena, 1 << 14);
+    for (int r = ref.box_r0; r <= ref.box_r1; r++)
+        subgrid_update_row(&ref, DRY, r, NULL);
+    grid_sweep_alloc(&gs, &ref, &arena);
+    #pragma omp parallel
+    subgrid_sum_rows_team(&ref, &gs);
+    grid_sweep_total(&gs, &ref, &ref_total, types);
+
+    TuneSetting saved = tune_get(TUNE_GRID);
+    for (int t = 1; t <= 4; t++)
+        for (int active = 0; active <= 2; active += 2) {
+#ifdef _OPENMP
+            omp_set_num_threads(t);
+#endif
+            tune_set(TUNE_GRID, (TuneSetting){ saved.kind, saved.chunk, active });
+            make_grid(&p, &sg);
+            subgrid_update(&sg, DRY, &gs);
+            grid_sweep_total(&gs, &sg, &total, types);
+            ASSERT_TRUE(total == ref_total);
+            for (int k = 0; k < sg.halo_w * sg.halo_h; k++)
+                ASSERT_TRUE(sg.cells[k].resource == ref.cells[k].resource);
+            subgrid_destroy(&sg);
+            partition_destroy(&p);
+        }
+    tune_set(TUNE_GRID, saved);
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+    arena_destroy(&arena);
+    subgrid_destroy(&ref);
+}
+
+int suite_grid(void) {
+    printf("grid\n");
+    RUN_TEST(fused_sweep_sums_the_updated_grid);
+    RUN_TEST(update_independent_of_threads);
+    SUITE_SUMMARY("grid");
+}
@@ -75,6 +75,14 @@ static int _test_fail_count = 0;
     }                                                                 \
 } while (0)
 
+/* ── Suites in their own files: counters are per translation unit, so
+ *    each suite reports and returns its failures to test_main.c ── */
+#define SUITE_SUMMARY(name) do {                                      \
+    printf("── %s: %d passed, %d failed ──\n\n",                      \
+           name, _test_pass_count, _test_fail_count);                 \
+    return _test_fail_count;                                          \
+} while (0)
+
 #define TEST_SUMMARY() do {                                           \
     printf("\n── Results: %d passed, %d failed ──\n",                 \
            _test_pass_count, _test_fail_count);                       \
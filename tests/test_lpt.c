@@ -0,0 +1,105 @@
+/*
+ * Escalonamento LPT (lpt.c): distribuição em zigue-zague, roubo pelo
+ * fundo e consumo único sob concorrência.
+ */
+#include "test_harness.h"
+#include "lpt.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Custos 10, 20, ..., 80 com max_cost 80: cada tarefa na sua faixa. */
+static void build_eight(LptPlan *plan, Arena *arena, int nqueues) {
+    static const int cost[8] = { 10, 20, 30, 40, 50, 60, 70, 80 };
+    lpt_build(plan, cost, 8, 80, nqueues, arena);
+}
+
+TEST(zigzag_deal_largest_first) {
+    Arena arena;
+    LptPlan plan;
+    arena_init(&arena, 1 << 12);
+    build_eight(&plan, &arena, 3);
+    ASSERT_EQ(plan.ntasks, 8);
+    /* Ordem LPT 7..0 em zigue-zague: q0 = 7 2 1, q1 = 6 3 0, q2 = 5 4. */
+    ASSERT_EQ(lpt_next(&plan, 1), 6);
+    ASSERT_EQ(lpt_next(&plan, 2), 5);
+    ASSERT_EQ(lpt_next(&plan, 0), 7);
+    ASSERT_EQ(lpt_next(&plan, 2), 4);
+    ASSERT_EQ(lpt_next(&plan, 0), 2);
+    ASSERT_EQ(lpt_next(&plan, 1), 3);
+    arena_destroy(&arena);
+}
+
+TEST(thief_takes_from_the_back) {
+    Arena arena;
+    LptPlan plan;
+    arena_init(&arena, 1 << 12);
+    build_eight(&plan, &arena, 3);
+    /* Só a thread 0 trabalha: a própria fila pela frente, depois a
+     * fila 1 e a fila 2 pelo fundo (as menores tarefas primeiro). */
+    static const int want[8] = { 7, 2, 1, 0, 3, 6, 4, 5 };
+    for (int k = 0; k < 8; k++)
+        ASSERT_EQ(lpt_next(&plan, 0), want[k]);
+    ASSERT_EQ(lpt_next(&plan, 0), -1);
+    ASSERT_EQ(lpt_next(&plan, 2), -1);
+    arena_destroy(&arena);
+}
+
+TEST(zero_cost_tasks_are_skipped) {
+    Arena arena;
+    LptPlan plan;
+    int cost[6] = { 0, 5, 0, 0, 9, 0 };
+    arena_init(&arena, 1 << 12);
+    lpt_build(&plan, cost, 6, 10, 4, &arena);
+    ASSERT_EQ(plan.ntasks, 2);
+    ASSERT_EQ(lpt_next(&plan, 3), 4);           /* rouba a fila 0 */
+    ASSERT_EQ(lpt_next(&plan, 3), 1);
+    ASSERT_EQ(lpt_next(&plan, 0), -1);
+
+    lpt_build(&plan, cost, 0, 10, 4, &arena);   /* nenhuma tarefa */
+    ASSERT_EQ(plan.ntasks, 0);
+    ASSERT_EQ(lpt_next(&plan, 1), -1);
+    arena_destroy(&arena);
+}
+
+TEST(concurrent_consumption_takes_each_task_once) {
+    enum { N = 50000 };
+    static int cost[N], seen[N];
+    for (int i = 0; i < N; i++) {
+        cost[i] = (int)((i * 2654435761u) % 1000);
+        seen[i] = 0;
+    }
+    Arena arena;
+    LptPlan plan;
+    arena_init(&arena, 1 << 16);
+    int nq = 4;
+    lpt_build(&plan, cost, N, 999, nq, &arena);
+
+    int taken = 0;
+    #pragma omp parallel num_threads(4) reduction(+:taken)
+    {
+        int self = 0;
+#ifdef _OPENMP
+        self = omp_get_thread_num() % nq;
+#endif
+        for (int t; (t = lpt_next(&plan, self)) >= 0; ) {
+            #pragma omp atomic
+            seen[t]++;
+            taken++;
+        }
+    }
+    ASSERT_EQ(taken, plan.ntasks);
+    for (int i = 0; i < N; i++)
+        ASSERT_EQ(seen[i], cost[i] > 0 ? 1 : 0);
+    arena_destroy(&arena);
+}
+
+int suite_lpt(void) {
+    printf("lpt\n");
+    RUN_TEST(zigzag_deal_largest_first);
+    RUN_TEST(thief_takes_from_the_back);
+    RUN_TEST(zero_cost_tasks_are_skipped);
+    RUN_TEST(concurrent_consumption_takes_each_task_once);
+    SUITE_SUMMARY("lpt");
+}
@@ -0,0 +1,40 @@
+/*
+ * Runner dos testes unitários (make test-unit): cada suíte vive no seu
+ * tests/test_<módulo>.c e devolve o número de falhas.
+ */
+#include <stdio.h>
+
+int suite_pool(void);
+int suite_agent(void);
+int suite_arena(void);
+int suite_pack(void);
+int suite_season(void);
+int suite_lpt(void);
+int suite_partition(void);
+int suite_vtime(void);
+int suite_workload(void);
+int suite_digest(void);
+int suite_taskgraph(void);
+int suite_grid(void);
+int suite_autotune(void);
+
+int main(void) {
+    int failed = 0;
+
+    failed += suite_pool();
+    failed += suite_agent();
+    failed += suite_arena();
+    failed += suite_pack();
+    failed += suite_season();
+    failed += suite_lpt();
+    failed += suite_partition();
+    failed += suite_vtime();
+    failed += suite_workload();
+    failed += suite_digest();
+    failed += suite_taskgraph();
+    failed += suite_grid();
+    failed += suite_autotune();
+
+    printf("%s\n", failed ? "UNIT TESTS FAILED" : "All unit tests passed");
+    return failed > 0 ? 1 : 0;
+}
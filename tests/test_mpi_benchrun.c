@@ -0,0 +1,226 @@
+/*
+ * Relatório do --bench e do --weak-scaling (benchrun.c): taxas por
+ * repetição, médias e desvios por fase, eficiência paralela com e sem
+ * referência e os campos do JSON. Cada rank confere o próprio relatório
+ * (benchrun não fala MPI; o binário só precisa de halo.c para os nomes).
+ *
+ * mpirun -np 4 ./test_mpi_benchrun (make test-mpi)
+ */
+#include "test_harness.h"
+#include "benchrun.h"
+#include "config.h"
+
+#include <mpi.h>
+#include <string.h>
+
+/* Relatório inteiro num buffer (terminado em '\0'). */
+static char report[16384];
+
+static void capture_print(const BenchRun *b, const SimConfig *cfg,
+                          int ranks, int threads, double ref) {
+    FILE *f = tmpfile();
+    benchrun_print(f, b, cfg, ranks, threads, ref);
+    rewind(f);
+    size_t n = fread(report, 1, sizeof(report) - 1, f);
+    report[n] = '\0';
+    fclose(f);
+}
+
+/*
+ * Número logo após `key` (a partir de `from`). Sem a chave, -HUGE_VAL:
+ * qualquer ASSERT_NEAR falha (com NAN a comparação passaria).
+ */
+static double field_after(const char *from, const char *key) {
+    const char *p = from ? strstr(from, key) : NULL;
+    return p ? strtod(p + strlen(key), NULL) : -HUGE_VAL;
+}
+
+static double field(const char *key) {
+    return field_after(report, key);
+}
+
+/*
+ * Duas repetições, 3 ciclos de aquecimento (já descartados por quem
+ * chama benchrun_cycle). Repetição 1: 4 ciclos de 0,5 s com 100 agentes
+ * e 1000 células -> 200 agentes/s, 2000 células/s. Repetição 2: 2 ciclos
+ * de 0,25 s -> 400 agentes/s, 4000 células/s. Fase season constante em
+ * 10 ms; halo 2 ms na primeira repetição e 5 ms na segunda.
+ */
+static void two_reps(BenchRun *b) {
+    double times[CYCLEPERF_NTIMES] = {0};
+    benchrun_init(b, 2, 3);
+
+    times[0] = 0.5;
+    times[1] = 0.010;
+    times[2] = 0.002;
+    for (int c = 0; c < 4; c++)
+        benchrun_cycle(b, times, 100, 1000.0);
+    benchrun_end_rep(b);
+
+    times[0] = 0.25;
+    times[2] = 0.005;
+    for (int c = 0; c < 2; c++)
+        benchrun_cycle(b, times, 100, 1000.0);
+    benchrun_end_rep(b);
+}
+
+TEST(rates_per_repetition) {
+    BenchRun b;
+    two_reps(&b);
+    ASSERT_EQ(b.reps, 2);
+    ASSERT_EQ(b.cycles, 6);
+    ASSERT_NEAR(b.agent_rate[0], 200.0, 1e-9);
+    ASSERT_NEAR(b.agent_rate[1], 400.0, 1e-9);
+    ASSERT_NEAR(b.cell_rate[0], 2000.0, 1e-9);
+    ASSERT_NEAR(b.cell_rate[1], 4000.0, 1e-9);
+    ASSERT_NEAR(benchrun_agent_rate(&b), 300.0, 1e-9);
+    benchrun_free(&b);
+}
+
+TEST(json_fields) {
+    BenchRun  b;
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    cfg.global_w     = 64;
+    cfg.global_h     = 48;
+    cfg.num_agents   = 500;
+    cfg.total_cycles = 9;
+    cfg.seed         = 1234;
+    two_reps(&b);
+    capture_print(&b, &cfg, 2, 3, 0.0);
+
+    ASSERT_TRUE(strstr(report, "\"grid\": [64, 48]") != NULL);
+    ASSERT_NEAR(field("\"agents\": "), 500, 0);
+    ASSERT_NEAR(field("\"cycles\": "), 9, 0);
+    ASSERT_NEAR(field("\"ranks\": "), 2, 0);
+    ASSERT_NEAR(field("\"threads\": "), 3, 0);
+    ASSERT_NEAR(field("\"seed\": "), 1234, 0);
+    ASSERT_TRUE(strstr(report, "\"model\": null") != NULL);
+    ASSERT_NEAR(field("\"reps\": "), 2, 0);
+    ASSERT_NEAR(field("\"warmup_cycles\": "), 3, 0);
+    ASSERT_NEAR(field("\"measured_cycles\": "), 6, 0);
+
+    /* Desvio amostral de {200, 400}: 100 * sqrt(2). */
+    ASSERT_NEAR(field("\"agent_updates_per_s\": {\"mean\": "), 300.0, 0.05);
+    ASSERT_NEAR(field_after(strstr(report, "\"agent_updates_per_s\""),
+                            "\"stddev\": "), 141.4, 0.05);
+    ASSERT_NEAR(field("\"cell_updates_per_s\": {\"mean\": "), 3000.0, 0.05);
+    ASSERT_NEAR(field("\"agent_updates_per_s_per_core\": "), 50.0, 0.05);
+
+    /* Média e desvio de cada fase sobre os 6 ciclos medidos, em ms. */
+    static const char *const names[CYCLEPERF_NTIMES] = {
+        "cycle", "season", "halo", "workload", "agent", "reproduce",
+        "grid", "migrate", "metrics", "render", "overlap", "spread"
+    };
+    const char *phases = strstr(report, "\"phases_ms\"");
+    ASSERT_TRUE(phases != NULL);
+    for (int k = 0; k < CYCLEPERF_NTIMES; k++) {
+        char key[64];
+        snprintf(key, sizeof(key), "\"%s\": {\"mean\": ", names[k]);
+        ASSERT_TRUE(strstr(phases, key) != NULL);
+    }
+    ASSERT_NEAR(field_after(phases, "\"cycle\": {\"mean\": "),
+                1000.0 * 2.5 / 6.0, 1e-3);
+    ASSERT_NEAR(field_after(phases, "\"season\": {\"mean\": "), 10.0, 1e-3);
+    ASSERT_NEAR(field_after(strstr(phases, "\"season\""), "\"stddev\": "),
+                0.0, 1e-3);
+    /* halo {2,2,2,2,5,5}: média 3, variância 12/5. */
+    ASSERT_NEAR(field_after(phases, "\"halo\": {\"mean\": "), 3.0, 1e-3);
+    ASSERT_NEAR(field_after(strstr(phases, "\"halo\""), "\"stddev\": "),
+                sqrt(12.0 / 5.0), 1e-3);
+    benchrun_free(&b);
+}
+
+TEST(efficiency_with_reference) {
+    BenchRun  b;
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    two_reps(&b);
+
+    /* 300 agentes/s em 2 x 3 núcleos contra 25/s num só: 300 / 150. */
+    capture_print(&b, &cfg, 2, 3, 25.0);
+    ASSERT_NEAR(field("\"parallel_efficiency\": "), 2.0, 1e-4);
+    ASSERT_NEAR(field("\"reference_agent_updates_per_s\": "), 25.0, 0.05);
+
+    capture_print(&b, &cfg, 4, 1, 100.0);
+    ASSERT_NEAR(field("\"parallel_efficiency\": "), 0.75, 1e-4);
+    benchrun_free(&b);
+}
+
+TEST(efficiency_without_reference) {
+    BenchRun  b;
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    two_reps(&b);
+
+    /* Um núcleo é a própria referência. */
+    capture_print(&b, &cfg, 1, 1, 0.0);
+    ASSERT_NEAR(field("\"parallel_efficiency\": "), 1.0, 0);
+    ASSERT_TRUE(strstr(report,
+                "\"reference_agent_updates_per_s\": null") != NULL);
+
+    capture_print(&b, &cfg, 2, 2, 0.0);
+    ASSERT_TRUE(strstr(report, "\"parallel_efficiency\": null") != NULL);
+    ASSERT_TRUE(strstr(report,
+                "\"reference_agent_updates_per_s\": null") != NULL);
+    benchrun_free(&b);
+}
+
+/* Vazão constante de `rate` agentes/s numa repetição de 2 ciclos. */
+static void weak_point(WeakPoint *w, int ranks, double rate) {
+    double times[CYCLEPERF_NTIMES] = {0};
+    w->ranks    = ranks;
+    w->global_w = 32 * ranks;
+    w->global_h = 32;
+    w->agents   = 100 * ranks;
+    benchrun_init(&w->run, 1, 0);
+    times[0] = 0.5;
+    benchrun_cycle(&w->run, times, (int)(rate * 0.5), 0.0);
+    benchrun_cycle(&w->run, times, (int)(rate * 0.5), 0.0);
+    benchrun_end_rep(&w->run);
+}
+
+TEST(weak_scaling_efficiency) {
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    WeakPoint pts[2];
+    weak_point(&pts[0], 1, 100.0);
+    weak_point(&pts[1], 4, 360.0);
+
+    FILE *f = tmpfile();
+    benchrun_weak_print(f, pts, 2, &cfg, 1);
+    rewind(f);
+    size_t n = fread(report, 1, sizeof(report) - 1, f);
+    report[n] = '\0';
+    fclose(f);
+
+    /* Eficiência = vazão por rank relativa ao ponto de 1 rank. */
+    const char *p1 = strstr(report, "{\"ranks\": 4");
+    ASSERT_TRUE(p1 != NULL);
+    ASSERT_NEAR(field("\"efficiency\": "), 1.0, 1e-4);
+    ASSERT_NEAR(field_after(p1, "\"efficiency\": "), 0.9, 1e-4);
+    ASSERT_TRUE(strstr(p1, "\"grid\": [128, 32]") != NULL);
+    ASSERT_NEAR(field_after(p1, "\"cycle_ms\": {\"mean\": "), 500.0, 1e-3);
+    for (int i = 0; i < 2; i++)
+        benchrun_free(&pts[i].run);
+}
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    /* Só o rank 0 narra; as falhas de todos entram no resultado. */
+    if (rank != 0 && !freopen("/dev/null", "w", stdout))
+        return 1;
+    printf("benchrun\n");
+    RUN_TEST(rates_per_repetition);
+    RUN_TEST(json_fields);
+    RUN_TEST(efficiency_with_reference);
+    RUN_TEST(efficiency_without_reference);
+    RUN_TEST(weak_scaling_efficiency);
+
+    int failed;
+    MPI_Allreduce(&_test_fail_count, &failed, 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    printf("── benchrun: %d passed, %d failed (all ranks) ──\n",
+           _test_pass_count, failed);
+    MPI_Finalize();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * Matriz de comunicação (commmat.c), com 4 ranks: cada rank registra um
+ * plano fixo de mensagens, e o arquivo de commmat_write traz em cada
+ * célula (remetente, destinatário) os bytes e as mensagens do plano,
+ * os totais por ciclo, o histograma de tamanhos e os migrantes.
+ *
+ * mpirun -np 4 ./test_mpi_commmat (make test-mpi)
+ */
+#include "test_harness.h"
+#include "commmat.h"
+#include "partition.h"
+
+#include <mpi.h>
+#include <string.h>
+
+#define CM_PATH  "test_mpi_commmat.csv"
+#define CM_PLAN  7
+#define CM_MAX_R 16
+
+static int  rank, nranks;
+static char file[1 << 16];
+
+/*
+ * Entrada k do plano do remetente s: k < 3 no ciclo 0, as demais no
+ * ciclo 1. As duas últimas vão a destinos inválidos (MPI_PROC_NULL e
+ * além do último rank) e não devem aparecer em lugar nenhum.
+ */
+static void plan(int s, int k, WirePhase *ph, int *dest, uint64_t *bytes) {
+    switch (k) {
+    case 0: case 1:
+        *ph = WIRE_PHASE_HALO;    *dest = (s + 1) % nranks;
+        *bytes = 100u * (uint64_t)(s + 1);
+        break;
+    case 2:
+        *ph = WIRE_PHASE_HALO;    *dest = (s + nranks - 1) % nranks;
+        *bytes = 10;
+        break;
+    case 3:
+        *ph = WIRE_PHASE_MIGRATE; *dest = (s + 2) % nranks;
+        *bytes = 8u * (uint64_t)(s + 1);
+        break;
+    case 4:
+        *ph = WIRE_PHASE_GATHER;  *dest = 0;
+        *bytes = 4096;
+        break;
+    case 5:
+        *ph = WIRE_PHASE_HALO;    *dest = -1;
+        *bytes = 999;
+        break;
+    default:
+        *ph = WIRE_PHASE_HALO;    *dest = nranks;
+        *bytes = 999;
+        break;
+    }
+}
+
+/* Esperado pelo plano de todos os ranks: bytes ou mensagens. */
+static uint64_t expected(WirePhase want, int s, int d, int msgs) {
+    uint64_t sum = 0;
+    for (int k = 0; k < CM_PLAN; k++) {
+        WirePhase ph;
+        int       dest;
+        uint64_t  bytes;
+        plan(s, k, &ph, &dest, &bytes);
+        if (ph == want && dest == d)
+            sum += msgs ? 1 : bytes;
+    }
+    return sum;
+}
+
+/*
+ * Lê a matriz da seção `title` (nranks linhas "src,v0,v1,...") em m.
+ * Retorna 0, ou -1 se a seção ou uma linha não bate.
+ */
+static int read_matrix(const char *title, uint64_t *m) {
+    const char *p = strstr(file, title);
+    if (!p || !(p = strchr(p, '\n')) || !(p = strchr(p + 1, '\n')))
+        return -1;
+    for (int s = 0; s < nranks; s++) {
+        char *end;
+        if (strtol(p + 1, &end, 10) != s) return -1;
+        for (int d = 0; d < nranks; d++) {
+            if (*end != ',') return -1;
+            m[s * nranks + d] = strtoull(end + 1, &end, 10);
+        }
+        p = end;
+    }
+    return 0;
+}
+
+/* Linha que segue `header` no arquivo, ou NULL. */
+static const char *line_after(const char *header) {
+    const char *p = strstr(file, header);
+    return p ? p + strlen(header) : NULL;
+}
+
+static double nbr_share;
+static int    write_rc;
+
+TEST(write_report) {
+    Partition p;
+    partition_init(&p, 40, 30, MPI_COMM_WORLD);
+    commmat_init(nranks);
+    int enabled = commmat_enabled;
+
+    for (int k = 0; k < CM_PLAN; k++) {
+        WirePhase ph;
+        int       dest;
+        uint64_t  bytes;
+        plan(rank, k, &ph, &dest, &bytes);
+        commmat_send(ph, dest, bytes);
+        if (k == 2) commmat_end_cycle();
+    }
+    commmat_end_cycle();
+    commmat_migrant(rank % 8);
+    commmat_migrant(COMMMAT_DIR_OTHER);
+
+    write_rc = commmat_write(CM_PATH, &p, &nbr_share);
+    partition_destroy(&p);
+
+    /* Só o rank 0 tem o arquivo; os outros leem a cópia dele. As
+     * verificações ficam depois das coletivas. */
+    int n = 0;
+    if (rank == 0 && write_rc == 0) {
+        FILE *f = fopen(CM_PATH, "r");
+        if (f) {
+            n = (int)fread(file, 1, sizeof(file) - 1, f);
+            fclose(f);
+        }
+        remove(CM_PATH);
+    }
+    MPI_Bcast(&write_rc, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(file, n, MPI_CHAR, 0, MPI_COMM_WORLD);
+    file[n] = '\0';
+    ASSERT_TRUE(enabled);
+    ASSERT_TRUE(!commmat_enabled);
+    ASSERT_EQ(write_rc, 0);
+    ASSERT_TRUE(n > 0);
+}
+
+static void check_matrices(WirePhase ph, const char *name) {
+    uint64_t got[CM_MAX_R * CM_MAX_R];
+    char     title[64];
+    for (int msgs = 0; msgs <= 1; msgs++) {
+        snprintf(title, sizeof(title), "# %s %s (row = sender", name,
+                 msgs ? "messages" : "bytes");
+        ASSERT_EQ(read_matrix(title, got), 0);
+        for (int s = 0; s < nranks; s++)
+            for (int d = 0; d < nranks; d++)
+                ASSERT_EQ(got[s * nranks + d], expected(ph, s, d, msgs));
+    }
+}
+
+TEST(per_peer_bytes_and_messages) {
+    check_matrices(WIRE_PHASE_HALO, "halo");
+    check_matrices(WIRE_PHASE_MIGRATE, "migrate");
+    check_matrices(WIRE_PHASE_GATHER, "gather");
+}
+
+TEST(per_cycle_totals) {
+    /* cycle,halo_bytes,halo_msgs,migrate_bytes,migrate_msgs,gather_... */
+    uint64_t want[2][WIRE_PHASE_COUNT * 2] = {{0}};
+    for (int s = 0; s < nranks; s++)
+        for (int k = 0; k < CM_PLAN; k++) {
+            WirePhase ph;
+            int       dest;
+            uint64_t  bytes;
+            plan(s, k, &ph, &dest, &bytes);
+            if (dest < 0 || dest >= nranks) continue;
+            want[k > 2][2 * ph]     += bytes;
+            want[k > 2][2 * ph + 1] += 1;
+        }
+
+    const char *p = line_after("migrate_msgs,gather_bytes,gather_msgs\n");
+    ASSERT_TRUE(p != NULL);
+    for (int c = 0; c < 2; c++) {
+        char *end;
+        ASSERT_EQ(strtol(p, &end, 10), c);
+        for (int k = 0; k < WIRE_PHASE_COUNT * 2; k++) {
+            ASSERT_EQ(*end, ',');
+            ASSERT_EQ(strtoull(end + 1, &end, 10), want[c][k]);
+        }
+        ASSERT_EQ(*end, '\n');
+        p = end + 1;
+    }
+    ASSERT_EQ(*p, '\0');
+}
+
+TEST(size_histogram) {
+    /* Só o gather tem mensagens de 4096 bytes: uma por rank. */
+    char row[64];
+    snprintf(row, sizeof(row), "\n4096,0,0,%d\n", nranks);
+    ASSERT_TRUE(strstr(file, row) != NULL);
+    /* Os destinos inválidos (999 bytes) não entram no histograma. */
+    ASSERT_TRUE(strstr(file, "\n512,") == NULL);
+}
+
+TEST(migrants_per_direction) {
+    uint64_t dir[COMMMAT_DIRS] = {0};
+    for (int s = 0; s < nranks; s++)
+        dir[s % 8]++;
+    dir[COMMMAT_DIR_OTHER] = (uint64_t)nranks;
+
+    const char *p = line_after("N,S,E,W,NE,NW,SE,SW,other\n");
+    ASSERT_TRUE(p != NULL);
+    for (int d = 0; d < COMMMAT_DIRS; d++) {
+        char *end;
+        ASSERT_EQ(strtoull(p, &end, 10), dir[d]);
+        ASSERT_EQ(*end, d + 1 < COMMMAT_DIRS ? ',' : '\n');
+        p = end + 1;
+    }
+    /* Metade dos migrantes foi ao vizinho da direção (só no rank 0). */
+    if (rank == 0)
+        ASSERT_NEAR(nbr_share, 0.5, 1e-12);
+}
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+    /* Só o rank 0 narra; as falhas de todos entram no resultado. */
+    if (rank != 0 && !freopen("/dev/null", "w", stdout))
+        return 1;
+    printf("commmat (%d ranks)\n", nranks);
+    if (nranks > CM_MAX_R) {
+        printf("  at most %d ranks\n", CM_MAX_R);
+        MPI_Finalize();
+        return 1;
+    }
+    RUN_TEST(write_report);
+    RUN_TEST(per_peer_bytes_and_messages);
+    RUN_TEST(per_cycle_totals);
+    RUN_TEST(size_histogram);
+    RUN_TEST(migrants_per_direction);
+
+    int failed;
+    MPI_Allreduce(&_test_fail_count, &failed, 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    printf("── commmat: %d passed, %d failed (all ranks) ──\n",
+           _test_pass_count, failed);
+    MPI_Finalize();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Backends de halo (halo.c), com 4 ranks: todo backend chega às mesmas
+ * células que o isend numa sequência de trocas e regenerações, e o
+ * modo partitioned monta o backend efetivo — particionado com MPI-4 e
+ * MPI_THREAD_MULTIPLE, persistent caso contrário.
+ *
+ * mpirun -np 4 ./test_mpi_halo (make test-mpi)
+ */
+#include "test_harness.h"
+#include "grid.h"
+#include "halo.h"
+#include "pack.h"
+#include "partition.h"
+
+#include <mpi.h>
+#include <string.h>
+
+#define HT_W      40
+#define HT_H      30
+#define HT_CYCLES 4
+
+static int provided;
+
+/*
+ * Grade inicial, uma troca e então HT_CYCLES ciclos de regeneração
+ * (com envio do próximo ciclo) seguida de troca, alternando estações,
+ * como em run_simulation. Devolve as células (halo incluído) em out.
+ */
+static int run_backend(HaloMode mode, int width, Cell *out,
+                       HaloMode *built) {
+    Partition p;
+    SubGrid sg;
+    HaloCtx ctx;
+    Arena arena;
+    partition_init(&p, HT_W, HT_H, MPI_COMM_WORLD);
+    subgrid_create(&sg, &p, HT_W, HT_H, width);
+    subgrid_init(&sg, &p, 77);
+    arena_init(&arena, 1 << 14);
+    halo_init(&ctx, mode, &sg, &p);
+    *built = ctx.mode;
+
+    halo_exchange(&ctx, &sg, &p, &arena);
+    for (int cycle = 0; cycle < HT_CYCLES; cycle++) {
+        Season s = (cycle & 1) ? WET : DRY;
+        arena_reset(&arena);
+        subgrid_set_season(&sg, s);
+        halo_update_and_send(&ctx, &sg, s, 1, NULL);
+        halo_exchange(&ctx, &sg, &p, &arena);
+    }
+
+    halo_destroy(&ctx, &sg);
+    int n = sg.halo_w * sg.halo_h;
+    memcpy(out, sg.cells, sizeof(Cell) * (size_t)n);
+    arena_destroy(&arena);
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+    return n;
+}
+
+/* Cell tem padding: compara campo a campo. */
+static int same_cells(const Cell *a, const Cell *b, int n) {
+    for (int i = 0; i < n; i++)
+        if (a[i].type != b[i].type || a[i].resource != b[i].resource ||
+            a[i].max_resource != b[i].max_resource)
+            return 0;
+    return 1;
+}
+
+TEST(effective_mode) {
+    ASSERT_EQ(halo_effective_mode(HALO_ISEND), HALO_ISEND);
+    ASSERT_EQ(halo_effective_mode(HALO_SHM), HALO_SHM);
+    ASSERT_EQ(halo_effective_mode(HALO_PERSISTENT), HALO_PERSISTENT);
+    ASSERT_EQ(halo_effective_mode(HALO_RMA), HALO_RMA);
+#if MPI_VERSION >= 4
+    ASSERT_EQ(halo_effective_mode(HALO_PARTITIONED),
+              provided >= MPI_THREAD_MULTIPLE ? HALO_PARTITIONED
+                                              : HALO_PERSISTENT);
+#else
+    /* Sem MPI-4 o caminho particionado nem é compilado. */
+    ASSERT_EQ(halo_effective_mode(HALO_PARTITIONED), HALO_PERSISTENT);
+#endif
+}
+
+static void check_backends(int width) {
+    static Cell ref[(HT_W + 8) * (HT_H + 8)], got[(HT_W + 8) * (HT_H + 8)];
+    HaloMode built;
+    int n = run_backend(HALO_ISEND, width, ref, &built);
+    ASSERT_EQ(built, HALO_ISEND);
+
+    const HaloMode modes[] = {
+        HALO_SHM, HALO_PERSISTENT, HALO_RMA, HALO_PARTITIONED
+    };
+    for (int m = 0; m < 4; m++) {
+        int same, all_same;
+        ASSERT_EQ(run_backend(modes[m], width, got, &built), n);
+        ASSERT_EQ(built, halo_effective_mode(modes[m]));
+        same = same_cells(ref, got, n);
+        MPI_Allreduce(&same, &all_same, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (!all_same)
+            printf("  backend %s differs from isend\n",
+                   halo_mode_name(modes[m]));
+        ASSERT_TRUE(all_same);
+    }
+}
+
+TEST(backends_match_isend) {
+    check_backends(1);
+}
+
+TEST(backends_match_isend_deep_halo) {
+    check_backends(4);
+}
+
+int main(int argc, char **argv) {
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    pack_set_quant(WIRE_DOUBLE);
+    pack_types_init();
+
+    /* Só o rank 0 narra; as falhas de todos entram no resultado. */
+    if (rank != 0 && !freopen("/dev/null", "w", stdout))
+        return 1;
+    printf("halo (MPI %d.%d, thread level %d)\n",
+           MPI_VERSION, MPI_SUBVERSION, provided);
+    RUN_TEST(effective_mode);
+    RUN_TEST(backends_match_isend);
+    RUN_TEST(backends_match_isend_deep_halo);
+
+    int failed;
+    MPI_Allreduce(&_test_fail_count, &failed, 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    printf("── halo: %d passed, %d failed (all ranks) ──\n",
+           _test_pass_count, failed);
+    pack_types_free();
+    MPI_Finalize();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Relatório do --wait-report (mpiprof.c), com 4 ranks: percentis de
+ * posto mais próximo sobre ciclos × ranks, custo do desbalanceamento,
+ * rank mais lento e caminho crítico a partir de tempos de fase
+ * sintéticos; e a separação espera × transferência das coletivas
+ * interceptadas, com um rank que chega atrasado.
+ *
+ * mpirun -np 4 ./test_mpi_mpiprof (make test-mpi)
+ */
+#include "test_harness.h"
+#include "mpiprof.h"
+
+#include <mpi.h>
+#include <string.h>
+
+#define MP_CYCLES 10
+
+static int  rank, nranks;
+static char report[8192];
+
+static const char *const names[] = { "compute", "exchange" };
+
+/* Relatório do rank 0 em report; vazio nos demais. Coletiva. */
+static void capture_report(void) {
+    FILE *f = tmpfile();
+    waitrep_print(f, MPI_COMM_WORLD);
+    rewind(f);
+    size_t n = fread(report, 1, sizeof(report) - 1, f);
+    report[n] = '\0';
+    fclose(f);
+}
+
+/* Linha da fase: p50, p95, p99, max (ms), imbalance_s e slowest. */
+static int phase_row(const char *name, double v[5], int *slowest) {
+    char key[32];
+    snprintf(key, sizeof(key), "\n%-10s ", name);
+    const char *p = strstr(report, key);
+    if (!p) return -1;
+    return sscanf(p + strlen(key), "%lf %lf %lf %lf %lf %d",
+                  &v[0], &v[1], &v[2], &v[3], &v[4], slowest) == 6 ? 0 : -1;
+}
+
+/* Posto mais próximo (1-based) do percentil `pct` em n amostras. */
+static int nearest_rank(int pct, int n) {
+    return (pct * n + 99) / 100;
+}
+
+/*
+ * compute: no ciclo c o rank r leva (nranks * c + r + 1) ms, então as
+ * amostras ordenadas são 1, 2, ..., ciclos × ranks ms. exchange: 1 ms,
+ * exceto o rank 2, com 5 ms. Ciclo: 10 ms no rank 1, 4 ms nos demais,
+ * sem espera (nenhuma coletiva interceptada no meio).
+ */
+TEST(percentiles_and_imbalance) {
+    const int slow_x = 2 % nranks, slow_c = 1 % nranks;
+    waitrep_begin(2, names, MPI_COMM_WORLD);
+    for (int c = 0; c < MP_CYCLES; c++) {
+        double t[2];
+        t[0] = 1e-3 * (nranks * c + rank + 1);
+        t[1] = rank == slow_x ? 5e-3 : 1e-3;
+        waitrep_cycle(t, rank == slow_c ? 10e-3 : 4e-3, MPI_COMM_WORLD);
+    }
+    capture_report();
+    if (rank != 0) return;
+
+    const int ns = MP_CYCLES * nranks;
+    const int pct[3] = { 50, 95, 99 };
+    double v[5];
+    int    slowest;
+    ASSERT_TRUE(strstr(report, "10 cycles x") != NULL);
+
+    /* Por ciclo o máximo passa da média em (nranks - 1) / 2 ms. */
+    ASSERT_EQ(phase_row("compute", v, &slowest), 0);
+    for (int i = 0; i < 3; i++)
+        ASSERT_NEAR(v[i], nearest_rank(pct[i], ns), 1e-9);
+    ASSERT_NEAR(v[3], ns, 1e-9);
+    ASSERT_NEAR(v[4], MP_CYCLES * 1e-3 * (nranks - 1) / 2.0, 1e-4);
+    ASSERT_EQ(slowest, nranks - 1);
+
+    /* As (nranks - 1) × ciclos menores amostras valem 1 ms. */
+    ASSERT_EQ(phase_row("exchange", v, &slowest), 0);
+    for (int i = 0; i < 3; i++)
+        ASSERT_NEAR(v[i],
+                    nearest_rank(pct[i], ns) <= MP_CYCLES * (nranks - 1)
+                        ? 1.0 : 5.0, 1e-9);
+    ASSERT_NEAR(v[3], 5.0, 1e-9);
+    ASSERT_NEAR(v[4], MP_CYCLES * (5e-3 - (4e-3 + nranks * 1e-3) / nranks),
+                1e-4);
+    ASSERT_EQ(slowest, slow_x);
+
+    /* Ciclo inteiro: o rank 1 é o caminho crítico de todos os ciclos. */
+    const double mean_c = (10e-3 + (nranks - 1) * 4e-3) / nranks;
+    ASSERT_EQ(phase_row("cycle", v, &slowest), 0);
+    ASSERT_NEAR(v[3], 10.0, 1e-9);
+    ASSERT_NEAR(v[4], MP_CYCLES * (10e-3 - mean_c), 1e-4);
+    ASSERT_EQ(slowest, slow_c);
+
+    char crit[64];
+    snprintf(crit, sizeof(crit), "Critical path: rank %d in %d/%d cycles\n",
+             slow_c, MP_CYCLES, MP_CYCLES);
+    ASSERT_TRUE(strstr(report, crit) != NULL);
+    const char *cost = strstr(report, "Imbalance cost: ");
+    ASSERT_TRUE(cost != NULL);
+    ASSERT_NEAR(strtod(cost + strlen("Imbalance cost: "), NULL),
+                MP_CYCLES * (10e-3 - mean_c), 1e-4);
+    /* Nenhuma coletiva interceptada durante o relatório. */
+    ASSERT_TRUE(strstr(report, "allreduce") == NULL);
+}
+
+/* Ocupa o rank por `s` segundos sem chamar MPI. */
+static void busy(double s) {
+    double t0 = MPI_Wtime();
+    while (MPI_Wtime() - t0 < s)
+        ;
+}
+
+/*
+ * Todos os ranks menos o 0 trabalham 0,1 s antes de cada uma das 3
+ * reduções do ciclo: o rank 0 passa esse tempo na barreira, que conta
+ * como espera dele, e não entra no caminho crítico.
+ */
+TEST(wait_goes_to_the_early_rank) {
+    const double late = 0.1;
+    int    one = 1, sum = 0;
+    double none[1];
+    waitrep_begin(0, names, MPI_COMM_WORLD);
+    for (int c = 0; c < 2; c++) {
+        double t0 = MPI_Wtime();
+        for (int k = 0; k < 3; k++) {
+            if (rank != 0) busy(late);
+            MPI_Allreduce(&one, &sum, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        }
+        waitrep_cycle(none, MPI_Wtime() - t0, MPI_COMM_WORLD);
+    }
+    capture_report();
+    ASSERT_EQ(sum, nranks);
+    if (rank != 0 || nranks < 2) return;
+
+    /* allreduce: 6 chamadas por rank; espera somada >= a do rank 0. */
+    long long calls;
+    double    wait, xfer;
+    const char *p = strstr(report, "\nallreduce ");
+    ASSERT_TRUE(p != NULL);
+    ASSERT_EQ(sscanf(p + strlen("\nallreduce "), "%lld %lf %lf",
+                     &calls, &wait, &xfer), 3);
+    ASSERT_EQ(calls, 6);
+    ASSERT_TRUE(wait >= 6 * late * 0.9);
+    ASSERT_TRUE(xfer >= 0.0);
+    ASSERT_TRUE(strstr(report, "\nalltoall ") == NULL);
+
+    const char *crit = strstr(report, "Critical path:");
+    ASSERT_TRUE(crit != NULL);
+    ASSERT_TRUE(strstr(crit, "rank 0 in") == NULL);
+}
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+    /* Só o rank 0 narra; as falhas de todos entram no resultado. */
+    if (rank != 0 && !freopen("/dev/null", "w", stdout))
+        return 1;
+    printf("mpiprof (%d ranks)\n", nranks);
+    RUN_TEST(percentiles_and_imbalance);
+    RUN_TEST(wait_goes_to_the_early_rank);
+
+    int failed;
+    MPI_Allreduce(&_test_fail_count, &failed, 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    printf("── mpiprof: %d passed, %d failed (all ranks) ──\n",
+           _test_pass_count, failed);
+    MPI_Finalize();
+    return failed > 0 ? 1 : 0;
+}
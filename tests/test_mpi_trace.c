@@ -0,0 +1,187 @@
+/*
+ * Linha do tempo (trace.c), com 4 ranks de 3 threads: os eventos de cada
+ * anel chegam ao arquivo na ordem em que foram gravados, com fase, ciclo
+ * e thread certos, e um anel que dá a volta entre dois flushes guarda só
+ * os TRACE_RING_EVENTS mais recentes e conta os demais como perdidos.
+ *
+ * mpirun -np 4 ./test_mpi_trace (make test-mpi)
+ */
+#include "test_harness.h"
+#include "trace.h"
+
+#include <mpi.h>
+#include <omp.h>
+#include <string.h>
+
+#define TT_PATH    "test_mpi_trace.json"
+#define TT_THREADS 3
+#define TT_SERIAL  50
+#define TT_PER_THR 20
+
+typedef struct {
+    char   name[16];
+    int    pid, tid, cycle;
+    double ts, dur;
+} Ev;
+
+static int rank, nranks;
+static Ev *evs;
+static int nevs, meta;
+
+/* Mesma ordem de TracePhase. */
+static const char *const phase_names[TR_PHASES] = {
+    "cycle", "season", "halo", "workload", "lpt_plan", "decide",
+    "reproduce", "migrate", "grid", "metrics", "reduce", "output",
+    "tasks", "autotune", "mpi_wait"
+};
+
+/*
+ * Lê os eventos "X" do arquivo (rank 0) para evs, na ordem do arquivo,
+ * e conta os metadados de nome de processo em meta. Retorna 0, ou -1 se
+ * o arquivo não abre ou não fecha o JSON.
+ */
+static int load(void) {
+    FILE *f = fopen(TT_PATH, "r");
+    if (!f) return -1;
+    char line[512];
+    int  cap = 1024, closed = 0;
+    nevs = meta = 0;
+    evs  = realloc(evs, sizeof(Ev) * (size_t)cap);
+    while (fgets(line, sizeof(line), f)) {
+        Ev e;
+        if (strstr(line, "\"process_name\""))
+            meta++;
+        if (strcmp(line, "]}\n") == 0)
+            closed = 1;
+        if (sscanf(line, "{\"name\":\"%15[^\"]\",\"ph\":\"X\",\"pid\":%d,"
+                   "\"tid\":%d,\"ts\":%lf,\"dur\":%lf,\"args\":{\"cycle\":%d}}",
+                   e.name, &e.pid, &e.tid, &e.ts, &e.dur, &e.cycle) != 6)
+            continue;
+        if (nevs == cap) {
+            cap *= 2;
+            evs  = realloc(evs, sizeof(Ev) * (size_t)cap);
+        }
+        evs[nevs++] = e;
+    }
+    fclose(f);
+    remove(TT_PATH);
+    return closed ? 0 : -1;
+}
+
+static void record(TracePhase ph) {
+    double t0 = trace_begin();
+    trace_end(ph, t0);
+}
+
+static long long lost;
+static int       init_rc;
+
+TEST(events_in_order) {
+    init_rc = trace_init(TT_PATH, MPI_COMM_WORLD);
+    for (int k = 0; k < TT_SERIAL; k++) {
+        trace_set_cycle(k);
+        record((TracePhase)(k % TR_PHASES));
+    }
+    /* Cada thread da equipe grava no próprio anel. */
+    trace_set_cycle(TT_SERIAL);
+    #pragma omp parallel num_threads(TT_THREADS)
+    for (int k = 0; k < TT_PER_THR; k++)
+        record(TR_DECIDE);
+    lost = trace_finalize(MPI_COMM_WORLD);
+
+    ASSERT_EQ(init_rc, 0);
+    if (rank != 0) return;
+    ASSERT_EQ(lost, 0);
+    ASSERT_EQ(load(), 0);
+    ASSERT_EQ(meta, nranks);
+    ASSERT_EQ(nevs, nranks * (TT_SERIAL + TT_THREADS * TT_PER_THR));
+
+    /* Por rank: anel 0 (os eventos seriais e os da thread 0 da equipe),
+     * depois os anéis 1 e 2, cada um em ordem de gravação. */
+    const Ev *e = evs;
+    for (int r = 0; r < nranks; r++) {
+        for (int k = 0; k < TT_SERIAL; k++, e++) {
+            ASSERT_EQ(e->pid, r);
+            ASSERT_EQ(e->tid, 0);
+            ASSERT_EQ(e->cycle, k);
+            ASSERT_TRUE(strcmp(e->name, phase_names[k % TR_PHASES]) == 0);
+            ASSERT_TRUE(e->dur >= 0.0);
+            if (k > 0)
+                ASSERT_TRUE(e->ts >= e[-1].ts);
+        }
+        for (int t = 0; t < TT_THREADS; t++) {
+            for (int k = 0; k < TT_PER_THR; k++, e++) {
+                ASSERT_EQ(e->pid, r);
+                ASSERT_EQ(e->tid, t);
+                ASSERT_EQ(e->cycle, TT_SERIAL);
+                ASSERT_TRUE(strcmp(e->name, "decide") == 0);
+                if (k > 0)
+                    ASSERT_TRUE(e->ts >= e[-1].ts);
+            }
+        }
+    }
+}
+
+TEST(ring_wraparound) {
+    /* 10 eventos e um flush; depois TRACE_RING_EVENTS + 5 sem flush: os
+     * 5 mais antigos do segundo lote são sobrescritos. */
+    const int first = 10, over = 5;
+    init_rc = trace_init(TT_PATH, MPI_COMM_WORLD);
+    for (int k = 0; k < first; k++) {
+        trace_set_cycle(k);
+        record(TR_HALO);
+    }
+    trace_flush(MPI_COMM_WORLD);
+    for (int k = 0; k < TRACE_RING_EVENTS + over; k++) {
+        trace_set_cycle(first + k);
+        record(TR_GRID);
+    }
+    lost = trace_finalize(MPI_COMM_WORLD);
+
+    ASSERT_EQ(init_rc, 0);
+    if (rank != 0) return;
+    ASSERT_EQ(lost, (long long)over * nranks);
+    ASSERT_EQ(load(), 0);
+    ASSERT_EQ(nevs, nranks * (first + TRACE_RING_EVENTS));
+
+    /* Primeiro flush: os 10 de cada rank; o último, os sobreviventes. */
+    const Ev *e = evs;
+    for (int r = 0; r < nranks; r++)
+        for (int k = 0; k < first; k++, e++) {
+            ASSERT_EQ(e->pid, r);
+            ASSERT_EQ(e->cycle, k);
+        }
+    for (int r = 0; r < nranks; r++)
+        for (int k = 0; k < TRACE_RING_EVENTS; k++, e++) {
+            ASSERT_EQ(e->pid, r);
+            ASSERT_EQ(e->cycle, first + over + k);
+            ASSERT_TRUE(strcmp(e->name, "grid") == 0);
+            if (k > 0)
+                ASSERT_TRUE(e->ts >= e[-1].ts);
+        }
+}
+
+int main(int argc, char **argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+    /* trace_init dimensiona os anéis pela equipe. */
+    omp_set_num_threads(TT_THREADS);
+
+    /* Só o rank 0 narra; as falhas de todos entram no resultado. */
+    if (rank != 0 && !freopen("/dev/null", "w", stdout))
+        return 1;
+    printf("trace (%d ranks x %d threads)\n", nranks, TT_THREADS);
+    RUN_TEST(events_in_order);
+    RUN_TEST(ring_wraparound);
+
+    int failed;
+    MPI_Allreduce(&_test_fail_count, &failed, 1, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    printf("── trace: %d passed, %d failed (all ranks) ──\n",
+           _test_pass_count, failed);
+    free(evs);
+    MPI_Finalize();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Formato do fio (pack.c): tamanho por célula e ida e volta em cada
+ * quantização.
+ */
+#include "test_harness.h"
+#include "grid.h"
+#include "pack.h"
+
+#include <string.h>
+
+#define BH 5
+#define BW 7
+#define STRIDE 9
+
+/* Bloco BH × BW dentro de um array com STRIDE colunas; recurso em
+ * [0, max] com max_resource coerente com o tipo, como na grade. */
+static void fill_block(Cell *cells) {
+    for (int r = 0; r < BH; r++)
+        for (int c = 0; c < STRIDE; c++) {
+            Cell *cell = &cells[r * STRIDE + c];
+            cell->type         = (CellType)((r * STRIDE + c) % CELL_TYPES);
+            cell->max_resource = grid_max_resource(cell->type);
+            cell->resource     = cell->max_resource * ((r * 13 + c * 7) % 17) / 16.0;
+        }
+    cells[0].resource = cells[0].max_resource;      /* extremo superior */
+}
+
+static size_t round_trip(WireQuant q, const Cell *src, Cell *dst) {
+    unsigned char buf[BH * BW * 9];
+    pack_set_quant(q);
+    size_t n = pack_cells(src, STRIDE, BH, BW, buf);
+    size_t m = unpack_cells(dst, STRIDE, BH, BW, buf);
+    pack_set_quant(WIRE_DOUBLE);
+    return n == m ? n : 0;
+}
+
+TEST(parse_quant_names) {
+    ASSERT_EQ(pack_parse_quant("double"), WIRE_DOUBLE);
+    ASSERT_EQ(pack_parse_quant("float"), WIRE_FLOAT);
+    ASSERT_EQ(pack_parse_quant("fixed16"), WIRE_FIXED16);
+    ASSERT_EQ(pack_parse_quant("half"), -1);
+}
+
+TEST(cell_bytes_per_mode) {
+    pack_set_quant(WIRE_DOUBLE);
+    ASSERT_EQ(pack_cell_bytes(), 9);
+    pack_set_quant(WIRE_FLOAT);
+    ASSERT_EQ(pack_cell_bytes(), 5);
+    pack_set_quant(WIRE_FIXED16);
+    ASSERT_EQ(pack_cell_bytes(), 3);
+    pack_set_quant(WIRE_DOUBLE);
+}
+
+TEST(double_round_trip_is_exact) {
+    Cell src[BH * STRIDE], dst[BH * STRIDE];
+    fill_block(src);
+    memset(dst, 0, sizeof(dst));
+    ASSERT_EQ(round_trip(WIRE_DOUBLE, src, dst), BH * BW * 9);
+    for (int r = 0; r < BH; r++)
+        for (int c = 0; c < BW; c++) {
+            const Cell *a = &src[r * STRIDE + c], *b = &dst[r * STRIDE + c];
+            ASSERT_EQ(a->type, b->type);
+            ASSERT_TRUE(a->resource == b->resource);
+            ASSERT_TRUE(a->max_resource == b->max_resource);
+        }
+    ASSERT_EQ(dst[BW].type, 0);         /* fora do bloco: intocado */
+}
+
+TEST(float_round_trip_within_float_precision) {
+    Cell src[BH * STRIDE], dst[BH * STRIDE];
+    fill_block(src);
+    memset(dst, 0, sizeof(dst));
+    ASSERT_EQ(round_trip(WIRE_FLOAT, src, dst), BH * BW * 5);
+    for (int r = 0; r < BH; r++)
+        for (int c = 0; c < BW; c++) {
+            const Cell *a = &src[r * STRIDE + c], *b = &dst[r * STRIDE + c];
+            ASSERT_EQ(a->type, b->type);
+            ASSERT_TRUE(b->resource == (double)(float)a->resource);
+        }
+}
+
+TEST(fixed16_round_trip_within_one_step) {
+    Cell src[BH * STRIDE], dst[BH * STRIDE];
+    fill_block(src);
+    memset(dst, 0, sizeof(dst));
+    ASSERT_EQ(round_trip(WIRE_FIXED16, src, dst), BH * BW * 3);
+    for (int r = 0; r < BH; r++)
+        for (int c = 0; c < BW; c++) {
+            const Cell *a = &src[r * STRIDE + c], *b = &dst[r * STRIDE + c];
+            ASSERT_EQ(a->type, b->type);
+            ASSERT_NEAR(b->resource, a->resource, a->max_resource / 65535.0);
+            ASSERT_TRUE(b->resource >= 0.0 && b->resource <= b->max_resource);
+        }
+    ASSERT_TRUE(dst[0].resource == dst[0].max_resource);
+}
+
+/* pack_copy_cells (cópias do --halo shm) deve dar, em cada modo, o mesmo
+ * resultado, campo a campo, de pack_cells + unpack_cells, sem contar bytes. */
+TEST(copy_cells_equals_round_trip) {
+    WireQuant modes[] = { WIRE_DOUBLE, WIRE_FLOAT, WIRE_FIXED16 };
+    for (int m = 0; m < 3; m++) {
+        Cell src[BH * STRIDE], want[BH * STRIDE], got[BH * STRIDE];
+        uint64_t bytes[WIRE_PHASE_COUNT];
+        fill_block(src);
+        memset(want, 0, sizeof(want));
+        memset(got, 0, sizeof(got));
+        ASSERT_TRUE(round_trip(modes[m], src, want) > 0);
+
+        pack_bytes_reset();
+        pack_set_quant(modes[m]);
+        pack_copy_cells(got, STRIDE, src, STRIDE, BH, BW);
+        pack_set_quant(WIRE_DOUBLE);
+        pack_bytes_get(bytes);
+        ASSERT_EQ(bytes[WIRE_PHASE_HALO], 0);
+        for (int i = 0; i < BH * STRIDE; i++) {
+            ASSERT_EQ(got[i].type, want[i].type);
+            ASSERT_TRUE(got[i].resource == want[i].resource);
+            ASSERT_TRUE(got[i].max_resource == want[i].max_resource);
+        }
+    }
+}
+
+TEST(byte_counters) {
+    uint64_t out[WIRE_PHASE_COUNT];
+    pack_bytes_reset();
+    pack_bytes_add(WIRE_PHASE_HALO, 100);
+    pack_bytes_add(WIRE_PHASE_HALO, 20);
+    pack_bytes_add(WIRE_PHASE_GATHER, 7);
+    pack_bytes_get(out);
+    ASSERT_EQ(out[WIRE_PHASE_HALO], 120);
+    ASSERT_EQ(out[WIRE_PHASE_MIGRATE], 0);
+    ASSERT_EQ(out[WIRE_PHASE_GATHER], 7);
+    pack_bytes_reset();
+}
+
+int suite_pack(void) {
+    printf("pack\n");
+    RUN_TEST(parse_quant_names);
+    RUN_TEST(cell_bytes_per_mode);
+    RUN_TEST(double_round_trip_is_exact);
+    RUN_TEST(float_round_trip_within_float_precision);
+    RUN_TEST(fixed16_round_trip_within_one_step);
+    RUN_TEST(copy_cells_equals_round_trip);
+    RUN_TEST(byte_counters);
+    SUITE_SUMMARY("pack");
+}
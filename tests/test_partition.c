@@ -0,0 +1,67 @@
+/*
+ * Partição (partition.c): grade global da escalabilidade fraca.
+ */
+#include "test_harness.h"
+#include "partition.h"
+
+#include <stdlib.h>
+
+/* Referência da fatoração de partition_init: size = a * b, a <= b,
+ * |a - b| mínimo; o fator maior vai para a dimensão com mais células. */
+static void reference_dims(int size, int global_w, int global_h,
+                           int *px, int *py) {
+    int a = 1, b = size;
+    for (int i = 1; i * i <= size; i++)
+        if (size % i == 0 && abs(i - size / i) < abs(a - b)) {
+            a = i;
+            b = size / i;
+        }
+    *px = (global_w >= global_h) ? b : a;
+    *py = (global_w >= global_h) ? a : b;
+}
+
+TEST(weak_dims_give_every_rank_the_same_block) {
+    static const int dims[][2] = {
+        { 64, 64 }, { 100, 40 }, { 40, 100 }, { 33, 17 }, { 1, 50 }
+    };
+    for (int d = 0; d < 5; d++)
+        for (int size = 1; size <= 64; size++) {
+            int lw = dims[d][0], lh = dims[d][1];
+            int gw, gh, px, py;
+            partition_weak_dims(size, lw, lh, &gw, &gh);
+            ASSERT_EQ((long)gw * gh, (long)size * lw * lh);
+            reference_dims(size, gw, gh, &px, &py);
+            ASSERT_EQ(px * py, size);
+            ASSERT_EQ(gw, px * lw);             /* sem resto na última coluna */
+            ASSERT_EQ(gh, py * lh);
+        }
+}
+
+TEST(weak_dims_single_rank_is_the_block) {
+    int gw, gh;
+    partition_weak_dims(1, 123, 45, &gw, &gh);
+    ASSERT_EQ(gw, 123);
+    ASSERT_EQ(gh, 45);
+}
+
+TEST(single_rank_partition_owns_everything) {
+    Partition p;
+    int lw, lh, ox, oy;
+    partition_init(&p, 30, 20, 0);
+    partition_subgrid_dims(&p, 30, 20, &lw, &lh, &ox, &oy);
+    ASSERT_EQ(lw, 30);
+    ASSERT_EQ(lh, 20);
+    ASSERT_EQ(ox, 0);
+    ASSERT_EQ(oy, 0);
+    for (int i = 0; i < 8; i++)
+        ASSERT_EQ(p.neighbors[i], -1);
+    partition_destroy(&p);
+}
+
+int suite_partition(void) {
+    printf("partition\n");
+    RUN_TEST(weak_dims_give_every_rank_the_same_block);
+    RUN_TEST(weak_dims_single_rank_is_the_block);
+    RUN_TEST(single_rank_partition_owns_everything);
+    SUITE_SUMMARY("partition");
+}
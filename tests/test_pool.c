@@ -0,0 +1,129 @@
+/*
+ * AgentPool (pool.c): layout SoA, bitmask de vivos e compactação.
+ */
+#include "test_harness.h"
+#include "pool.h"
+
+/* Pool com n agentes de id 100 + i nas posições (i, 2i). */
+static void fill_pool(AgentPool *pool, int n) {
+    pool_init(pool, 4);
+    for (int i = 0; i < n; i++)
+        pool_push(pool, 100 + (uint64_t)i, i, 2 * i, (float)i);
+}
+
+TEST(push_sets_alive_bits) {
+    AgentPool pool;
+    fill_pool(&pool, 130);              /* cruza duas palavras do bitmask */
+    ASSERT_EQ(pool.count, 130);
+    ASSERT_TRUE(pool.capacity >= 130);
+    ASSERT_EQ(pool_live(&pool), 130);
+    for (int i = 0; i < 130; i++)
+        ASSERT_TRUE(pool_alive(&pool, i));
+    ASSERT_EQ(pool.id[129], 229);
+    ASSERT_EQ(pool.x[64], 64);
+    ASSERT_EQ(pool.y[64], 128);
+    pool_destroy(&pool);
+}
+
+TEST(kill_clears_only_its_bit) {
+    AgentPool pool;
+    fill_pool(&pool, 70);
+    pool_kill(&pool, 0);
+    pool_kill(&pool, 63);
+    pool_kill(&pool, 64);
+    ASSERT_EQ(pool_live(&pool), 67);
+    ASSERT_TRUE(!pool_alive(&pool, 0));
+    ASSERT_TRUE(pool_alive(&pool, 1));
+    ASSERT_TRUE(pool_alive(&pool, 62));
+    ASSERT_TRUE(!pool_alive(&pool, 63));
+    ASSERT_TRUE(!pool_alive(&pool, 64));
+    ASSERT_TRUE(pool_alive(&pool, 65));
+    ASSERT_EQ(pool.count, 70);          /* slots mortos continuam ocupados */
+    pool_destroy(&pool);
+}
+
+TEST(reserve_keeps_bits_beyond_count_clear) {
+    AgentPool pool;
+    fill_pool(&pool, 10);
+    pool_reserve(&pool, 1000);
+    ASSERT_TRUE(pool.capacity >= 1000);
+    ASSERT_EQ(pool_live(&pool), 10);
+    for (int i = 10; i < 1000; i++)
+        ASSERT_TRUE(!pool_alive(&pool, i));
+    pool_destroy(&pool);
+}
+
+TEST(compact_is_stable) {
+    AgentPool pool;
+    fill_pool(&pool, 200);
+    for (int i = 0; i < 200; i += 3)
+        pool_kill(&pool, i);
+    int live = pool_live(&pool);
+    pool_compact(&pool);
+    ASSERT_EQ(pool.count, live);
+    ASSERT_EQ(pool_live(&pool), live);
+    /* Sobreviventes na ordem original, com os campos juntos. */
+    int k = 0;
+    for (int i = 0; i < 200; i++) {
+        if (i % 3 == 0) continue;
+        ASSERT_EQ(pool.id[k], 100 + (uint64_t)i);
+        ASSERT_EQ(pool.x[k], i);
+        ASSERT_NEAR(pool.energy[k], (float)i, 0.0);
+        k++;
+    }
+    ASSERT_TRUE(!pool_alive(&pool, live));
+    pool_destroy(&pool);
+}
+
+TEST(maybe_compact_waits_for_a_quarter_dead) {
+    AgentPool pool;
+    fill_pool(&pool, 100);
+    for (int i = 0; i < 24; i++)
+        pool_kill(&pool, i);
+    pool_maybe_compact(&pool);
+    ASSERT_EQ(pool.count, 100);         /* 24% mortos: fica */
+    pool_kill(&pool, 24);
+    pool_maybe_compact(&pool);
+    ASSERT_EQ(pool.count, 75);          /* 25%: compacta */
+    ASSERT_EQ(pool.id[0], 125);
+    pool_destroy(&pool);
+}
+
+TEST(revive_range_crosses_words) {
+    AgentPool pool;
+    pool_init(&pool, 4);
+    pool_reserve(&pool, 300);
+    pool_revive_range(&pool, 60, 200);
+    ASSERT_TRUE(!pool_alive(&pool, 59));
+    for (int i = 60; i < 200; i++)
+        ASSERT_TRUE(pool_alive(&pool, i));
+    ASSERT_TRUE(!pool_alive(&pool, 200));
+    pool.count = 300;
+    ASSERT_EQ(pool_live(&pool), 140);
+    pool_destroy(&pool);
+}
+
+TEST(revive_range_inside_one_word) {
+    AgentPool pool;
+    pool_init(&pool, 128);
+    pool_revive_range(&pool, 3, 7);
+    pool_revive_range(&pool, 64, 64);   /* vazio */
+    pool.count = 128;
+    ASSERT_EQ(pool_live(&pool), 4);
+    ASSERT_TRUE(pool_alive(&pool, 3));
+    ASSERT_TRUE(pool_alive(&pool, 6));
+    ASSERT_TRUE(!pool_alive(&pool, 7));
+    pool_destroy(&pool);
+}
+
+int suite_pool(void) {
+    printf("pool\n");
+    RUN_TEST(push_sets_alive_bits);
+    RUN_TEST(kill_clears_only_its_bit);
+    RUN_TEST(reserve_keeps_bits_beyond_count_clear);
+    RUN_TEST(compact_is_stable);
+    RUN_TEST(maybe_compact_waits_for_a_quarter_dead);
+    RUN_TEST(revive_range_crosses_words);
+    RUN_TEST(revive_range_inside_one_word);
+    SUITE_SUMMARY("pool");
+}
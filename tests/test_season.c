@@ -0,0 +1,92 @@
+/*
+ * Estações (season.c): calendário --seasons e planos de acessibilidade
+ * do SubGrid (grid.c).
+ */
+#include "test_harness.h"
+#include "config.h"
+#include "grid.h"
+#include "partition.h"
+#include "season.h"
+
+static void restore_default(void) {
+    season_schedule_set("dry,wet", DEFAULT_SEASON_LENGTH);
+}
+
+TEST(default_schedule_alternates) {
+    restore_default();
+    ASSERT_EQ(season_for_cycle(0), DRY);
+    ASSERT_EQ(season_for_cycle(DEFAULT_SEASON_LENGTH - 1), DRY);
+    ASSERT_EQ(season_for_cycle(DEFAULT_SEASON_LENGTH), WET);
+    ASSERT_EQ(season_for_cycle(2 * DEFAULT_SEASON_LENGTH), DRY);
+}
+
+TEST(schedule_with_lengths_repeats) {
+    ASSERT_EQ(season_schedule_set("rising:5,wet:10,falling:5,dry:10", 7), 0);
+    ASSERT_EQ(season_for_cycle(0), RISING);
+    ASSERT_EQ(season_for_cycle(4), RISING);
+    ASSERT_EQ(season_for_cycle(5), WET);
+    ASSERT_EQ(season_for_cycle(14), WET);
+    ASSERT_EQ(season_for_cycle(15), FALLING);
+    ASSERT_EQ(season_for_cycle(20), DRY);
+    ASSERT_EQ(season_for_cycle(29), DRY);
+    ASSERT_EQ(season_for_cycle(30), RISING);       /* período de 30 */
+    ASSERT_EQ(season_for_cycle(65), WET);
+    restore_default();
+}
+
+TEST(schedule_default_length) {
+    ASSERT_EQ(season_schedule_set("wet,dry:2", 3), 0);
+    ASSERT_EQ(season_for_cycle(2), WET);
+    ASSERT_EQ(season_for_cycle(3), DRY);
+    ASSERT_EQ(season_for_cycle(5), WET);
+    restore_default();
+}
+
+TEST(invalid_schedule_keeps_current) {
+    ASSERT_EQ(season_schedule_set("wet:4,dry:4", 1), 0);
+    ASSERT_EQ(season_schedule_set("wet,monsoon", 5), -1);
+    ASSERT_EQ(season_schedule_set("wet:0", 5), -1);
+    ASSERT_EQ(season_schedule_set("", 5), -1);
+    ASSERT_EQ(season_schedule_set("dry", 0), -1);
+    ASSERT_EQ(season_schedule_set(
+        "dry,wet,dry,wet,dry,wet,dry,wet,dry,wet,dry,wet,dry,wet,dry,wet,dry",
+        1), -1);                                   /* > SEASON_MAX_ENTRIES */
+    ASSERT_EQ(season_for_cycle(0), WET);
+    ASSERT_EQ(season_for_cycle(4), DRY);
+    restore_default();
+}
+
+TEST(names_round_trip) {
+    for (int s = 0; s < SEASON_COUNT; s++)
+        ASSERT_EQ(season_parse(season_name((Season)s)), s);
+    ASSERT_EQ(season_parse("summer"), -1);
+}
+
+/* Cada plano de bits deve reproduzir season_accessibility célula a
+ * célula, halo incluído; a virada só troca o ponteiro. */
+TEST(access_planes_match_table) {
+    Partition p;
+    SubGrid sg;
+    partition_init(&p, 37, 29, 0);
+    subgrid_create(&sg, &p, 37, 29, 2);
+    subgrid_init(&sg, &p, 7);
+    for (int s = 0; s < SEASON_COUNT; s++) {
+        subgrid_set_season(&sg, (Season)s);
+        for (int idx = 0; idx < sg.halo_w * sg.halo_h; idx++)
+            ASSERT_EQ(subgrid_accessible(&sg, idx),
+                      season_accessibility(sg.cells[idx].type, (Season)s));
+    }
+    subgrid_destroy(&sg);
+    partition_destroy(&p);
+}
+
+int suite_season(void) {
+    printf("season\n");
+    RUN_TEST(default_schedule_alternates);
+    RUN_TEST(schedule_with_lengths_repeats);
+    RUN_TEST(schedule_default_length);
+    RUN_TEST(invalid_schedule_keeps_current);
+    RUN_TEST(names_round_trip);
+    RUN_TEST(access_planes_match_table);
+    SUITE_SUMMARY("season");
+}
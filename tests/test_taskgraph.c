@@ -0,0 +1,120 @@
+/*
+ * Grafo de tarefas por tile (taskgraph.c): mesmo resultado do laço por
+ * fases, para qualquer tile e número de threads.
+ */
+#include "test_harness.h"
+#include "agent.h"
+#include "arena.h"
+#include "config.h"
+#include "grid.h"
+#include "partition.h"
+#include "pool.h"
+#include "season.h"
+#include "taskgraph.h"
+
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TG_W 40
+#define TG_H 30
+#define TG_CYCLES 6
+
+typedef struct {
+    Partition p;
+    SubGrid   sg;
+    AgentPool pool;
+    Arena     arena;
+} World;
+
+static void world_init(World *w, const SimConfig *cfg) {
+    partition_init(&w->p, TG_W, TG_H, 0);
+    subgrid_create(&w->sg, &w->p, TG_W, TG_H, 1);
+    subgrid_init(&w->sg, &w->p, cfg->seed);
+    arena_init(&w->arena, 1 << 16);
+    pool_init(&w->pool, 64);
+    agents_init(&w->pool, cfg->num_agents, &w->sg, &w->p, TG_W, TG_H,
+                cfg->initial_energy, cfg->seed);
+}
+
+static void world_destroy(World *w) {
+    pool_destroy(&w->pool);
+    arena_destroy(&w->arena);
+    subgrid_destroy(&w->sg);
+    partition_destroy(&w->p);
+}
+
+/* TG_CYCLES ciclos locais (sem halos nem migração: um só rank). */
+static void world_run(World *w, const SimConfig *cfg, int tasks) {
+    for (int cycle = 0; cycle < TG_CYCLES; cycle++) {
+        arena_reset(&w->arena);
+        Season season = season_for_cycle(cycle);
+        subgrid_set_season(&w->sg, season);
+        uint64_t *kid;
+        if (tasks) {
+            kid = taskgraph_step(&w->pool, &w->sg, season, cfg, cycle,
+                                 &w->arena);
+        } else {
+            agents_workload(&w->pool, &w->sg, cfg->max_workload, NULL);
+            kid = agents_decide_all(&w->pool, &w->sg, cfg->seed, cycle,
+                                    cfg->energy_gain, cfg->energy_loss,
+                                    &w->arena);
+        }
+        agents_reproduce(&w->pool, kid, cfg->reproduce_threshold,
+                         cfg->reproduce_cost, &w->arena);
+        if (!tasks)
+            subgrid_update(&w->sg, season, NULL);
+        pool_maybe_compact(&w->pool);
+    }
+}
+
+TEST(tasks_match_phased_loop) {
+    SimConfig cfg = SIM_CONFIG_DEFAULTS;
+    cfg.num_agents          = 600;
+    cfg.max_workload        = 20;
+    cfg.reproduce_threshold = 1.0;
+    cfg.reproduce_cost      = 0.3;
+    ASSERT_EQ(agent_ids_init(TG_CYCLES, TG_W, TG_H), 0);
+
+    World ref;
+    world_init(&ref, &cfg);
+    world_run(&ref, &cfg, 0);
+    ASSERT_TRUE(ref.pool.count > 0);
+
+    int tiles[]   = { 3, 8, 16, 64 };
+    int threads[] = { 1, 3 };
+    for (int ti = 0; ti < 4; ti++)
+        for (int th = 0; th < 2; th++) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads[th]);
+#endif
+            World w;
+            cfg.tile_size = tiles[ti];
+            world_init(&w, &cfg);
+            world_run(&w, &cfg, 1);
+
+            ASSERT_EQ(w.pool.count, ref.pool.count);
+            for (int i = 0; i < ref.pool.count; i++) {
+                ASSERT_EQ(w.pool.id[i], ref.pool.id[i]);
+                ASSERT_EQ(w.pool.x[i], ref.pool.x[i]);
+                ASSERT_EQ(w.pool.y[i], ref.pool.y[i]);
+                ASSERT_EQ(pool_alive(&w.pool, i), pool_alive(&ref.pool, i));
+                ASSERT_TRUE(w.pool.energy[i] == ref.pool.energy[i]);
+            }
+            for (int k = 0; k < ref.sg.halo_w * ref.sg.halo_h; k++)
+                ASSERT_TRUE(w.sg.cells[k].resource == ref.sg.cells[k].resource);
+            world_destroy(&w);
+        }
+    world_destroy(&ref);
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+}
+
+int suite_taskgraph(void) {
+    printf("taskgraph\n");
+    RUN_TEST(tasks_match_phased_loop);
+    SUITE_SUMMARY("taskgraph");
+}
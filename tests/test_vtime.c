@@ -0,0 +1,87 @@
+/*
+ * Tempo virtual (vtime.c): max(W / T, m) × ns por iteração.
+ */
+#include "test_harness.h"
+#include "vtime.h"
+#include "workload.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int team_size(void) {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+TEST(take_is_bounded_by_largest_charge) {
+    double iters;
+    vtime_init(2.0, 4);
+    vtime_charge(100);
+    vtime_charge(300);
+    vtime_charge(50);
+    /* W = 450, W / 4 = 112.5 < m = 300. */
+    ASSERT_NEAR(vtime_take(&iters), 300 * 2.0e-9, 1e-15);
+    ASSERT_NEAR(iters, 450.0, 0.0);
+    vtime_shutdown();
+}
+
+TEST(take_is_bounded_by_even_split) {
+    double iters;
+    vtime_init(2.0, 4);
+    for (int k = 0; k < 10; k++)
+        vtime_charge(100);
+    /* W = 1000, W / 4 = 250 > m = 100. */
+    ASSERT_NEAR(vtime_take(&iters), 250 * 2.0e-9, 1e-15);
+    /* Acumuladores zerados pela chamada anterior. */
+    ASSERT_NEAR(vtime_take(&iters), 0.0, 0.0);
+    ASSERT_NEAR(iters, 0.0, 0.0);
+    vtime_shutdown();
+}
+
+TEST(charges_from_all_threads_are_summed) {
+    double iters;
+    int team = 1;
+#ifdef _OPENMP
+    omp_set_num_threads(4);
+#endif
+    vtime_init(1.0, 2);
+    #pragma omp parallel
+    {
+        #pragma omp single
+        team = team_size();
+        for (int k = 0; k < 20; k++)
+            vtime_charge(100);
+    }
+    /* 2000 por thread real, modelo de 2 threads: W / 2. */
+    double t = vtime_take(&iters);
+    ASSERT_NEAR(iters, 2000.0 * team, 0.0);
+    ASSERT_NEAR(t, 1000.0 * team * 1e-9, 1e-15);
+    vtime_shutdown();
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+}
+
+TEST(workload_compute_only_charges) {
+    double iters;
+    vtime_init(1.0, 1);
+    ASSERT_NEAR(workload_compute(0.5, 1000), 0.0, 0.0);
+    ASSERT_NEAR(workload_compute(0.25, 1000), 0.0, 0.0);
+    vtime_take(&iters);
+    ASSERT_NEAR(iters, 750.0, 0.0);
+    vtime_shutdown();
+    ASSERT_EQ(vtime_enabled, 0);
+}
+
+int suite_vtime(void) {
+    printf("vtime\n");
+    RUN_TEST(take_is_bounded_by_largest_charge);
+    RUN_TEST(take_is_bounded_by_even_split);
+    RUN_TEST(charges_from_all_threads_are_summed);
+    RUN_TEST(workload_compute_only_charges);
+    SUITE_SUMMARY("vtime");
+}
@@ -0,0 +1,66 @@
+/*
+ * Perfis da carga sintética (workload.c), cobrados em tempo virtual
+ * para observar as iterações sem executá-las.
+ */
+#include "test_harness.h"
+#include "vtime.h"
+#include "workload.h"
+
+TEST(profile_names_round_trip) {
+    for (int p = 0; p < WL_PROFILE_COUNT; p++)
+        ASSERT_EQ(workload_parse_profile(workload_profile_name((WorkloadProfile)p)), p);
+    ASSERT_EQ(workload_parse_profile("compute"), WL_COMPUTE);
+    ASSERT_EQ(workload_parse_profile("stochastic"), WL_STOCHASTIC);
+    ASSERT_EQ(workload_parse_profile("io"), -1);
+}
+
+TEST(compute_charges_nominal_iterations) {
+    double iters;
+    workload_set_profile(WL_COMPUTE);
+    ASSERT_NEAR(workload_profile_scale(), 1.0, 0.0);
+    vtime_init(1.0, 1);
+    workload_compute(0.3, 1000);
+    workload_compute(1.0, 1000);
+    vtime_take(&iters);
+    ASSERT_NEAR(iters, 1300.0, 0.0);
+    vtime_shutdown();
+}
+
+/* Nominal × Exp(1), com teto de 16×: a média fica na nominal. */
+TEST(stochastic_keeps_nominal_mean) {
+    enum { N = 20000 };
+    double iters, sum = 0.0;
+    int    over = 0;
+    workload_set_profile(WL_STOCHASTIC);
+    vtime_init(1.0, 1);
+    for (int k = 0; k < N; k++) {
+        workload_compute(1.0, 1000);
+        vtime_take(&iters);
+        sum += iters;
+        over += iters > 16000.0;
+    }
+    ASSERT_NEAR(sum / N, 1000.0, 30.0);
+    ASSERT_EQ(over, 0);
+    workload_compute(0.0, 1000);                /* custo nominal 0 */
+    vtime_take(&iters);
+    ASSERT_NEAR(iters, 0.0, 0.0);
+    vtime_shutdown();
+    workload_shutdown();
+}
+
+TEST(memory_profile_is_calibrated) {
+    workload_set_profile(WL_MEMORY);
+    double s = workload_profile_scale();
+    ASSERT_TRUE(s > 0.0 && isfinite(s));
+    workload_shutdown();
+    ASSERT_NEAR(workload_profile_scale(), 1.0, 0.0);
+}
+
+int suite_workload(void) {
+    printf("workload\n");
+    RUN_TEST(profile_names_round_trip);
+    RUN_TEST(compute_charges_nominal_iterations);
+    RUN_TEST(stochastic_keeps_nominal_mean);
+    RUN_TEST(memory_profile_is_calibrated);
+    SUITE_SUMMARY("workload");
+}